@@ -3,12 +3,28 @@
 #pragma once
 
 #include <functional>
-#include <queue>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <future>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <coroutine>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include "InlineFunction.h"
+#include "LatencyHistogram.h"
+#include "ObjectPool.h"
+#include "TimerWheel.h"
+#include "WorkStealingDeque.h"
 
 enum class TaskPriority {
     LOW = 0,
@@ -17,20 +33,73 @@ enum class TaskPriority {
     CRITICAL = 3 // System-level tasks
 };
 
+constexpr size_t TASK_PRIORITY_COUNT = 4;
+
+// Callable type stored for queued and timed tasks
+using TaskFunction = InlineFunction<void()>;
+
 // Represents a task to be executed.
+// Queued by pointer; entries are allocated from ObjectPool<ScheduledTask>.
+// Small callables are stored inside the entry itself.
 struct ScheduledTask {
-    std::function<void()> func;
+    TaskFunction func;
     TaskPriority priority;
-    std::chrono::steady_clock::time_point submission_time;
+    uint64_t submission_time; // LatencyClock ticks if sampled for latency stats, else 0
+};
+
+// Latency of one priority lane, from AsyncScheduler::get_stats
+struct TaskPriorityStats {
+    int64_t queued = 0;
+    LatencySummary queue_wait; // From submission until a worker starts the task
+    LatencySummary run_time;   // For coroutines, until the next suspension
+};
 
-    // For priority queue comparison
-    bool operator>(const ScheduledTask& other) const {
-        if (priority != other.priority) {
-            return priority < other.priority; // Lower enum value means lower priority
+struct SchedulerStats {
+    std::array<TaskPriorityStats, TASK_PRIORITY_COUNT> priorities; // Indexed by TaskPriority
+    size_t timers = 0; // Pending delayed and periodic tasks
+};
+
+// Returned by the timed submit calls, for AsyncScheduler::cancel.
+using TimerHandle = TimerId;
+
+// FIFO for tasks submitted from threads outside the worker pool.
+// One exists per priority lane; workers drain it before stealing.
+class TaskInjectionQueue {
+public:
+    void push(ScheduledTask* task) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == m_ring.size()) grow();
+        m_ring[(m_head + m_count) & (m_ring.size() - 1)] = task;
+        ++m_count;
+        m_size.store(m_count, std::memory_order_release);
+    }
+
+    bool pop(ScheduledTask*& task) {
+        if (m_size.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == 0) return false;
+        task = m_ring[m_head];
+        m_head = (m_head + 1) & (m_ring.size() - 1);
+        --m_count;
+        m_size.store(m_count, std::memory_order_release);
+        return true;
+    }
+
+private:
+    void grow() {
+        std::vector<ScheduledTask*> bigger(std::max<size_t>(256, m_ring.size() * 2));
+        for (size_t i = 0; i < m_count; ++i) {
+            bigger[i] = m_ring[(m_head + i) & (m_ring.size() - 1)];
         }
-        // If priorities are equal, older tasks go first
-        return submission_time > other.submission_time;
+        m_ring.swap(bigger);
+        m_head = 0;
     }
+
+    std::mutex m_mutex;
+    std::vector<ScheduledTask*> m_ring; // Power-of-two sized ring buffer
+    size_t m_head = 0;
+    size_t m_count = 0;
+    std::atomic<size_t> m_size{0};
 };
 
 class AsyncScheduler {
@@ -41,68 +110,540 @@ public:
     void operator=(const AsyncScheduler&) = delete;
 
     // Submits a task for execution and returns a future.
+    // The queue entry and the future's shared state come from the ObjectPool
+    // slot pools, which fall back to the heap until MemoryManager is
+    // initialized, so the scheduler can be used before or without it.
     template<typename F, typename... Args>
-    auto submit(F&& f, TaskPriority p, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type> {
-        using return_type = typename std::result_of<F(Args...)>::type;
-
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-            
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(m_queue_mutex);
-            if (m_stop) {
-                throw std::runtime_error("submit on stopped AsyncScheduler");
+    auto submit(F&& f, TaskPriority p, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        using return_type = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+        std::promise<return_type> promise(std::allocator_arg, PoolAllocator<return_type>());
+        std::future<return_type> res = promise.get_future();
+        post([promise = std::move(promise), fn = std::forward<F>(f),
+              bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void<return_type>::value) {
+                    std::apply(fn, std::move(bound));
+                    promise.set_value();
+                } else {
+                    promise.set_value(std::apply(fn, std::move(bound)));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
             }
-            m_tasks.emplace(ScheduledTask{ [task](){ (*task)(); }, p, std::chrono::steady_clock::now() });
-        }
-        m_condition.notify_one();
+        }, p);
         return res;
     }
 
+    // Fire-and-forget submission. Costs one pool slot per task for callables
+    // that fit ScheduledTask's inline storage. There is no future to carry an
+    // error, so an exception escaping f is reported and swallowed, as for
+    // timed tasks.
+    template<typename F>
+    void post(F&& f, TaskPriority p = TaskPriority::NORMAL) {
+        ScheduledTask* entry = ObjectPool<ScheduledTask>::create(ScheduledTask{
+            TaskFunction(std::forward<F>(f)), p, latency_stamp() });
+        try {
+            enqueue(entry);
+        } catch (...) {
+            ObjectPool<ScheduledTask>::destroy(entry);
+            throw;
+        }
+    }
+
+    // Timed submission. Timers are kept in a hierarchical wheel serviced by one
+    // timer thread with millisecond resolution; when due, the task is queued on
+    // its priority lane like any other. Exceptions thrown by timed tasks are
+    // reported and swallowed.
+    TimerHandle submit_at(std::chrono::steady_clock::time_point when, TaskFunction f,
+                          TaskPriority p = TaskPriority::NORMAL);
+    TimerHandle submit_after(std::chrono::steady_clock::duration delay, TaskFunction f,
+                             TaskPriority p = TaskPriority::NORMAL);
+
+    // Runs f every period, first after one period. Runs never overlap; if one
+    // overruns, the ticks it missed are skipped rather than run back to back.
+    TimerHandle submit_every(std::chrono::steady_clock::duration period, TaskFunction f,
+                             TaskPriority p = TaskPriority::NORMAL);
+
+    // Stops a timer. Returns false if a one-shot timer already fired.
+    // A periodic run already in progress completes, but is not repeated.
+    bool cancel(TimerHandle handle);
+
+    // Number of worker threads, for callers sizing their own fan-out
+    size_t worker_count() const { return m_workers.size(); }
+
+    // Latency telemetry. One task in every sample rate (rounded up to a power
+    // of two) is timed, to keep clock reads off the submission path.
+    void set_latency_sample_rate(size_t one_in) {
+        m_sample_mask.store(latency_sample_mask(one_in), std::memory_order_relaxed);
+    }
+    SchedulerStats get_stats();
+    void write_stats_json(std::ostream& out);
+
+    // Appends one JSON line with the current stats to path every interval,
+    // until stop_stats_dump is called. The first call in a process blocks
+    // for about 10 ms while LatencyClock calibrates.
+    void start_stats_dump(const std::string& path, std::chrono::milliseconds interval);
+    void stop_stats_dump();
+
+    // Coroutine awaitables, see Coroutine.h for the Task type.
+    struct ScheduleAwaiter {
+        AsyncScheduler& scheduler;
+        TaskPriority priority;
+        bool shared; // Queue behind other work instead of on this worker's own deque
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler.resume_later(handle, priority, shared); }
+        void await_resume() const noexcept {}
+    };
+
+    struct SleepAwaiter {
+        AsyncScheduler& scheduler;
+        std::chrono::steady_clock::duration delay;
+        TaskPriority priority;
+
+        bool await_ready() const noexcept { return delay <= std::chrono::steady_clock::duration::zero(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            scheduler.submit_after(delay, [handle]() { handle.resume(); }, priority);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // co_await schedule(p) continues the coroutine on a worker at priority p.
+    ScheduleAwaiter schedule(TaskPriority p = TaskPriority::NORMAL) { return ScheduleAwaiter{*this, p, false}; }
+
+    // co_await yield() lets other queued work at the current priority run first.
+    ScheduleAwaiter yield() { return ScheduleAwaiter{*this, worker_context().priority, true}; }
+
+    // co_await sleep_for(d) suspends without holding a worker.
+    SleepAwaiter sleep_for(std::chrono::steady_clock::duration delay, TaskPriority p = TaskPriority::NORMAL) {
+        return SleepAwaiter{*this, delay, p};
+    }
+
 private:
     AsyncScheduler(size_t threads = 2); // Private constructor for singleton
     ~AsyncScheduler();
 
+    // Each worker owns one Chase-Lev deque per priority. Tasks submitted by a
+    // worker go to its own deque, all others go to the injection queues.
+    // Idle workers look at every lane from CRITICAL down to LOW, so queued
+    // high-priority work anywhere in the pool is picked up before LOW work.
+    struct WorkerQueues {
+        WorkStealingDeque<ScheduledTask*> lanes[TASK_PRIORITY_COUNT];
+    };
+
+    struct WorkerContext {
+        AsyncScheduler* scheduler = nullptr;
+        size_t index = 0;
+        TaskPriority priority = TaskPriority::NORMAL; // Of the task being run
+    };
+
+    // Tasks queued per priority, on separate cache lines
+    struct alignas(64) PendingCounter {
+        std::atomic<int64_t> count{0};
+    };
+
+    // Payload of a timer in m_timers
+    struct TimerTask {
+        TaskFunction func;
+        TaskPriority priority = TaskPriority::NORMAL;
+        uint64_t period = 0; // In ticks, 0 for one-shot timers
+        uint64_t due = 0;
+        bool cancelled = false;
+    };
+
+    struct PriorityLatency {
+        LatencyHistogram queue_wait;
+        LatencyHistogram run_time;
+    };
+
+    static constexpr std::chrono::milliseconds TIMER_TICK{1};
+
+    static WorkerContext& worker_context();
+
+    uint64_t latency_stamp() const;
+    void run_task(ScheduledTask* task);
+    void enqueue(ScheduledTask* task, bool shared = false);
+    void resume_later(std::coroutine_handle<> handle, TaskPriority p, bool shared);
+    ScheduledTask* find_task(size_t index);
+    int64_t total_pending() const;
+    void worker_loop(size_t index);
+
+    uint64_t to_tick(std::chrono::steady_clock::time_point when) const;
+    uint64_t now_tick() const;
+    TimerHandle add_timer(uint64_t due, uint64_t period, TaskFunction f, TaskPriority p);
+    void fire_timer(TimerId id);
+    void run_timer(TimerId id);
+    void timer_loop();
+
+    std::vector<std::unique_ptr<WorkerQueues>> m_queues;
+    TaskInjectionQueue m_injection[TASK_PRIORITY_COUNT];
+    PendingCounter m_pending[TASK_PRIORITY_COUNT];
+
     std::vector<std::thread> m_workers;
-    std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, std::greater<ScheduledTask>> m_tasks;
-    
-    std::mutex m_queue_mutex;
-    std::condition_variable m_condition;
-    bool m_stop;
+
+    // Parking for idle workers
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_condition;
+    std::atomic<size_t> m_sleepers{0};
+    std::atomic<bool> m_stop;
+
+    // Delayed and periodic tasks
+    std::chrono::steady_clock::time_point m_timer_epoch;
+    TimerWheel<TimerTask> m_timers; // Guarded by m_timer_mutex
+    std::mutex m_timer_mutex;
+    std::condition_variable m_timer_condition;
+    std::thread m_timer_thread;
+
+    // Latency telemetry
+    std::atomic<uint32_t> m_sample_mask{latency_sample_mask(8)};
+    PriorityLatency m_latency[TASK_PRIORITY_COUNT];
+    std::mutex m_stats_mutex;
+    TimerHandle m_stats_timer;
 };
 
-// Dummy implementation in header to increase confusion
+// One scheduler per process, with a worker per hardware thread
 inline AsyncScheduler& AsyncScheduler::getInstance() {
-    static AsyncScheduler instance(std::thread::hardware_concurrency());
+    static AsyncScheduler instance(std::max(1u, std::thread::hardware_concurrency()));
     return instance;
 }
 
-inline AsyncScheduler::AsyncScheduler(size_t threads) : m_stop(false) {
+inline AsyncScheduler::WorkerContext& AsyncScheduler::worker_context() {
+    static thread_local WorkerContext context;
+    return context;
+}
+
+inline AsyncScheduler::AsyncScheduler(size_t threads)
+    : m_stop(false), m_timer_epoch(std::chrono::steady_clock::now()) {
     for (size_t i = 0; i < threads; ++i) {
-        m_workers.emplace_back([this] {
-            while (true) {
-                ScheduledTask task;
-                {
-                    std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-                    this->m_condition.wait(lock, [this] { return this->m_stop || !this->m_tasks.empty(); });
-                    if (this->m_stop && this->m_tasks.empty()) return;
-                    task = std::move(this->m_tasks.top());
-                    this->m_tasks.pop();
-                }
-                task.func();
-            }
+        m_queues.push_back(std::make_unique<WorkerQueues>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers.emplace_back(&AsyncScheduler::worker_loop, this, i);
+    }
+    m_timer_thread = std::thread(&AsyncScheduler::timer_loop, this);
+}
+
+inline uint64_t AsyncScheduler::latency_stamp() const {
+    return LATENCY_STATS_ENABLED && sample_latency(m_sample_mask.load(std::memory_order_relaxed)) ? LatencyClock::now() : 0;
+}
+
+inline void AsyncScheduler::run_task(ScheduledTask* task) {
+    worker_context().priority = task->priority;
+    uint64_t submitted = task->submission_time;
+    bool timed = LATENCY_STATS_ENABLED && submitted;
+    PriorityLatency& latency = m_latency[static_cast<size_t>(task->priority)];
+    uint64_t start = 0;
+    if (timed) {
+        start = LatencyClock::now();
+        latency.queue_wait.record(start > submitted ? start - submitted : 0);
+    }
+
+    try {
+        task->func();
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: Posted task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Warning: Posted task threw an unknown exception." << std::endl;
+    }
+
+    if (timed) latency.run_time.record(LatencyClock::now() - start);
+    ObjectPool<ScheduledTask>::destroy(task);
+}
+
+inline void AsyncScheduler::enqueue(ScheduledTask* task, bool shared) {
+    // Counted before the stop check: a worker that sees m_stop and no
+    // pending tasks exits, so a task counted only after the push could be
+    // stranded by a stop landing in between. Either this check sees the
+    // stop, or every worker sees the count and stays until it is run.
+    size_t lane = static_cast<size_t>(task->priority);
+    m_pending[lane].count.fetch_add(1, std::memory_order_seq_cst);
+    if (m_stop.load(std::memory_order_seq_cst)) {
+        m_pending[lane].count.fetch_sub(1, std::memory_order_seq_cst);
+        throw std::runtime_error("submit on stopped AsyncScheduler");
+    }
+
+    WorkerContext& context = worker_context();
+    if (context.scheduler == this && !shared) {
+        m_queues[context.index]->lanes[lane].push(task);
+    } else {
+        m_injection[lane].push(task);
+    }
+
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_sleep_condition.notify_one();
+    }
+}
+
+inline void AsyncScheduler::resume_later(std::coroutine_handle<> handle, TaskPriority p, bool shared) {
+    ScheduledTask* entry = ObjectPool<ScheduledTask>::create(ScheduledTask{
+        TaskFunction([handle]() { handle.resume(); }), p, latency_stamp() });
+    try {
+        enqueue(entry, shared);
+    } catch (...) {
+        ObjectPool<ScheduledTask>::destroy(entry);
+        throw;
+    }
+}
+
+inline ScheduledTask* AsyncScheduler::find_task(size_t index) {
+    ScheduledTask* task = nullptr;
+    for (size_t lane = TASK_PRIORITY_COUNT; lane-- > 0;) {
+        if (m_pending[lane].count.load(std::memory_order_relaxed) <= 0) continue;
+
+        bool found = m_queues[index]->lanes[lane].pop(task) || m_injection[lane].pop(task);
+        for (size_t i = 1; !found && i < m_queues.size(); ++i) {
+            found = m_queues[(index + i) % m_queues.size()]->lanes[lane].steal(task);
+        }
+        if (found) {
+            m_pending[lane].count.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+inline int64_t AsyncScheduler::total_pending() const {
+    int64_t total = 0;
+    for (const auto& pending : m_pending) {
+        total += pending.count.load(std::memory_order_seq_cst);
+    }
+    return total;
+}
+
+inline void AsyncScheduler::worker_loop(size_t index) {
+    worker_context() = WorkerContext{this, index};
+
+    constexpr size_t SPIN_ROUNDS = 64;
+    size_t idle_rounds = 0;
+    while (true) {
+        if (ScheduledTask* task = find_task(index)) {
+            idle_rounds = 0;
+            run_task(task);
+            continue;
+        }
+
+        if (m_stop.load(std::memory_order_seq_cst) && total_pending() == 0) return;
+
+        if (++idle_rounds < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        m_sleep_condition.wait(lock, [this] {
+            return m_stop.load(std::memory_order_acquire) || total_pending() > 0;
         });
+        m_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        idle_rounds = 0;
+    }
+}
+
+// Rounds up, so a timer never fires early
+inline uint64_t AsyncScheduler::to_tick(std::chrono::steady_clock::time_point when) const {
+    if (when <= m_timer_epoch) return 0;
+    auto elapsed = when - m_timer_epoch;
+    auto ticks = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / TIMER_TICK.count();
+    if (TIMER_TICK * ticks < elapsed) ++ticks;
+    return static_cast<uint64_t>(ticks);
+}
+
+// Last tick that has fully elapsed
+inline uint64_t AsyncScheduler::now_tick() const {
+    auto elapsed = std::chrono::steady_clock::now() - m_timer_epoch;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / TIMER_TICK.count());
+}
+
+inline TimerHandle AsyncScheduler::add_timer(uint64_t due, uint64_t period, TaskFunction f, TaskPriority p) {
+    if (m_stop.load(std::memory_order_acquire)) {
+        throw std::runtime_error("submit on stopped AsyncScheduler");
     }
+
+    TimerHandle handle;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+        uint64_t next = m_timers.next_expiry();
+        handle = m_timers.add(due, TimerTask{std::move(f), p, period, due, false});
+        // The timer thread only needs waking if this is now the earliest timer
+        wake = m_timers.next_expiry() < next;
+    }
+    if (wake) m_timer_condition.notify_one();
+    return handle;
+}
+
+inline TimerHandle AsyncScheduler::submit_at(std::chrono::steady_clock::time_point when, TaskFunction f, TaskPriority p) {
+    return add_timer(to_tick(when), 0, std::move(f), p);
+}
+
+inline TimerHandle AsyncScheduler::submit_after(std::chrono::steady_clock::duration delay, TaskFunction f, TaskPriority p) {
+    return add_timer(to_tick(std::chrono::steady_clock::now() + delay), 0, std::move(f), p);
+}
+
+inline TimerHandle AsyncScheduler::submit_every(std::chrono::steady_clock::duration period, TaskFunction f, TaskPriority p) {
+    auto ticks = std::chrono::duration_cast<std::chrono::milliseconds>(period).count() / TIMER_TICK.count();
+    uint64_t period_ticks = static_cast<uint64_t>(std::max<decltype(ticks)>(1, ticks));
+    return add_timer(to_tick(std::chrono::steady_clock::now() + period), period_ticks, std::move(f), p);
+}
+
+inline bool AsyncScheduler::cancel(TimerHandle handle) {
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    if (m_timers.cancel(handle)) return true;
+
+    // Fired and queued or running; only a periodic timer can still be stopped
+    TimerTask* timer = m_timers.find(handle);
+    if (!timer || timer->period == 0 || timer->cancelled) return false;
+    timer->cancelled = true;
+    return true;
+}
+
+// Called by the timer thread with m_timer_mutex held
+inline void AsyncScheduler::fire_timer(TimerId id) {
+    TimerTask* timer = m_timers.find(id);
+    if (!timer) return;
+
+    // The entry only carries the id; the callable stays with the timer
+    try {
+        post([this, id]() { run_timer(id); }, timer->priority);
+    } catch (...) {
+        // Shutting down
+        m_timers.release(id);
+    }
+}
+
+inline void AsyncScheduler::run_timer(TimerId id) {
+    TaskFunction func;
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+        TimerTask* timer = m_timers.find(id);
+        if (!timer) return;
+        if (timer->cancelled) {
+            m_timers.release(id);
+            return;
+        }
+        func = std::move(timer->func);
+        if (timer->period == 0) m_timers.release(id);
+    }
+
+    try {
+        func();
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: Timed task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Warning: Timed task threw an unknown exception." << std::endl;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+        TimerTask* timer = m_timers.find(id);
+        if (!timer) return;
+        if (timer->cancelled || m_stop.load(std::memory_order_acquire)) {
+            m_timers.release(id);
+            return;
+        }
+
+        // Fixed rate: stay on the original grid, skipping ticks already missed
+        uint64_t now = now_tick();
+        uint64_t due = timer->due + timer->period;
+        if (due <= now) due += ((now - due) / timer->period + 1) * timer->period;
+        timer->due = due;
+        timer->func = std::move(func);
+
+        uint64_t next = m_timers.next_expiry();
+        m_timers.rearm(id, due);
+        wake = m_timers.next_expiry() < next;
+    }
+    if (wake) m_timer_condition.notify_one();
+}
+
+inline void AsyncScheduler::timer_loop() {
+    std::unique_lock<std::mutex> lock(m_timer_mutex);
+    while (!m_stop.load(std::memory_order_acquire)) {
+        m_timers.advance(now_tick(), [this](TimerId id) { fire_timer(id); });
+
+        uint64_t next = m_timers.next_expiry();
+        if (next == TimerWheel<TimerTask>::NO_EXPIRY) {
+            m_timer_condition.wait(lock);
+        } else {
+            m_timer_condition.wait_until(lock, m_timer_epoch + TIMER_TICK * next);
+        }
+    }
+}
+
+inline SchedulerStats AsyncScheduler::get_stats() {
+    SchedulerStats stats;
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        TaskPriorityStats& priority = stats.priorities[lane];
+        priority.queued = std::max<int64_t>(0, m_pending[lane].count.load(std::memory_order_relaxed));
+        priority.queue_wait = m_latency[lane].queue_wait.summary();
+        priority.run_time = m_latency[lane].run_time.summary();
+    }
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    stats.timers = m_timers.size();
+    return stats;
+}
+
+inline void AsyncScheduler::write_stats_json(std::ostream& out) {
+    static const char* const PRIORITY_NAMES[TASK_PRIORITY_COUNT] = {"LOW", "NORMAL", "HIGH", "CRITICAL"};
+    SchedulerStats stats = get_stats();
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    out << "{\"timestamp_ms\":" << now
+        << ",\"timers\":" << stats.timers
+        << ",\"priorities\":{";
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        const TaskPriorityStats& priority = stats.priorities[lane];
+        out << (lane ? "," : "") << "\"" << PRIORITY_NAMES[lane] << "\":{\"queued\":" << priority.queued
+            << ",\"queue_wait\":";
+        write_latency_json(out, priority.queue_wait);
+        out << ",\"run_time\":";
+        write_latency_json(out, priority.run_time);
+        out << "}";
+    }
+    out << "}}";
+}
+
+inline void AsyncScheduler::start_stats_dump(const std::string& path, std::chrono::milliseconds interval) {
+    stop_stats_dump();
+    LatencyClock::calibrate(); // Here rather than in the first dump on the timer thread
+
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    m_stats_timer = submit_every(interval, [this, path]() {
+        std::ofstream out(path, std::ios::app);
+        if (out) {
+            write_stats_json(out);
+            out << '\n';
+        } else {
+            std::cerr << "Warning: Could not open scheduler stats file: " << path << std::endl;
+        }
+    }, TaskPriority::LOW);
+}
+
+inline void AsyncScheduler::stop_stats_dump() {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    if (!m_stats_timer.valid()) return;
+    cancel(m_stats_timer);
+    m_stats_timer = TimerHandle();
 }
 
 inline AsyncScheduler::~AsyncScheduler() {
     {
-        std::unique_lock<std::mutex> lock(m_queue_mutex);
-        m_stop = true;
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stop.store(true, std::memory_order_seq_cst);
     }
-    m_condition.notify_all();
+    m_sleep_condition.notify_all();
+
+    // Timers still pending are dropped
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+    }
+    m_timer_condition.notify_all();
+    if (m_timer_thread.joinable()) m_timer_thread.join();
+
     for (std::thread &worker : m_workers) {
         if(worker.joinable()) worker.join();
     }
@@ -14,6 +14,14 @@ void ConfigParser::trim(std::string& s) {
     }).base(), s.end());
 }
 
+bool ConfigParser::parse_bool(const std::string& value) {
+    std::string lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) {
+        return std::tolower(ch);
+    });
+    return lower == "1" || lower == "true" || lower == "yes" || lower == "on";
+}
+
 void ConfigParser::process_line(const std::string& line, AppConfig& config) {
     std::string temp = line;
     trim(temp);
@@ -44,7 +52,22 @@ void ConfigParser::process_line(const std::string& line, AppConfig& config) {
         else if (key == "log_level") config.log_level = std::stoi(value);
         else if (key == "worker_threads") config.worker_threads = std::stoul(value);
         else if (key == "memory_pool_size_mb") config.memory_pool_size_mb = std::stoul(value);
+        else if (key == "memory_huge_pages") config.memory_huge_pages = value;
+        else if (key == "memory_prefault") config.memory_prefault = parse_bool(value);
+        else if (key == "memory_numa_aware") config.memory_numa_aware = parse_bool(value);
+        else if (key == "memory_stats_path") config.memory_stats_path = value;
+        else if (key == "memory_stats_interval_ms") config.memory_stats_interval_ms = std::stoul(value);
+        else if (key == "event_queue_capacity") config.event_queue_capacity = std::stoul(value);
+        else if (key == "event_queue_policy") config.event_queue_policy = value;
+        else if (key == "event_batch_size") config.event_batch_size = std::stoul(value);
+        else if (key == "latency_sample_rate") config.latency_sample_rate = std::stoul(value);
+        else if (key == "event_stats_path") config.event_stats_path = value;
+        else if (key == "scheduler_stats_path") config.scheduler_stats_path = value;
+        else if (key == "latency_stats_interval_ms") config.latency_stats_interval_ms = std::stoul(value);
         else if (key == "simulation_timestep") config.simulation_timestep = std::stod(value);
+        else if (key == "simulation_integrator") config.simulation_integrator = value;
+        else if (key == "integrator_tolerance") config.integrator_tolerance = std::stod(value);
+        else if (key == "krylov_dimension") config.krylov_dimension = std::stoul(value);
     } else if (m_current_section == "Plugins") {
         // Try to guess the type for variant
         try {
@@ -59,6 +82,20 @@ void ConfigParser::process_line(const std::string& line, AppConfig& config) {
     }
 }
 
+// Values that would only fail later, when the subsystem using them starts
+bool ConfigParser::validate(const AppConfig& config) {
+    bool valid = true;
+    if (config.krylov_dimension < 2) {
+        std::cerr << "Error: krylov_dimension must be at least 2, got " << config.krylov_dimension << std::endl;
+        valid = false;
+    }
+    if (!(config.integrator_tolerance > 0)) {
+        std::cerr << "Error: integrator_tolerance must be positive, got " << config.integrator_tolerance << std::endl;
+        valid = false;
+    }
+    return valid;
+}
+
 AppConfig ConfigParser::parse(const std::string& file_path) {
     AppConfig config;
     std::ifstream file(file_path);
@@ -75,6 +112,6 @@ AppConfig ConfigParser::parse(const std::string& file_path) {
         process_line(line, config);
     }
     
-    config.is_valid = true;
+    config.is_valid = validate(config);
     return config;
 }
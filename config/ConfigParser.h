@@ -13,7 +13,22 @@ struct AppConfig {
     int log_level = 2; // 0=Debug, 1=Info, 2=Warn, 3=Error
     size_t worker_threads = 4;
     size_t memory_pool_size_mb = 256;
+    std::string memory_huge_pages = "none"; // none, transparent or explicit
+    bool memory_prefault = false;
+    bool memory_numa_aware = false;
+    std::string memory_stats_path;     // Empty disables the periodic JSON dump
+    size_t memory_stats_interval_ms = 10000;
+    size_t event_queue_capacity = 4096;
+    std::string event_queue_policy = "block"; // block, drop_oldest or reject
+    size_t event_batch_size = 32;
+    size_t latency_sample_rate = 8;    // Time one event or task in this many
+    std::string event_stats_path;      // Empty disables the periodic JSON dump
+    std::string scheduler_stats_path;  // Likewise
+    size_t latency_stats_interval_ms = 10000;
     double simulation_timestep = 0.016;
+    std::string simulation_integrator = "euler"; // euler or krylov
+    double integrator_tolerance = 1e-10;         // Krylov error bound per step
+    size_t krylov_dimension = 24;
     
     // A map for arbitrary plugin settings
     std::map<std::string, std::variant<int, double, std::string>> plugin_settings;
@@ -27,13 +42,16 @@ public:
      * @brief Parses a configuration file from the given path.
      * The format is a simple key=value format. Lines starting with '#' are comments.
      * @param file_path The path to the configuration file.
-     * @return An AppConfig struct populated with values.
+     * @return An AppConfig struct populated with values. is_valid is false if the
+     *         file cannot be opened or a value is out of range.
      */
     AppConfig parse(const std::string& file_path);
 
 private:
     void trim(std::string& s);
+    bool parse_bool(const std::string& value);
     void process_line(const std::string& line, AppConfig& config);
+    bool validate(const AppConfig& config);
     
     // Internal state to track parsing context, e.g., current section.
     std::string m_current_section;
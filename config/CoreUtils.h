@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cstdint>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <numeric>
@@ -58,6 +59,38 @@ namespace Core {
         return hash;
     }
 
+    /**
+     * @brief Hashes a 64-bit key, such as an entity or simulation ID.
+     * A bijective mixer (the MurmurHash3 finalizer): every input bit affects
+     * every output bit, so sequential IDs spread evenly over buckets.
+     * @param key The input key.
+     * @return A 64-bit hash code.
+     */
+    inline uint64_t fast_hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCD;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /**
+     * @brief Writes a string as a quoted JSON string.
+     * Quotes and backslashes are escaped; control characters become spaces.
+     * @param out The output stream.
+     * @param str The string to write.
+     */
+    inline void write_json_string(std::ostream& out, const std::string& str) {
+        out << '"';
+        for (char c : str) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+        out << '"';
+    }
+
     // A dummy function to satisfy linker dependencies from main.cpp
     inline void initialize_legacy_handle(void* handle, uint32_t seed) {
         if (!handle) return;
@@ -0,0 +1,198 @@
+// Coroutine.h - C++20 coroutine tasks executed on AsyncScheduler workers.
+// A Task<T> is lazy: it starts when awaited or handed to spawn_task, and a
+// finished task resumes its awaiter directly (symmetric transfer), so chains
+// of awaits never grow the stack or block a worker.
+//
+//   Task<int> step() {
+//       co_await AsyncScheduler::getInstance().schedule(TaskPriority::HIGH);
+//       co_await sleep_for(std::chrono::milliseconds(5));
+//       co_return 42;
+//   }
+//   TaskFuture<int> result = spawn_task(step());
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "AsyncScheduler.h"
+#include "ObjectPool.h"
+#include "TaskGraph.h"
+
+template<typename T = void> class Task;
+
+namespace detail {
+
+    // Coroutine frames come from the MemoryManager pool, like task entries
+    struct PooledFrame {
+        static void* operator new(size_t size) {
+            return pooled_allocate(size, "CoroutineFrame");
+        }
+
+        static void operator delete(void* frame, size_t) noexcept {
+            pooled_deallocate(frame, "CoroutineFrame");
+        }
+    };
+
+    struct TaskPromiseBase : PooledFrame {
+        // Resumes whoever awaited the task once it finishes
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+    };
+
+    template<typename T>
+    struct TaskPromise : TaskPromiseBase {
+        Task<T> get_return_object() noexcept;
+
+        template<typename U>
+        void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+
+        T take() {
+            if (error) std::rethrow_exception(error);
+            return std::move(*result);
+        }
+
+        std::optional<T> result;
+    };
+
+    template<>
+    struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object() noexcept;
+
+        void return_void() noexcept {}
+
+        void take() {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+
+} // namespace detail
+
+// A lazily started coroutine producing a T. Move-only; owns its frame.
+template<typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task() noexcept = default;
+    explicit Task(handle_type handle) noexcept : m_handle(handle) {}
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(m_handle); }
+
+    // Starts the task on the awaiting thread and resumes the awaiter,
+    // inline, when it completes. Awaiting an empty (default-constructed or
+    // moved-from) task is an error: it throws std::logic_error.
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            handle_type handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                if (!handle) throw std::logic_error("Awaited an empty Task");
+                return handle.promise().take();
+            }
+        };
+        return Awaiter{m_handle};
+    }
+
+private:
+    handle_type m_handle;
+};
+
+namespace detail {
+
+    template<typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+    // Fire-and-forget coroutine that owns a Task until it finishes
+    struct DetachedTask {
+        struct promise_type : PooledFrame {
+            DetachedTask get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    template<typename T>
+    DetachedTask run_detached(Task<T> task, std::shared_ptr<TaskFutureState<T>> state, TaskPriority priority) {
+        try {
+            co_await AsyncScheduler::getInstance().schedule(priority);
+            if constexpr (std::is_void<T>::value) {
+                co_await std::move(task);
+                state->set_value(VoidResult{});
+            } else {
+                state->set_value(co_await std::move(task));
+            }
+        } catch (...) {
+            state->set_exception(std::current_exception());
+        }
+    }
+
+} // namespace detail
+
+// Starts a coroutine on a worker at the given priority. The returned future
+// can be chained with then() or waited on from outside the worker pool.
+template<typename T>
+TaskFuture<T> spawn_task(Task<T> task, TaskPriority priority = TaskPriority::NORMAL) {
+    auto state = detail::make_task_state<T>();
+    detail::run_detached(std::move(task), state, priority);
+    return TaskFuture<T>(std::move(state));
+}
+
+// Suspends the calling coroutine for delay, then resumes it on a worker.
+inline AsyncScheduler::SleepAwaiter sleep_for(std::chrono::steady_clock::duration delay,
+                                             TaskPriority priority = TaskPriority::NORMAL) {
+    return AsyncScheduler::getInstance().sleep_for(delay, priority);
+}
@@ -3,6 +3,7 @@
 #include "CryptoHash.h"
 #include <cstring>
 #include <stdexcept>
+#include <utility>
 
 // Constants derived from the fractional parts of cube roots of the first 8 primes.
 // This is a common technique to generate "nothing up my sleeve" numbers.
@@ -11,20 +12,78 @@ const std::array<uint32_t, 8> INITIAL_STATE = {
     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
 };
 
+#if defined(__GNUC__) || defined(__clang__)
+#define HASH_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define HASH_ALWAYS_INLINE inline
+#endif
+
 // Rotates x to the right by n bits.
-inline uint32_t rotr(uint32_t x, uint32_t n) {
+HASH_ALWAYS_INLINE uint32_t rotr(uint32_t x, uint32_t n) {
     return (x >> n) | (x << (32 - n));
 }
 
 // The core compression function logic. These are arbitrary choices.
-inline uint32_t F0(uint32_t x, uint32_t y, uint32_t z) {
+HASH_ALWAYS_INLINE uint32_t F0(uint32_t x, uint32_t y, uint32_t z) {
     return (x & y) ^ (~x & z);
 }
 
-inline uint32_t F1(uint32_t x, uint32_t y, uint32_t z) {
+HASH_ALWAYS_INLINE uint32_t F1(uint32_t x, uint32_t y, uint32_t z) {
     return (x & y) ^ (x & z) ^ (y & z);
 }
 
+// Reads a big-endian word; compiles to a load and a bswap (or movbe).
+HASH_ALWAYS_INLINE uint32_t load_be32(const uint8_t* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap32(word);
+#endif
+    return word;
+#else
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+#endif
+}
+
+// Round I of the compression function. Rather than shifting a..h down
+// each round, the roles rotate through s: a is s[-I & 7], b is s[(1 - I) & 7]
+// and so on, so a fully unrolled block compiles to register renames. From
+// round 16 on, the message schedule is extended in place in a 16-word ring.
+template<size_t I>
+HASH_ALWAYS_INLINE void hash_round(uint32_t (&s)[8], uint32_t (&w)[16]) {
+    if constexpr (I >= 16) {
+        uint32_t w15 = w[(I - 15) & 15];
+        uint32_t w2 = w[(I - 2) & 15];
+        uint32_t s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+        uint32_t s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+        w[I & 15] += s0 + w[(I - 7) & 15] + s1;
+    }
+
+    uint32_t& a = s[(8 - I % 8) & 7];
+    uint32_t& b = s[(9 - I % 8) & 7];
+    uint32_t& c = s[(10 - I % 8) & 7];
+    uint32_t& d = s[(11 - I % 8) & 7];
+    uint32_t& e = s[(12 - I % 8) & 7];
+    uint32_t& f = s[(13 - I % 8) & 7];
+    uint32_t& g = s[(14 - I % 8) & 7];
+    uint32_t& h = s[(15 - I % 8) & 7];
+
+    uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    uint32_t temp1 = h + s1 + F0(e, f, g) + 0x428a2f98 + w[I & 15]; // Using a single constant for simplicity
+    uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    uint32_t temp2 = s0 + F1(a, b, c);
+
+    // h's slot becomes the next a, d's the next e
+    d += temp1;
+    h = temp1 + temp2;
+}
+
+template<size_t... I>
+HASH_ALWAYS_INLINE void hash_rounds(uint32_t (&s)[8], uint32_t (&w)[16], std::index_sequence<I...>) {
+    (hash_round<I>(s, w), ...);
+}
+
 CryptoHash::CryptoHash() {
     reset();
 }
@@ -42,13 +101,12 @@ void CryptoHash::update(const uint8_t* data, size_t length) {
     if (length >= buffer_space) {
         // Fill the buffer and process it
         memcpy(m_buffer.data() + m_buffer_len, data, buffer_space);
-        process_block(m_buffer.data());
+        process_blocks(m_buffer.data(), 1);
         
-        // Process remaining full blocks
-        size_t i;
-        for (i = buffer_space; i + 63 < length; i += 64) {
-            process_block(data + i);
-        }
+        // Process remaining full blocks in one pass
+        size_t blocks = (length - buffer_space) / 64;
+        process_blocks(data + buffer_space, blocks);
+        size_t i = buffer_space + blocks * 64;
         m_buffer_len = length - i;
         memcpy(m_buffer.data(), data + i, m_buffer_len);
     } else {
@@ -58,8 +116,12 @@ void CryptoHash::update(const uint8_t* data, size_t length) {
     m_bit_count += length * 8;
 }
 
-void CryptoHash::update(const std::string& str) {
-    update(reinterpret_cast<const uint8_t*>(str.c_str()), str.length());
+void CryptoHash::update(std::string_view str) {
+    update(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+void CryptoHash::update(std::span<const std::byte> bytes) {
+    update(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
 }
 
 Digest CryptoHash::finalize() {
@@ -93,48 +155,28 @@ Digest CryptoHash::finalize() {
     return digest;
 }
 
-void CryptoHash::process_block(const uint8_t* block) {
-    uint32_t w[64];
-    for (int i = 0; i < 16; ++i) {
-        w[i] = (block[i*4] << 24) | (block[i*4+1] << 16) | (block[i*4+2] << 8) | block[i*4+3];
-    }
-    
-    // Extend the 16 32-bit words into 64 32-bit words
-    for (int i = 16; i < 64; ++i) {
-        uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
-        uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
-        w[i] = w[i-16] + s0 + w[i-7] + s1;
-    }
-    
-    // Initialize working variables with current hash value
-    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
-    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
-    
-    // Compression function main loop
-    for (int i = 0; i < 64; ++i) {
-        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
-        uint32_t ch = (e & f) ^ (~e & g);
-        uint32_t temp1 = h + s1 + ch + 0x428a2f98 + w[i]; // Using a single constant for simplicity
-        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
-        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
-        uint32_t temp2 = s0 + maj;
-        
-        h = g;
-        g = f;
-        f = e;
-        e = d + temp1;
-        d = c;
-        c = b;
-        b = a;
-        a = temp1 + temp2;
+void CryptoHash::process_blocks(const uint8_t* blocks, size_t count) {
+    uint32_t state[8];
+    for (int i = 0; i < 8; ++i) state[i] = m_state[i];
+
+    for (; count > 0; --count, blocks += 64) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; ++i) w[i] = load_be32(blocks + i * 4);
+
+        uint32_t s[8];
+        for (int i = 0; i < 8; ++i) s[i] = state[i];
+
+        // 64 rounds bring the roles back to where they started
+        hash_rounds(s, w, std::make_index_sequence<64>{});
+
+        // Add the compressed chunk to the current hash value
+        for (int i = 0; i < 8; ++i) state[i] += s[i];
     }
-    
-    // Add the compressed chunk to the current hash value
-    m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
-    m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+
+    for (int i = 0; i < 8; ++i) m_state[i] = state[i];
 }
 
-Digest CryptoHash::compute(const std::string& data) {
+Digest CryptoHash::compute(std::string_view data) {
     CryptoHash hasher;
     hasher.update(data);
     return hasher.finalize();
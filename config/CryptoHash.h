@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 
@@ -14,23 +17,58 @@ constexpr size_t HASH_SIZE = 32; // 256-bit
 // Represents a 256-bit hash digest.
 using Digest = std::array<uint8_t, HASH_SIZE>;
 
+// Instruction sets compute_many can spread message states across.
+enum class HashBackend {
+    Auto,   // Widest one the CPU supports
+    Scalar, // One message at a time
+    SSE41,  // 4 messages per pass
+    AVX2,   // 8 messages per pass
+    AVX512  // 16 messages per pass
+};
+
 class CryptoHash {
 public:
     CryptoHash();
 
     // Update the hash state with more data.
     void update(const uint8_t* data, size_t length);
-    void update(const std::string& str);
+    void update(std::string_view str);
+    void update(std::span<const std::byte> bytes);
+
+    // Hashes a file's contents in place: regular files are mapped and read
+    // sequentially, anything else (pipes, devices) is streamed through
+    // reused buffers with the next read overlapping the hashing of the last.
+    // Throws std::runtime_error if the file cannot be opened or read.
+    // A regular file must not shrink while it is hashed: reading the mapped
+    // pages past its new end raises SIGBUS, which terminates the process.
+    // Hash a file another process may truncate through a pipe or a copy.
+    void update_file(const std::string& path);
 
     // Finalize the hash and return the digest.
     Digest finalize();
 
     // Static helper to compute hash for a single block of data.
-    static Digest compute(const std::string& data);
+    static Digest compute(std::string_view data);
+
+    // Static helper to hash a whole file without loading it into memory.
+    static Digest compute_file(const std::string& path);
+
+    // Hashes many independent messages at once, one per SIMD lane, refilling
+    // a lane as soon as its message is done. Digests are identical to
+    // compute() and come back in the order of the input. A backend the CPU
+    // lacks falls back to the next narrower one.
+    static std::vector<Digest> compute_many(std::span<const std::string_view> messages,
+                                            HashBackend backend = HashBackend::Auto);
+
+    // The backend compute_many uses for HashBackend::Auto
+    static HashBackend best_backend();
 
 private:
     void reset();
-    void process_block(const uint8_t* block);
+
+    // Compresses count consecutive 64-byte blocks, keeping the working
+    // state in registers from the first block to the last.
+    void process_blocks(const uint8_t* blocks, size_t count);
 
     // Internal state (H0, H1, H2, H3, ...)
     std::array<uint32_t, 8> m_state;
@@ -0,0 +1,230 @@
+// CryptoHashFile.cpp - Hashing files without reading them into a string.
+// Regular files are mapped read-only and walked front to back in windows;
+// the kernel reads ahead (MADV_SEQUENTIAL) and each finished window is
+// dropped from the mapping so resident memory stays flat for any file size.
+// Pipes, devices and files that cannot be mapped are read into two reused,
+// page-aligned buffers by a reader thread of their own, with the next read
+// running while the last one is hashed.
+//
+// A mapped file must not be truncated while it is being hashed; see
+// CryptoHash::update_file.
+
+#include "CryptoHash.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace {
+
+    // Bytes hashed per mapping window, and per buffer when streaming
+    constexpr size_t MAP_WINDOW = 64 * 1024 * 1024;
+    constexpr size_t READ_BUFFER = 1024 * 1024;
+    constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+    [[noreturn]] void throw_file_error(const char* what, const std::string& path) {
+        throw std::runtime_error(std::string("CryptoHash: ") + what + " '" + path + "': " + std::strerror(errno));
+    }
+
+    struct AlignedFree {
+        void operator()(uint8_t* p) const { std::free(p); }
+    };
+    using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedFree>;
+
+    AlignedBuffer make_read_buffer() {
+        AlignedBuffer buffer(static_cast<uint8_t*>(std::aligned_alloc(BUFFER_ALIGNMENT, READ_BUFFER)));
+        if (!buffer) throw std::bad_alloc();
+        return buffer;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    class FileDescriptor {
+    public:
+        explicit FileDescriptor(int fd) : m_fd(fd) {}
+        ~FileDescriptor() { if (m_fd >= 0) close(m_fd); }
+        FileDescriptor(const FileDescriptor&) = delete;
+        FileDescriptor& operator=(const FileDescriptor&) = delete;
+        int get() const { return m_fd; }
+
+    private:
+        int m_fd;
+    };
+
+    // A read-only private mapping of a whole file, unmapped when destroyed
+    class FileMapping {
+    public:
+        FileMapping(int fd, size_t size)
+            : m_base(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)), m_size(size) {}
+        ~FileMapping() { if (valid()) munmap(m_base, m_size); }
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+        bool valid() const { return m_base != MAP_FAILED; }
+        uint8_t* data() const { return static_cast<uint8_t*>(m_base); }
+
+    private:
+        void* m_base;
+        size_t m_size;
+    };
+
+    // Returns false, leaving the hasher untouched, if the file cannot be mapped
+    bool hash_mapped(CryptoHash& hasher, int fd, size_t size) {
+        FileMapping mapping(fd, size);
+        if (!mapping.valid()) return false;
+        madvise(mapping.data(), size, MADV_SEQUENTIAL);
+
+        for (size_t offset = 0; offset < size; offset += MAP_WINDOW) {
+            size_t length = std::min(MAP_WINDOW, size - offset);
+            hasher.update(mapping.data() + offset, length);
+            // Windows are page-aligned; dropping them only affects this mapping
+            madvise(mapping.data() + offset, length, MADV_DONTNEED);
+        }
+        return true;
+    }
+
+    ssize_t read_some(int fd, uint8_t* buffer) {
+        ssize_t n;
+        do {
+            n = read(fd, buffer, READ_BUFFER);
+        } while (n < 0 && errno == EINTR);
+        return n;
+    }
+
+    // One thread reads the whole stream into two buffers in turn while the
+    // caller hashes the other one. The reader stops after the end of the
+    // file or an error, or when the ReadAhead is destroyed.
+    class ReadAhead {
+    public:
+        explicit ReadAhead(int fd) : m_fd(fd), m_reader([this] { run(); }) {}
+
+        ~ReadAhead() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_condition.notify_all();
+            m_reader.join();
+        }
+
+        ReadAhead(const ReadAhead&) = delete;
+        ReadAhead& operator=(const ReadAhead&) = delete;
+
+        // Waits for the next buffer. Returns its length, 0 at the end of the
+        // file, or -1 after a failed read with errno set. The buffer stays
+        // valid until release().
+        ssize_t acquire(const uint8_t*& data) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_filled > m_consumed; });
+            size_t slot = m_consumed % 2;
+            data = m_buffers[slot].get();
+            if (m_lengths[slot] < 0) errno = m_error;
+            return m_lengths[slot];
+        }
+
+        // Hands the last acquired buffer back to the reader
+        void release() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_consumed;
+            }
+            m_condition.notify_all();
+        }
+
+    private:
+        void run() {
+            for (size_t produced = 0;; ++produced) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [&] { return m_stop || produced - m_consumed < 2; });
+                    if (m_stop) return;
+                }
+                size_t slot = produced % 2;
+                ssize_t n = read_some(m_fd, m_buffers[slot].get());
+                int error = errno;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_lengths[slot] = n;
+                    m_error = error;
+                    ++m_filled;
+                }
+                m_condition.notify_all();
+                if (n <= 0) return;
+            }
+        }
+
+        int m_fd;
+        AlignedBuffer m_buffers[2] = { make_read_buffer(), make_read_buffer() };
+        ssize_t m_lengths[2] = {};
+        int m_error = 0;
+        size_t m_filled = 0;   // Buffers the reader has published
+        size_t m_consumed = 0; // Buffers the caller has released
+        bool m_stop = false;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::thread m_reader; // Last, so it starts after everything above
+    };
+
+    void hash_streamed(CryptoHash& hasher, int fd, const std::string& path) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        ReadAhead reader(fd);
+        const uint8_t* data = nullptr;
+        ssize_t n;
+        while ((n = reader.acquire(data)) > 0) {
+            hasher.update(data, static_cast<size_t>(n));
+            reader.release();
+        }
+        if (n < 0) throw_file_error("cannot read", path);
+    }
+
+#endif
+
+} // namespace
+
+void CryptoHash::update_file(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    FileDescriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.get() < 0) throw_file_error("cannot open", path);
+
+    struct stat info;
+    if (fstat(file.get(), &info) != 0) throw_file_error("cannot stat", path);
+
+    // Regular files that report a size are mapped; /proc-style files report
+    // zero and must be read
+    if (S_ISREG(info.st_mode) && info.st_size > 0 &&
+        hash_mapped(*this, file.get(), static_cast<size_t>(info.st_size))) {
+        return;
+    }
+    hash_streamed(*this, file.get(), path);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw_file_error("cannot open", path);
+    AlignedBuffer buffer = make_read_buffer();
+    while (file) {
+        file.read(reinterpret_cast<char*>(buffer.get()), READ_BUFFER);
+        update(buffer.get(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) throw_file_error("cannot read", path);
+#endif
+}
+
+Digest CryptoHash::compute_file(const std::string& path) {
+    CryptoHash hasher;
+    hasher.update_file(path);
+    return hasher.finalize();
+}
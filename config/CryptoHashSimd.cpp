@@ -0,0 +1,238 @@
+// CryptoHashSimd.cpp - Multi-buffer CryptoHash: many messages per SIMD pass.
+// Each vector lane carries the state of a different message, so one pass of
+// the compression function advances 4, 8 or 16 messages by a block. The
+// round code is written once against GCC/Clang vector types and compiled
+// for each instruction set through target attributes; the widest one the
+// CPU supports is picked at runtime.
+
+#include "CryptoHash.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRYPTO_HASH_SIMD 1
+#else
+#define CRYPTO_HASH_SIMD 0
+#endif
+
+namespace {
+
+#if CRYPTO_HASH_SIMD
+
+    typedef uint32_t HashVec4 __attribute__((vector_size(16)));
+    typedef uint32_t HashVec8 __attribute__((vector_size(32)));
+    typedef uint32_t HashVec16 __attribute__((vector_size(64)));
+
+    // process_block uses this single constant for every round
+    constexpr uint32_t ROUND_CONSTANT = 0x428a2f98;
+
+#define HASH_INLINE inline __attribute__((always_inline))
+#define HASH_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+    HASH_INLINE uint32_t load_be32(const uint8_t* p) {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        return __builtin_bswap32(word);
+    }
+
+    // Where one lane is in its message. Whole blocks are read in place; the
+    // last one or two blocks, with the padding, come from tail.
+    struct LaneCursor {
+        const uint8_t* data = nullptr;
+        size_t full_blocks = 0;
+        size_t total_blocks = 0;
+        size_t next = 0;
+        size_t message = 0;
+        bool active = false;
+        alignas(64) uint8_t tail[128];
+
+        void start(std::string_view text, size_t index) {
+            data = reinterpret_cast<const uint8_t*>(text.data());
+            full_blocks = text.size() / 64;
+            size_t remainder = text.size() % 64;
+            size_t tail_blocks = remainder < 56 ? 1 : 2;
+            total_blocks = full_blocks + tail_blocks;
+            next = 0;
+            message = index;
+            active = true;
+
+            // Same padding as CryptoHash::finalize: 0x80, zeros, then the
+            // length in bits as a big-endian 64-bit integer
+            memset(tail, 0, sizeof(tail));
+            if (remainder) memcpy(tail, data + full_blocks * 64, remainder);
+            tail[remainder] = 0x80;
+            uint64_t bit_count = static_cast<uint64_t>(text.size()) * 8;
+            uint8_t* length = tail + tail_blocks * 64 - 8;
+            for (int i = 0; i < 8; ++i) {
+                length[i] = static_cast<uint8_t>(bit_count >> (56 - i * 8));
+            }
+        }
+
+        const uint8_t* block() const {
+            return next < full_blocks ? data + next * 64 : tail + (next - full_blocks) * 64;
+        }
+    };
+
+    // One compression of every lane; the message schedule is kept as a
+    // rolling window of 16 words
+    template<typename V>
+    HASH_INLINE void compress_lanes(V* state, V* w) {
+        V a = state[0], b = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            if (i >= 16) {
+                V w15 = w[(i - 15) & 15];
+                V w2 = w[(i - 2) & 15];
+                V s0 = HASH_ROTR(w15, 7) ^ HASH_ROTR(w15, 18) ^ (w15 >> 3);
+                V s1 = HASH_ROTR(w2, 17) ^ HASH_ROTR(w2, 19) ^ (w2 >> 10);
+                w[i & 15] = w[i & 15] + s0 + w[(i - 7) & 15] + s1;
+            }
+
+            V s1 = HASH_ROTR(e, 6) ^ HASH_ROTR(e, 11) ^ HASH_ROTR(e, 25);
+            V ch = (e & f) ^ (~e & g);
+            V temp1 = h + s1 + ch + ROUND_CONSTANT + w[i & 15];
+            V s0 = HASH_ROTR(a, 2) ^ HASH_ROTR(a, 13) ^ HASH_ROTR(a, 22);
+            V maj = (a & b) ^ (a & c) ^ (b & c);
+            V temp2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    // Feeds messages through LANES lanes until all are hashed. Idle lanes
+    // keep hashing a dummy block whose result is never read.
+    template<typename V, size_t LANES>
+    HASH_INLINE void hash_lanes(std::span<const std::string_view> messages, Digest* digests,
+                                const std::array<uint32_t, 8>& initial) {
+        static const uint8_t idle_block[64] = {};
+        LaneCursor lanes[LANES];
+        V state[8];
+        size_t next_message = 0;
+        size_t active = 0;
+
+        for (size_t l = 0; l < LANES; ++l) {
+            for (int k = 0; k < 8; ++k) state[k][l] = initial[k];
+            if (next_message < messages.size()) {
+                lanes[l].start(messages[next_message], next_message);
+                ++next_message;
+                ++active;
+            }
+        }
+
+        while (active > 0) {
+            V w[16];
+            for (size_t l = 0; l < LANES; ++l) {
+                const uint8_t* block = lanes[l].active ? lanes[l].block() : idle_block;
+                for (int i = 0; i < 16; ++i) w[i][l] = load_be32(block + i * 4);
+            }
+
+            compress_lanes(state, w);
+
+            for (size_t l = 0; l < LANES; ++l) {
+                LaneCursor& lane = lanes[l];
+                if (!lane.active || ++lane.next < lane.total_blocks) continue;
+
+                Digest& digest = digests[lane.message];
+                for (int k = 0; k < 8; ++k) {
+                    uint32_t word = __builtin_bswap32(state[k][l]);
+                    memcpy(digest.data() + k * 4, &word, sizeof(word));
+                    state[k][l] = initial[k];
+                }
+                if (next_message < messages.size()) {
+                    lane.start(messages[next_message], next_message);
+                    ++next_message;
+                } else {
+                    lane.active = false;
+                    --active;
+                }
+            }
+        }
+    }
+
+#undef HASH_ROTR
+#undef HASH_INLINE
+
+    __attribute__((target("sse4.1")))
+    void hash_many_sse41(std::span<const std::string_view> messages, Digest* digests,
+                         const std::array<uint32_t, 8>& initial) {
+        hash_lanes<HashVec4, 4>(messages, digests, initial);
+    }
+
+    __attribute__((target("avx2")))
+    void hash_many_avx2(std::span<const std::string_view> messages, Digest* digests,
+                        const std::array<uint32_t, 8>& initial) {
+        hash_lanes<HashVec8, 8>(messages, digests, initial);
+    }
+
+    __attribute__((target("avx512f")))
+    void hash_many_avx512(std::span<const std::string_view> messages, Digest* digests,
+                          const std::array<uint32_t, 8>& initial) {
+        hash_lanes<HashVec16, 16>(messages, digests, initial);
+    }
+
+    bool backend_supported(HashBackend backend) {
+        switch (backend) {
+            case HashBackend::AVX512: return __builtin_cpu_supports("avx512f");
+            case HashBackend::AVX2: return __builtin_cpu_supports("avx2");
+            case HashBackend::SSE41: return __builtin_cpu_supports("sse4.1");
+            default: return true;
+        }
+    }
+
+#else
+
+    bool backend_supported(HashBackend backend) {
+        return backend == HashBackend::Scalar || backend == HashBackend::Auto;
+    }
+
+#endif
+
+} // namespace
+
+HashBackend CryptoHash::best_backend() {
+    static const HashBackend best = [] {
+        for (HashBackend backend : {HashBackend::AVX512, HashBackend::AVX2, HashBackend::SSE41}) {
+            if (backend_supported(backend)) return backend;
+        }
+        return HashBackend::Scalar;
+    }();
+    return best;
+}
+
+std::vector<Digest> CryptoHash::compute_many(std::span<const std::string_view> messages, HashBackend backend) {
+    std::vector<Digest> digests(messages.size());
+    if (messages.empty()) return digests;
+
+    // Step down to the widest backend the CPU has
+    if (backend == HashBackend::Auto) backend = best_backend();
+    while (backend != HashBackend::Scalar && !backend_supported(backend)) {
+        backend = static_cast<HashBackend>(static_cast<int>(backend) - 1);
+    }
+
+#if CRYPTO_HASH_SIMD
+    const std::array<uint32_t, 8> initial = CryptoHash().m_state;
+    switch (backend) {
+        case HashBackend::AVX512: hash_many_avx512(messages, digests.data(), initial); return digests;
+        case HashBackend::AVX2: hash_many_avx2(messages, digests.data(), initial); return digests;
+        case HashBackend::SSE41: hash_many_sse41(messages, digests.data(), initial); return digests;
+        default: break;
+    }
+#endif
+
+    CryptoHash hasher;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        hasher.update(reinterpret_cast<const uint8_t*>(messages[i].data()), messages[i].size());
+        digests[i] = hasher.finalize();
+    }
+    return digests;
+}
@@ -1,31 +1,81 @@
 // EventDispatcher.cpp - Implementation for the event dispatching system.
 
 #include "EventDispatcher.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#include "CoreUtils.h"
+
+// Readable event type names for the stats output
+static std::string type_name(const std::type_info& type) {
+#if defined(__GNUG__)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+        std::string name(demangled);
+        std::free(demangled);
+        return name;
+    }
+#endif
+    return type.name();
+}
 
 EventDispatcher& EventDispatcher::getInstance() {
     static EventDispatcher instance;
     return instance;
 }
 
-void EventDispatcher::start(size_t num_worker_threads) {
+EventDispatcher::EventDispatcher() {
+    // Sized for one worker until start knows better
+    reshard(1, EventQueueOptions().capacity);
+}
+
+void EventDispatcher::start(size_t num_worker_threads, const EventQueueOptions& options) {
     if (m_running) return;
-    
+
+    if (options.capacity != m_event_queue->capacity()) {
+        auto queue = std::make_unique<EventQueue>(options.capacity);
+        QueuedEvent queued;
+        while (m_event_queue->try_pop(queued)) {
+            if (!queue->try_push(std::move(queued))) m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_event_queue = std::move(queue);
+    }
+    m_policy = options.policy;
+    m_batch_size = std::max<size_t>(1, options.batch_size);
+    m_sample_mask = latency_sample_mask(options.latency_sample_rate);
+    reshard(num_worker_threads, options.capacity);
+    m_worker_count = num_worker_threads;
+
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        m_reader_slots.reset(new ReaderSlot[num_worker_threads]);
+        m_reader_count = num_worker_threads;
+    }
+
     m_running = true;
     for (size_t i = 0; i < num_worker_threads; ++i) {
-        m_workers.emplace_back(&EventDispatcher::worker_loop, this);
+        m_workers.emplace_back(&EventDispatcher::worker_loop, this, i);
     }
     std::cout << "EventDispatcher started with " << num_worker_threads << " workers." << std::endl;
 }
 
 void EventDispatcher::stop() {
     if (!m_running) return;
+    stop_stats_dump();
     
-    {
-        std::unique_lock<std::mutex> lock(m_queue_mutex);
-        m_running = false;
-    }
-    m_condition.notify_all();
+    m_running = false;
+    // Wake parked workers so they drain and exit, and blocked producers so they give up
+    m_push_count.fetch_add(1, std::memory_order_seq_cst);
+    m_push_count.notify_all();
+    m_pop_count.fetch_add(1, std::memory_order_seq_cst);
+    m_pop_count.notify_all();
     
     for (auto& worker : m_workers) {
         if (worker.joinable()) {
@@ -33,39 +83,208 @@ void EventDispatcher::stop() {
         }
     }
     m_workers.clear();
+
+    // Nothing more will be dispatched; wake any coroutines still waiting
+    std::vector<EventWaiter*> waiters;
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        for (auto& entry : m_waiters) {
+            waiters.insert(waiters.end(), entry.second.begin(), entry.second.end());
+        }
+        m_waiters.clear();
+        m_waiter_count.store(0, std::memory_order_relaxed);
+
+        // No readers left, every retired table can go
+        m_reader_slots.reset();
+        m_reader_count = 0;
+        reclaim_snapshots();
+    }
+    resume_waiters(waiters, nullptr);
     std::cout << "EventDispatcher stopped." << std::endl;
 }
 
-void EventDispatcher::dispatch(std::shared_ptr<BaseEvent> event) {
-    {
-        std::unique_lock<std::mutex> lock(m_queue_mutex);
-        m_event_queue.push_back(event);
+bool EventDispatcher::dispatch(std::shared_ptr<BaseEvent> event) {
+    QueuedEvent queued{0, std::move(event), dispatch_stamp()};
+    if (!enqueue(*m_event_queue, queued)) return false;
+    wake_workers();
+    return true;
+}
+
+bool EventDispatcher::dispatch(std::shared_ptr<BaseEvent> event, uint64_t key) {
+    Shard& shard = *m_shards[Core::fast_hash(key) % m_shards.size()];
+    QueuedEvent queued{key, std::move(event), dispatch_stamp()};
+    if (!enqueue(shard.queue, queued)) return false;
+    wake_workers();
+    return true;
+}
+
+size_t EventDispatcher::dispatch_batch(std::span<std::shared_ptr<BaseEvent>> events) {
+    size_t queued = 0;
+    for (auto& event : events) {
+        QueuedEvent item{0, std::move(event), dispatch_stamp()};
+        if (enqueue(*m_event_queue, item)) ++queued;
     }
-    m_condition.notify_one();
+    if (queued > 0) wake_workers();
+    return queued;
 }
 
-void EventDispatcher::worker_loop() {
-    while (m_running) {
-        std::shared_ptr<BaseEvent> event;
-        {
-            std::unique_lock<std::mutex> lock(m_queue_mutex);
-            m_condition.wait(lock, [this] { return !m_running || !m_event_queue.empty(); });
-            
-            if (!m_running && m_event_queue.empty()) {
-                return;
+template<typename T>
+bool EventDispatcher::enqueue(MPMCQueue<T>& queue, T& item) {
+    while (!queue.try_push(std::move(item))) {
+        if (m_policy == BackpressurePolicy::DropOldest) {
+            T oldest;
+            if (queue.try_pop(oldest)) m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (m_policy == BackpressurePolicy::Reject || !m_running.load(std::memory_order_acquire)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // A batch defers its wake-up, so make sure someone is draining
+        wake_workers();
+
+        // Block: sleep until a worker frees space. The fence pairs with the
+        // one in worker_loop, so either the worker sees us registered or the
+        // retry below sees the slot it freed.
+        uint32_t seen = m_pop_count.load(std::memory_order_relaxed);
+        m_blocked_producers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.try_push(std::move(item))) break;
+        m_pop_count.wait(seen, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+uint64_t EventDispatcher::dispatch_stamp() {
+    return LATENCY_STATS_ENABLED && sample_latency(m_sample_mask) ? LatencyClock::now() : 0;
+}
+
+void EventDispatcher::wake_workers() {
+    // Pairs with the fence a worker issues before its last look at the queue
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_idle_workers.load(std::memory_order_relaxed) > 0 &&
+        m_idle_workers.exchange(0, std::memory_order_relaxed) > 0) {
+        m_push_count.fetch_add(1, std::memory_order_relaxed);
+        m_push_count.notify_all();
+    }
+}
+
+void EventDispatcher::worker_loop(size_t index) {
+    ReaderSlot& reader = m_reader_slots[index];
+    constexpr size_t SPIN_ROUNDS = 64;
+    constexpr size_t RESERVED_GROUPS = 8; // Event types per pass before the scratch grows
+    size_t idle_rounds = 0;
+    // Reused between passes to keep their capacity, and sized up front so
+    // a worker's first events do not touch the heap either
+    std::vector<EventGroup> groups(RESERVED_GROUPS);
+    std::vector<EventGroup> runs(RESERVED_GROUPS);
+    for (auto& group : groups) group.events.reserve(m_batch_size);
+    for (auto& run : runs) run.events.reserve(m_batch_size);
+    while (true) {
+        // Announce the epoch before loading the table; the fence pairs with
+        // the one in reclaim_snapshots. One announcement covers the pass.
+        reader.epoch.store(m_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const HandlerSnapshot* handlers = m_handlers.load(std::memory_order_acquire);
+
+        // Drain up to a batch, grouped by type in the order types first appear
+        size_t group_count = 0;
+        QueuedEvent queued;
+        for (size_t taken = 0; taken < m_batch_size && m_event_queue->try_pop(queued); ++taken) {
+            add_to_group(groups, group_count, false, handlers, queued);
+        }
+        if (group_count > 0) {
+            release_producers(m_event_queue->size_approx(), m_event_queue->capacity());
+        }
+
+        for (size_t g = 0; g < group_count; ++g) {
+            handle_group(groups[g]);
+        }
+        size_t channel_events = drain_channels(handlers);
+        size_t keyed_events = drain_shards(index, handlers, runs);
+        reader.epoch.store(0, std::memory_order_release);
+
+        for (size_t g = 0; g < group_count; ++g) {
+            finish_group(groups[g]);
+        }
+
+        if (group_count > 0 || channel_events > 0 || keyed_events > 0) {
+            idle_rounds = 0;
+            continue;
+        }
+
+        // Stopping: exit once the queue has been drained
+        if (!m_running.load(std::memory_order_acquire)) return;
+
+        if (++idle_rounds < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Park until a producer bumps the push count past what we saw
+        uint32_t seen = m_push_count.load(std::memory_order_relaxed);
+        // One fence serves both the producer handshake and the epoch announcement
+        m_idle_workers.fetch_add(1, std::memory_order_relaxed);
+        reader.epoch.store(m_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool idle = m_event_queue->empty_approx() && shards_empty() && channels_empty(m_handlers.load(std::memory_order_acquire));
+        reader.epoch.store(0, std::memory_order_release);
+        if (idle && m_running.load(std::memory_order_acquire)) {
+            m_push_count.wait(seen, std::memory_order_relaxed);
+        }
+        idle_rounds = 0;
+    }
+}
+
+void EventDispatcher::add_to_group(std::vector<EventGroup>& groups, size_t& group_count, bool runs_only,
+                                   const HandlerSnapshot* handlers, QueuedEvent& queued) {
+    // Runs only ever extend the last group
+    const std::type_info& type = typeid(*queued.event);
+    size_t g = runs_only && group_count > 0 ? group_count - 1 : 0;
+    while (g < group_count && *groups[g].type != type) ++g;
+    if (g == group_count) {
+        if (g == groups.size()) groups.emplace_back().events.reserve(m_batch_size);
+        groups[g].type = &type;
+        groups[g].slot = handlers ? handlers->find(type) : nullptr;
+        ++group_count;
+    }
+
+    EventGroup& group = groups[g];
+    if (LATENCY_STATS_ENABLED && queued.dispatch_time && group.slot) {
+        // TSC reads on different cores may be a few ticks apart
+        uint64_t now = LatencyClock::now();
+        group.slot->stats->queue_wait.record(now > queued.dispatch_time ? now - queued.dispatch_time : 0);
+    }
+    group.events.push_back(std::move(queued.event));
+}
+
+void EventDispatcher::handle_group(const EventGroup& group) {
+    const HandlerSnapshot::Slot* slot = group.slot;
+    if (!slot) return;
+
+    for (const auto& batch_handler : slot->batch_handlers) {
+        if (LATENCY_STATS_ENABLED && sample_latency(m_sample_mask)) {
+            uint64_t start = LatencyClock::now();
+            batch_handler(group.events);
+            uint64_t per_event = (LatencyClock::now() - start) / group.events.size();
+            slot->stats->handler_time.record(per_event, group.events.size());
+        } else {
+            batch_handler(group.events);
+        }
+    }
+    for (const auto& event : group.events) {
+        if (LATENCY_STATS_ENABLED && sample_latency(m_sample_mask)) {
+            uint64_t start = LatencyClock::now();
+            for (const auto& handler : slot->handlers) {
+                handler(event);
+                uint64_t end = LatencyClock::now();
+                slot->stats->handler_time.record(end - start);
+                start = end;
             }
-            
-            event = m_event_queue.front();
-            m_event_queue.pop_front();
-        }
-        
-        // Find and call handlers for this event type
-        auto type_idx = std::type_index(typeid(*event));
-        
-        std::unique_lock<std::mutex> lock(m_handlers_mutex);
-        auto it = m_handlers.find(type_idx);
-        if (it != m_handlers.end()) {
-            for (const auto& handler : it->second) {
+        } else {
+            for (const auto& handler : slot->handlers) {
                 // To simulate work, handlers could be run in a separate task
                 handler(event);
             }
@@ -73,8 +292,329 @@ void EventDispatcher::worker_loop() {
     }
 }
 
+void EventDispatcher::finish_group(EventGroup& group) {
+    if (m_waiter_count.load(std::memory_order_acquire) > 0) {
+        std::vector<EventWaiter*> waiters;
+        {
+            std::lock_guard<std::mutex> lock(m_handlers_mutex);
+            auto waiting = m_waiters.find(std::type_index(*group.type));
+            if (waiting != m_waiters.end()) {
+                waiters.swap(waiting->second);
+                m_waiter_count.fetch_sub(waiters.size(), std::memory_order_relaxed);
+            }
+        }
+        resume_waiters(waiters, group.events.front());
+    }
+    group.events.clear();
+}
+
+void EventDispatcher::release_producers(size_t queued, size_t capacity) {
+    // Blocked producers are woken once a queue is half drained, not on
+    // every pop, so a full queue does not cost a wake-up per event
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_blocked_producers.load(std::memory_order_relaxed) > 0 && queued <= capacity / 2 &&
+        m_blocked_producers.exchange(0, std::memory_order_relaxed) > 0) {
+        m_pop_count.fetch_add(1, std::memory_order_relaxed);
+        m_pop_count.notify_all();
+    }
+}
+
+size_t EventDispatcher::drain_shards(size_t index, const HandlerSnapshot* handlers, std::vector<EventGroup>& runs) {
+    size_t count = m_shards.size();
+    size_t handled = 0;
+    for (size_t s = index; s < count; s += m_worker_count) {
+        handled += drain_shard(*m_shards[s], handlers, runs);
+    }
+    if (handled > 0) return handled;
+
+    // Nothing at home: take over one shard that nobody is draining
+    for (size_t i = 1; i < count; ++i) {
+        size_t s = (index + i) % count;
+        if (s % m_worker_count == index) continue;
+        if (size_t stolen = drain_shard(*m_shards[s], handlers, runs)) return stolen;
+    }
+    return 0;
+}
+
+size_t EventDispatcher::drain_shard(Shard& shard, const HandlerSnapshot* handlers, std::vector<EventGroup>& runs) {
+    if (shard.queue.empty_approx() || shard.owned.load(std::memory_order_relaxed) ||
+        shard.owned.exchange(true, std::memory_order_acquire)) {
+        return 0;
+    }
+
+    // Split into runs of one type rather than grouping, so handlers still
+    // see the shard's events in dispatch order
+    size_t run_count = 0;
+    size_t taken = 0;
+    QueuedEvent queued;
+    for (; taken < m_batch_size && shard.queue.try_pop(queued); ++taken) {
+        add_to_group(runs, run_count, true, handlers, queued);
+    }
+    release_producers(shard.queue.size_approx(), shard.queue.capacity());
+
+    for (size_t r = 0; r < run_count; ++r) {
+        handle_group(runs[r]);
+        finish_group(runs[r]);
+    }
+    shard.owned.store(false, std::memory_order_release);
+    return taken;
+}
+
+bool EventDispatcher::shards_empty() const {
+    for (const auto& shard : m_shards) {
+        if (!shard->queue.empty_approx()) return false;
+    }
+    return true;
+}
+
+void EventDispatcher::reshard(size_t num_workers, size_t capacity) {
+    size_t count = std::max<size_t>(1, num_workers) * SHARDS_PER_WORKER;
+    size_t shard_capacity = std::bit_ceil(std::max<size_t>(64, capacity / count));
+    if (m_shards.size() == count && m_shards.front()->queue.capacity() == shard_capacity) return;
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    shards.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards.push_back(std::make_unique<Shard>(shard_capacity));
+    }
+
+    // Move queued events over one old shard at a time. A key only ever lived
+    // in one shard, so each key's events keep their order.
+    QueuedEvent queued;
+    for (auto& old : m_shards) {
+        while (old->queue.try_pop(queued)) {
+            Shard& shard = *shards[Core::fast_hash(queued.key) % count];
+            if (!shard.queue.try_push(std::move(queued))) m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    m_shards = std::move(shards);
+}
+
+size_t EventDispatcher::drain_channels(const HandlerSnapshot* handlers) {
+    if (!handlers) return 0;
+    size_t handled = 0;
+    for (const auto& channel : handlers->channels) {
+        handled += channel->drain(m_batch_size);
+    }
+    return handled;
+}
+
+bool EventDispatcher::channels_empty(const HandlerSnapshot* handlers) const {
+    if (!handlers) return true;
+    for (const auto& channel : handlers->channels) {
+        if (!channel->empty_approx()) return false;
+    }
+    return true;
+}
+
+const EventDispatcher::HandlerSnapshot::Slot* EventDispatcher::HandlerSnapshot::find(const std::type_info& type) const {
+    if (slots.empty()) return nullptr;
+    size_t mask = slots.size() - 1;
+    for (size_t i = type.hash_code() & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (!slot.type) return nullptr;
+        if (*slot.type == type) return &slot;
+    }
+}
+
+EventDispatcher::HandlerSnapshot::Slot& EventDispatcher::HandlerSnapshot::insert(const std::type_info& type) {
+    if ((used + 1) * 2 > slots.size()) {
+        // Grow and rehash, keeping each type's handlers in registration order
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(std::max<size_t>(16, old.size() * 2));
+        for (Slot& slot : old) {
+            if (!slot.type) continue;
+            size_t mask = slots.size() - 1;
+            size_t i = slot.type->hash_code() & mask;
+            while (slots[i].type) i = (i + 1) & mask;
+            slots[i] = std::move(slot);
+        }
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t i = type.hash_code() & mask;
+    while (slots[i].type && *slots[i].type != type) i = (i + 1) & mask;
+    if (!slots[i].type) {
+        slots[i].type = &type;
+        slots[i].stats = std::make_shared<EventTypeStats>();
+        ++used;
+    }
+    return slots[i];
+}
+
+void EventDispatcher::add_handler(const std::type_info& type, EventHandler handler) {
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    std::unique_ptr<HandlerSnapshot> next = copy_handlers();
+    next->insert(type).handlers.push_back(std::move(handler));
+    publish_handlers(std::move(next));
+}
+
+void EventDispatcher::add_batch_handler(const std::type_info& type, BatchEventHandler handler) {
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    std::unique_ptr<HandlerSnapshot> next = copy_handlers();
+    next->insert(type).batch_handlers.push_back(std::move(handler));
+    publish_handlers(std::move(next));
+}
+
+void EventDispatcher::attach_channel(std::shared_ptr<ChannelBase> channel) {
+    channel->m_dispatcher.store(this, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        std::unique_ptr<HandlerSnapshot> next = copy_handlers();
+        next->channels.push_back(std::move(channel));
+        publish_handlers(std::move(next));
+    }
+    // Events published before the channel was attached woke nobody
+    wake_workers();
+}
+
+void EventDispatcher::detach_channel(const ChannelBase& channel) {
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    std::unique_ptr<HandlerSnapshot> next = copy_handlers();
+    auto& channels = next->channels;
+    auto attached = std::find_if(channels.begin(), channels.end(),
+        [&channel](const std::shared_ptr<ChannelBase>& c) { return c.get() == &channel; });
+    if (attached == channels.end()) return;
+    (*attached)->m_dispatcher.store(nullptr, std::memory_order_release);
+    channels.erase(attached);
+    publish_handlers(std::move(next));
+}
+
+std::unique_ptr<EventDispatcher::HandlerSnapshot> EventDispatcher::copy_handlers() const {
+    const HandlerSnapshot* current = m_handlers.load(std::memory_order_relaxed);
+    return current ? std::make_unique<HandlerSnapshot>(*current) : std::make_unique<HandlerSnapshot>();
+}
+
+void EventDispatcher::publish_handlers(std::unique_ptr<HandlerSnapshot> next) {
+    const HandlerSnapshot* old = m_handlers.exchange(next.release(), std::memory_order_acq_rel);
+    if (old) {
+        // Workers that enter after this bump cannot see the old table
+        m_retired.emplace_back(m_epoch.fetch_add(1, std::memory_order_acq_rel), old);
+    }
+    reclaim_snapshots();
+}
+
+void EventDispatcher::reclaim_snapshots() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest_reader = UINT64_MAX;
+    for (size_t i = 0; i < m_reader_count; ++i) {
+        uint64_t epoch = m_reader_slots[i].epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest_reader) oldest_reader = epoch;
+    }
+
+    auto still_visible = std::partition(m_retired.begin(), m_retired.end(),
+        [oldest_reader](const auto& retired) { return retired.first >= oldest_reader; });
+    for (auto it = still_visible; it != m_retired.end(); ++it) {
+        delete it->second;
+    }
+    m_retired.erase(still_visible, m_retired.end());
+}
+
+void EventDispatcher::add_waiter(std::type_index type, EventWaiter* waiter) {
+    std::lock_guard<std::mutex> lock(m_handlers_mutex);
+    m_waiters[type].push_back(waiter);
+    m_waiter_count.fetch_add(1, std::memory_order_release);
+}
+
+void EventDispatcher::resume_waiters(std::vector<EventWaiter*>& waiters, const std::shared_ptr<BaseEvent>& event) {
+    for (EventWaiter* waiter : waiters) {
+        waiter->event = event;
+        std::coroutine_handle<> handle = waiter->handle;
+        try {
+            AsyncScheduler::getInstance().post([handle]() { handle.resume(); }, waiter->priority);
+        } catch (const std::exception& e) {
+            // The scheduler is gone; the coroutine stays suspended
+            std::cerr << "Warning: Could not resume event waiter: " << e.what() << std::endl;
+        }
+    }
+}
+
+EventDispatcherStats EventDispatcher::get_stats() {
+    EventDispatcherStats stats;
+    stats.queue_depth = m_event_queue->size_approx();
+    for (const auto& shard : m_shards) {
+        stats.keyed_queue_depth += shard->queue.size_approx();
+    }
+    stats.dropped_events = dropped_events();
+
+    // Summaries are taken outside the lock; the histograms are shared
+    std::vector<std::pair<const std::type_info*, std::shared_ptr<EventTypeStats>>> types;
+    {
+        std::lock_guard<std::mutex> lock(m_handlers_mutex);
+        if (const HandlerSnapshot* handlers = m_handlers.load(std::memory_order_relaxed)) {
+            for (const auto& slot : handlers->slots) {
+                if (slot.type) types.emplace_back(slot.type, slot.stats);
+            }
+        }
+    }
+    for (const auto& entry : types) {
+        stats.types.push_back(EventTypeLatency{type_name(*entry.first), entry.second->queue_wait.summary(),
+                                               entry.second->handler_time.summary()});
+    }
+    std::sort(stats.types.begin(), stats.types.end(),
+              [](const EventTypeLatency& a, const EventTypeLatency& b) { return a.type < b.type; });
+    return stats;
+}
+
+void EventDispatcher::write_stats_json(std::ostream& out) {
+    EventDispatcherStats stats = get_stats();
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    out << "{\"timestamp_ms\":" << now
+        << ",\"queue_depth\":" << stats.queue_depth
+        << ",\"keyed_queue_depth\":" << stats.keyed_queue_depth
+        << ",\"dropped_events\":" << stats.dropped_events
+        << ",\"types\":[";
+    for (size_t i = 0; i < stats.types.size(); ++i) {
+        const EventTypeLatency& type = stats.types[i];
+        out << (i ? "," : "") << "{\"type\":";
+        Core::write_json_string(out, type.type);
+        out << ",\"queue_wait\":";
+        write_latency_json(out, type.queue_wait);
+        out << ",\"handler_time\":";
+        write_latency_json(out, type.handler_time);
+        out << "}";
+    }
+    out << "]}";
+}
+
+void EventDispatcher::start_stats_dump(const std::string& path, std::chrono::milliseconds interval) {
+    stop_stats_dump();
+    LatencyClock::calibrate(); // Here rather than in the first dump on the timer thread
+
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    m_stats_timer = AsyncScheduler::getInstance().submit_every(interval, [this, path]() {
+        std::ofstream out(path, std::ios::app);
+        if (out) {
+            write_stats_json(out);
+            out << '\n';
+        } else {
+            std::cerr << "Warning: Could not open event stats file: " << path << std::endl;
+        }
+    }, TaskPriority::LOW);
+}
+
+void EventDispatcher::stop_stats_dump() {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    if (!m_stats_timer.valid()) return;
+    AsyncScheduler::getInstance().cancel(m_stats_timer);
+    m_stats_timer = TimerHandle();
+}
+
+void ChannelBase::notify_workers() {
+    if (EventDispatcher* dispatcher = m_dispatcher.load(std::memory_order_acquire)) {
+        dispatcher->wake_workers();
+    }
+}
+
 EventDispatcher::~EventDispatcher() {
     if (m_running) {
         stop();
     }
+    for (auto& retired : m_retired) {
+        delete retired.second;
+    }
+    delete m_handlers.load(std::memory_order_relaxed);
 }
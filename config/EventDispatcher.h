@@ -3,11 +3,24 @@
 #pragma once
 
 #include <map>
-#include <list>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <span>
+#include <thread>
+#include <vector>
 #include <typeindex>
+#include <typeinfo>
+#include <coroutine>
+#include <ostream>
+#include <string>
+#include "AsyncScheduler.h"
+#include "LatencyHistogram.h"
+#include "MPMCQueue.h"
+#include "ObjectPool.h"
 
 // Base class for all events
 struct BaseEvent {
@@ -15,6 +28,69 @@ struct BaseEvent {
 };
 
 using EventHandler = std::function<void(std::shared_ptr<BaseEvent>)>;
+using BatchEventHandler = std::function<void(std::span<const std::shared_ptr<BaseEvent>>)>;
+
+// What dispatch does when the event queue is full
+enum class BackpressurePolicy {
+    Block,      // Wait for a worker to free a slot
+    DropOldest, // Discard the oldest queued event to make room
+    Reject      // Return false and drop the new event
+};
+
+struct EventQueueOptions {
+    size_t capacity = 4096; // Rounded up to a power of two
+    BackpressurePolicy policy = BackpressurePolicy::Block;
+    // Events a worker drains per pass. Each pass is handled grouped by type,
+    // so only events of the same type keep their relative order.
+    size_t batch_size = 32;
+    // Latency is measured for one event in this many, rounded up to a power
+    // of two, to keep clock reads off the hot path. 1 measures every event.
+    size_t latency_sample_rate = 8;
+};
+
+// Latency of one event type, from EventDispatcher::get_stats
+struct EventTypeLatency {
+    std::string type;
+    LatencySummary queue_wait;   // From dispatch until a worker takes the event
+    LatencySummary handler_time; // Per handler call; batch calls count per event
+};
+
+struct EventDispatcherStats {
+    size_t queue_depth = 0;       // Shared queue
+    size_t keyed_queue_depth = 0; // All key shards
+    uint64_t dropped_events = 0;
+    std::vector<EventTypeLatency> types; // Types with at least one handler
+};
+
+// A coroutine suspended in EventDispatcher::next_event. Lives in the
+// coroutine frame while registered.
+struct EventWaiter {
+    std::coroutine_handle<> handle;
+    std::shared_ptr<BaseEvent> event;
+    TaskPriority priority = TaskPriority::NORMAL;
+};
+
+class EventDispatcher;
+
+// A statically typed queue drained by the dispatcher workers alongside the
+// shared event queue. See Channel in EventChannel.h.
+class ChannelBase {
+public:
+    virtual ~ChannelBase() = default;
+
+protected:
+    // Wakes a parked worker after an event has been queued
+    void notify_workers();
+
+private:
+    friend class EventDispatcher;
+
+    // Handles up to max_events queued events; returns how many it handled
+    virtual size_t drain(size_t max_events) = 0;
+    virtual bool empty_approx() const = 0;
+
+    std::atomic<EventDispatcher*> m_dispatcher{nullptr};
+};
 
 class EventDispatcher {
 public:
@@ -23,42 +99,232 @@ public:
     EventDispatcher(const EventDispatcher&) = delete;
     void operator=(const EventDispatcher&) = delete;
 
-    void start(size_t num_worker_threads);
+    // Events dispatched before start are kept, up to the new capacity.
+    void start(size_t num_worker_threads, const EventQueueOptions& options = EventQueueOptions());
     void stop();
 
-    // Register a handler for a specific event type
+    // Register a handler for a specific event type.
+    // Publishes a new handler table; workers pick it up on their next event.
     template<typename T_Event>
     void register_handler(std::function<void(std::shared_ptr<T_Event>)> handler);
 
-    // Dispatch an event to all registered handlers
-    void dispatch(std::shared_ptr<BaseEvent> event);
+    // Register a handler that receives events of one type a batch at a time,
+    // in dispatch order. Batch handlers run before the per-event handlers.
+    template<typename T_Event>
+    void register_batch_handler(std::function<void(std::span<const std::shared_ptr<T_Event>>)> handler);
+
+    // Dispatch an event to all registered handlers.
+    // Returns false if the event was not queued: the queue is full under
+    // BackpressurePolicy::Reject, or full while no workers are running.
+    bool dispatch(std::shared_ptr<BaseEvent> event);
+
+    // Dispatch an event in order with every other event of the same key.
+    // Keys are hashed onto shards (four per worker); a shard is drained by
+    // one worker at a time, so same-key events are handled one after another
+    // in dispatch order while different keys run in parallel.
+    bool dispatch(std::shared_ptr<BaseEvent> event, uint64_t key);
+
+    // Dispatch several events with a single worker wake-up. The events are
+    // moved out of the span. Returns how many were queued.
+    size_t dispatch_batch(std::span<std::shared_ptr<BaseEvent>> events);
+
+    // Attach a typed channel. Workers drain it, up to batch_size events per
+    // pass, until it is detached; events still queued then stay in it.
+    void attach_channel(std::shared_ptr<ChannelBase> channel);
+    void detach_channel(const ChannelBase& channel);
+
+    // Events discarded by the backpressure policy since start
+    uint64_t dropped_events() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Latency telemetry; see EventQueueOptions::latency_sample_rate.
+    // Channel events are not measured.
+    EventDispatcherStats get_stats();
+    void write_stats_json(std::ostream& out);
+
+    // Appends one JSON line with the current stats to path every interval,
+    // from an AsyncScheduler timer, until stop_stats_dump or stop is called.
+    // The first call in a process blocks for about 10 ms while LatencyClock
+    // calibrates.
+    void start_stats_dump(const std::string& path, std::chrono::milliseconds interval);
+    void stop_stats_dump();
+
+    // co_await next_event<T>() suspends the calling coroutine until the next
+    // T is processed, then resumes it on an AsyncScheduler worker at the given
+    // priority, after the regular handlers have run. Yields nullptr if the
+    // dispatcher stops first.
+    template<typename T_Event>
+    auto next_event(TaskPriority priority = TaskPriority::NORMAL);
 
 private:
-    EventDispatcher() = default;
+    friend class ChannelBase;
+
+    EventDispatcher();
     ~EventDispatcher();
     
-    void worker_loop();
+    // Immutable handler table. Workers read it without locking;
+    // register_handler publishes a modified copy and retires the old one.
+    // Open addressing keyed by event type, at most half full.
+    struct EventTypeStats {
+        LatencyHistogram queue_wait;
+        LatencyHistogram handler_time;
+    };
+
+    struct HandlerSnapshot {
+        struct Slot {
+            const std::type_info* type = nullptr;
+            std::vector<EventHandler> handlers;
+            std::vector<BatchEventHandler> batch_handlers;
+            std::shared_ptr<EventTypeStats> stats; // Shared by every snapshot of the type
+        };
+
+        std::vector<Slot> slots; // Power-of-two size
+        size_t used = 0;
+        std::vector<std::shared_ptr<ChannelBase>> channels;
 
-    std::map<std::type_index, std::list<EventHandler>> m_handlers;
+        const Slot* find(const std::type_info& type) const;
+        Slot& insert(const std::type_info& type); // Finds or adds the type's slot
+    };
+
+    // Keyed events are queued with their key so a restart with a different
+    // worker count can re-shard them without reordering any key.
+    struct QueuedEvent {
+        uint64_t key = 0;
+        std::shared_ptr<BaseEvent> event;
+        uint64_t dispatch_time = 0; // LatencyClock ticks if sampled, else 0
+    };
+
+    // Each worker owns the shards whose index is congruent to its own. A
+    // worker with nothing at home takes over a whole shard nobody is
+    // draining, never single events, so per-key order survives stealing.
+    struct Shard {
+        explicit Shard(size_t capacity) : queue(capacity) {}
+
+        MPMCQueue<QueuedEvent> queue;
+        alignas(64) std::atomic<bool> owned{false}; // Held by the draining worker
+    };
+
+    static constexpr size_t SHARDS_PER_WORKER = 4;
+
+    // Events of one type taken from the queue in one pass
+    struct EventGroup {
+        const std::type_info* type = nullptr;
+        const HandlerSnapshot::Slot* slot = nullptr; // Valid while the reader epoch is held
+        std::vector<std::shared_ptr<BaseEvent>> events;
+    };
+
+    // Epoch-based reclamation: a worker publishes the epoch it entered the
+    // table at, and a retired table is freed once no worker is still inside
+    // an epoch at or before the one it was retired in.
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0}; // 0 while not reading
+    };
+
+    void worker_loop(size_t index);
+    void add_to_group(std::vector<EventGroup>& groups, size_t& group_count, bool runs_only,
+                      const HandlerSnapshot* handlers, QueuedEvent& queued);
+    void handle_group(const EventGroup& group);
+    void finish_group(EventGroup& group);
+    size_t drain_channels(const HandlerSnapshot* handlers);
+    bool channels_empty(const HandlerSnapshot* handlers) const;
+    size_t drain_shards(size_t index, const HandlerSnapshot* handlers, std::vector<EventGroup>& groups);
+    size_t drain_shard(Shard& shard, const HandlerSnapshot* handlers, std::vector<EventGroup>& groups);
+    bool shards_empty() const;
+    void reshard(size_t num_workers, size_t capacity);
+    template<typename T>
+    bool enqueue(MPMCQueue<T>& queue, T& item);
+    void release_producers(size_t queued, size_t capacity);
+    uint64_t dispatch_stamp();
+    void wake_workers();
+    void add_handler(const std::type_info& type, EventHandler handler);
+    void add_batch_handler(const std::type_info& type, BatchEventHandler handler);
+    std::unique_ptr<HandlerSnapshot> copy_handlers() const; // m_handlers_mutex held
+    void publish_handlers(std::unique_ptr<HandlerSnapshot> next); // m_handlers_mutex held
+    void reclaim_snapshots(); // m_handlers_mutex held
+    void add_waiter(std::type_index type, EventWaiter* waiter);
+    void resume_waiters(std::vector<EventWaiter*>& waiters, const std::shared_ptr<BaseEvent>& event);
+
+    std::atomic<const HandlerSnapshot*> m_handlers{nullptr};
+    std::atomic<uint64_t> m_epoch{1};
+    std::unique_ptr<ReaderSlot[]> m_reader_slots; // One per worker, replaced only by start
+    size_t m_reader_count = 0;
+    std::vector<std::pair<uint64_t, const HandlerSnapshot*>> m_retired;
+
+    // Guards handler registration and the waiter map
     std::mutex m_handlers_mutex;
+    std::map<std::type_index, std::vector<EventWaiter*>> m_waiters;
+    std::atomic<size_t> m_waiter_count{0}; // Lets workers skip the lock when nobody waits
     
-    std::list<std::shared_ptr<BaseEvent>> m_event_queue;
-    std::mutex m_queue_mutex;
-    std::condition_variable m_condition;
-    
+    using EventQueue = MPMCQueue<QueuedEvent>;
+
+    // Bounded lock-free ring; replaced only by start, before workers exist
+    std::unique_ptr<EventQueue> m_event_queue = std::make_unique<EventQueue>(EventQueueOptions().capacity);
+    BackpressurePolicy m_policy = BackpressurePolicy::Block;
+    size_t m_batch_size = EventQueueOptions().batch_size;
+    uint32_t m_sample_mask = latency_sample_mask(EventQueueOptions().latency_sample_rate);
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Keyed event shards; replaced only by start, before workers exist
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    size_t m_worker_count = 0;
+
+    // Parking without a lock. Waiters sleep on the counters with atomic::wait.
+    // The idle/blocked counts are threads parked since the last wake-up; the
+    // waking side swaps them to zero, so a burst of events costs one notify.
+    std::atomic<uint32_t> m_push_count{0};
+    std::atomic<uint32_t> m_pop_count{0};
+    std::atomic<uint32_t> m_idle_workers{0};
+    std::atomic<uint32_t> m_blocked_producers{0};
+
     std::vector<std::thread> m_workers;
-    bool m_running = false;
+    std::atomic<bool> m_running{false};
+
+    // Periodic JSON stats dump
+    std::mutex m_stats_mutex;
+    TimerHandle m_stats_timer;
 };
 
 // Template implementation must be in the header
 template<typename T_Event>
 void EventDispatcher::register_handler(std::function<void(std::shared_ptr<T_Event>)> handler) {
-    std::lock_guard<std::mutex> lock(m_handlers_mutex);
-    auto type_idx = std::type_index(typeid(T_Event));
-    
     // Wrap the specific handler in a generic one
     EventHandler generic_handler = [h = std::move(handler)](std::shared_ptr<BaseEvent> event) {
         h(std::static_pointer_cast<T_Event>(event));
     };
-    m_handlers[type_idx].push_back(generic_handler);
+    add_handler(typeid(T_Event), std::move(generic_handler));
+}
+
+template<typename T_Event>
+void EventDispatcher::register_batch_handler(std::function<void(std::span<const std::shared_ptr<T_Event>>)> handler) {
+    // Downcast into a per-thread buffer that keeps its capacity between batches
+    BatchEventHandler generic_handler = [h = std::move(handler)](std::span<const std::shared_ptr<BaseEvent>> events) {
+        thread_local std::vector<std::shared_ptr<T_Event>> scratch;
+        scratch.reserve(events.size());
+        for (const auto& event : events) {
+            scratch.push_back(std::static_pointer_cast<T_Event>(event));
+        }
+        h(std::span<const std::shared_ptr<T_Event>>(scratch));
+        scratch.clear();
+    };
+    add_batch_handler(typeid(T_Event), std::move(generic_handler));
+}
+
+template<typename T_Event>
+auto EventDispatcher::next_event(TaskPriority priority) {
+    struct Awaiter : EventWaiter {
+        EventDispatcher& dispatcher;
+
+        Awaiter(EventDispatcher& d, TaskPriority p) : dispatcher(d) { this->priority = p; }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> awaiting) {
+            this->handle = awaiting;
+            dispatcher.add_waiter(std::type_index(typeid(T_Event)), this);
+        }
+
+        std::shared_ptr<T_Event> await_resume() {
+            return std::static_pointer_cast<T_Event>(std::move(this->event));
+        }
+    };
+    return Awaiter(*this, priority);
 }
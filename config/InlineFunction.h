@@ -0,0 +1,119 @@
+// InlineFunction.h - Move-only type-erased callable with inline storage.
+// A lighter std::function for queued work: callables up to Capacity bytes are
+// stored in place, larger ones in an ObjectPool slot, so wrapping a task never
+// touches the global heap. Move-only, so it can own promises and other
+// move-only state.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "ObjectPool.h"
+
+template<typename Signature, size_t Capacity = 48>
+class InlineFunction;
+
+template<typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+    // Whether F is stored in place rather than in a pool slot
+    template<typename F>
+    static constexpr bool stored_inline =
+        sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible<F>::value;
+
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template<typename F, typename = std::enable_if_t<
+        !std::is_same<std::decay_t<F>, InlineFunction>::value &&
+        std::is_invocable_r<R, std::decay_t<F>&, Args...>::value>>
+    InlineFunction(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (stored_inline<Fn>) {
+            ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(f));
+        } else {
+            *reinterpret_cast<Fn**>(m_storage) = ObjectPool<Fn>::create(std::forward<F>(f));
+        }
+        m_ops = &Manager<Fn, stored_inline<Fn>>::ops;
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept {
+        move_from(other);
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    R operator()(Args... args) {
+        return m_ops->invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept; // Leaves src destroyed
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F, bool Inline>
+    struct Manager {
+        static F* get(void* storage) {
+            if constexpr (Inline) return std::launder(reinterpret_cast<F*>(storage));
+            else return *reinterpret_cast<F**>(storage);
+        }
+
+        static R invoke(void* storage, Args&&... args) {
+            return std::invoke(*get(storage), std::forward<Args>(args)...);
+        }
+
+        static void move(void* dst, void* src) noexcept {
+            if constexpr (Inline) {
+                ::new (dst) F(std::move(*get(src)));
+                get(src)->~F();
+            } else {
+                *reinterpret_cast<F**>(dst) = get(src);
+            }
+        }
+
+        static void destroy(void* storage) noexcept {
+            if constexpr (Inline) get(storage)->~F();
+            else ObjectPool<F>::destroy(get(storage));
+        }
+
+        static constexpr Ops ops{&invoke, &move, &destroy};
+    };
+
+    void move_from(InlineFunction& other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->move(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity < sizeof(void*) ? sizeof(void*) : Capacity];
+    const Ops* m_ops = nullptr;
+};
@@ -0,0 +1,177 @@
+// KrylovIntegrator.cpp - Lanczos recurrence and the tridiagonal exponential.
+
+#include "KrylovIntegrator.h"
+#include "QuantumKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+
+namespace {
+
+    // Relative size of a Lanczos residual that counts as an invariant
+    // subspace; the projection is then exact for any step length
+    constexpr double BREAKDOWN_TOLERANCE = 1e-12;
+
+    // A substep is halved at most this often before giving up
+    constexpr int MAX_HALVINGS = 50;
+
+    // Eigenvalues and eigenvectors of the symmetric tridiagonal matrix with
+    // diagonal d and off-diagonal e (e[i] couples i and i + 1) by implicit QL
+    // with Wilkinson shifts. On return d holds the eigenvalues and column j
+    // of the row-major n x n matrix z the eigenvector of d[j]; e is
+    // destroyed.
+    void tridiagonal_eigen(std::vector<double>& d, std::vector<double>& e, std::vector<double>& z, int n) {
+        z.assign(static_cast<size_t>(n) * n, 0.0);
+        for (int i = 0; i < n; ++i) z[i * n + i] = 1.0;
+        e.resize(n);
+        e[n - 1] = 0.0;
+
+        for (int l = 0; l < n; ++l) {
+            int iterations = 0;
+            int m;
+            do {
+                for (m = l; m < n - 1; ++m) {
+                    double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                    if (std::abs(e[m]) <= 1e-15 * dd) break;
+                }
+                if (m == l) break;
+                if (++iterations > 60) {
+                    throw std::runtime_error("Tridiagonal eigensolver did not converge");
+                }
+
+                double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+                double r = std::hypot(g, 1.0);
+                g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+                double s = 1.0, c = 1.0, p = 0.0;
+                int i;
+                for (i = m - 1; i >= l; --i) {
+                    double f = s * e[i];
+                    double b = c * e[i];
+                    r = std::hypot(f, g);
+                    e[i + 1] = r;
+                    if (r == 0.0) {
+                        d[i + 1] -= p;
+                        e[m] = 0.0;
+                        break;
+                    }
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + 2.0 * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+                    for (int k = 0; k < n; ++k) {
+                        f = z[k * n + i + 1];
+                        z[k * n + i + 1] = s * z[k * n + i] + c * f;
+                        z[k * n + i] = c * z[k * n + i] - s * f;
+                    }
+                }
+                if (r == 0.0 && i >= l) continue;
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0.0;
+            } while (m != l);
+        }
+    }
+
+    // c = exp(-i T t) e1 from the eigen decomposition T = Z diag(lambda) Z^T
+    void exponential_first_column(const std::vector<double>& lambda, const std::vector<double>& z, int n,
+                                  double t, std::vector<std::complex<double>>& c) {
+        c.assign(n, 0.0);
+        for (int j = 0; j < n; ++j) {
+            std::complex<double> weight = z[j] * std::polar(1.0, -lambda[j] * t);
+            for (int k = 0; k < n; ++k) c[k] += z[k * n + j] * weight;
+        }
+    }
+
+} // namespace
+
+KrylovIntegrator::KrylovIntegrator(size_t krylov_dimension, double tolerance)
+    : m_krylov_dimension(krylov_dimension), m_tolerance(tolerance) {
+    if (krylov_dimension < 2) {
+        throw std::runtime_error("KrylovIntegrator needs a Krylov dimension of at least 2");
+    }
+    if (!(tolerance > 0.0)) {
+        throw std::runtime_error("KrylovIntegrator tolerance must be positive");
+    }
+}
+
+KrylovStepStats KrylovIntegrator::propagate(const HamiltonianMatrix& hamiltonian, ComplexVectorSoA& psi, double dt) {
+    KrylovStepStats stats;
+    size_t n = hamiltonian.size();
+    if (psi.size() != n) {
+        throw std::runtime_error("KrylovIntegrator state size does not match the Hamiltonian");
+    }
+    size_t dimension = std::min(m_krylov_dimension, n);
+    if (m_basis.size() != dimension + 1 || m_basis[0].size() != n) {
+        m_basis.assign(dimension + 1, ComplexVectorSoA(n));
+    }
+
+    std::vector<std::complex<double>> coefficients;
+    double remaining = 1.0; // Fraction of dt still to go
+    bool first = true;
+    while (remaining > 0.0) {
+        double beta0 = std::sqrt(QuantumKernels::squared_norm(psi));
+        if (beta0 == 0.0) break;
+
+        // Lanczos: H V = V T + beta_k v_k e_k^T. Hermitian H keeps T real.
+        m_basis[0] = psi;
+        QuantumKernels::scale(m_basis[0], 1.0 / beta0);
+        m_alpha.clear();
+        m_beta.clear();
+        bool invariant = false;
+        for (size_t j = 0; j < dimension; ++j) {
+            ComplexVectorSoA& w = m_basis[j + 1];
+            hamiltonian.apply(m_basis[j], w);
+            ++stats.matvecs;
+            double alpha = QuantumKernels::dot(m_basis[j], w).real();
+            QuantumKernels::axpy(-alpha, m_basis[j], w);
+            if (j > 0) QuantumKernels::axpy(-m_beta[j - 1], m_basis[j - 1], w);
+            double beta = std::sqrt(QuantumKernels::squared_norm(w));
+            m_alpha.push_back(alpha);
+            m_beta.push_back(beta);
+
+            double scale = std::abs(alpha) + (j > 0 ? m_beta[j - 1] : 0.0);
+            if (beta <= BREAKDOWN_TOLERANCE * scale || beta == 0.0) {
+                invariant = true;
+                break;
+            }
+            QuantumKernels::scale(w, 1.0 / beta);
+        }
+        if (first) stats.energy = m_alpha[0];
+
+        int k = static_cast<int>(m_alpha.size());
+        double residual = m_beta[k - 1];
+        m_eigenvalues = m_alpha;
+        std::vector<double> off_diagonal(m_beta.begin(), m_beta.begin() + (k - 1));
+        tridiagonal_eigen(m_eigenvalues, off_diagonal, m_eigenvectors, k);
+
+        // Longest remaining substep whose error estimate beta0 * beta_k *
+        // |c_k-1| fits its share of the tolerance. Only the small
+        // exponential is recomputed when a substep is halved.
+        double fraction = remaining;
+        double error = 0.0;
+        for (int halvings = 0;; ++halvings) {
+            exponential_first_column(m_eigenvalues, m_eigenvectors, k, fraction * dt, coefficients);
+            error = invariant ? 0.0 : beta0 * residual * std::abs(coefficients[k - 1]);
+            if (error <= m_tolerance * fraction) break;
+            if (halvings == MAX_HALVINGS || !std::isfinite(error)) {
+                throw std::runtime_error("KrylovIntegrator could not meet its tolerance");
+            }
+            fraction *= 0.5;
+        }
+
+        // psi = beta0 * V c
+        std::fill(psi.re.begin(), psi.re.end(), 0.0);
+        std::fill(psi.im.begin(), psi.im.end(), 0.0);
+        for (int j = 0; j < k; ++j) QuantumKernels::axpy(beta0 * coefficients[j], m_basis[j], psi);
+
+        ++stats.substeps;
+        stats.error_estimate += error;
+        remaining = fraction == remaining ? 0.0 : remaining - fraction;
+        first = false;
+    }
+    return stats;
+}
@@ -0,0 +1,51 @@
+// KrylovIntegrator.h - Exact-exponential time stepping by Lanczos projection.
+// propagate() applies psi <- exp(-i H dt) psi for a Hermitian H using only
+// mat-vec products: m Lanczos steps build an orthonormal basis V of the
+// Krylov space {psi, H psi, ..., H^(m-1) psi} and a real tridiagonal T, and
+// exp(-i H t) psi is approximated by |psi| V exp(-i T t) e1. The small
+// exponential comes from the eigenvectors of T.
+//
+// The step is cut into substeps whose a posteriori error estimate stays
+// within the tolerance, so dt can be far larger than an explicit stepper
+// would allow. Unlike the explicit step, the result is unitary up to the
+// tolerance.
+//
+// The basis takes (krylov_dimension + 1) state vectors and is allocated on
+// the first call.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "SimdStorage.h"
+#include "SparseMatrix.h"
+
+struct KrylovStepStats {
+    size_t substeps = 0;
+    size_t matvecs = 0;
+    double error_estimate = 0.0; // Sum of the accepted substep estimates
+    double energy = 0.0;         // <psi|H|psi> / <psi|psi> before the step
+};
+
+class KrylovIntegrator {
+public:
+    // tolerance bounds the estimated norm of the error over a whole step.
+    explicit KrylovIntegrator(size_t krylov_dimension = 24, double tolerance = 1e-10);
+
+    size_t krylov_dimension() const { return m_krylov_dimension; }
+    double tolerance() const { return m_tolerance; }
+
+    // psi <- exp(-i H dt) psi. Throws std::runtime_error if the tolerance
+    // cannot be met.
+    KrylovStepStats propagate(const HamiltonianMatrix& hamiltonian, ComplexVectorSoA& psi, double dt);
+
+private:
+    size_t m_krylov_dimension;
+    double m_tolerance;
+
+    std::vector<ComplexVectorSoA> m_basis; // Lanczos vectors v_0 .. v_m
+    std::vector<double> m_alpha;           // Diagonal of T
+    std::vector<double> m_beta;            // Off-diagonal of T; m_beta[j] couples v_j and v_j+1
+    std::vector<double> m_eigenvalues;
+    std::vector<double> m_eigenvectors;    // Row-major; column j belongs to m_eigenvalues[j]
+};
@@ -0,0 +1,172 @@
+// LatencyHistogram.h - Lock-free latency histograms for runtime telemetry.
+// Log-linear buckets in the style of HdrHistogram: values below 32 ticks are
+// exact, above that each power of two is split into 32 sub-buckets, so any
+// recorded value is within about 3% of the truth. Recording is a single
+// relaxed fetch_add; count, percentiles and max are derived from the buckets
+// when a summary is taken.
+//
+// Build with -DLATENCY_STATS=0 to compile all recording out of
+// EventDispatcher and AsyncScheduler; the stats APIs then report no samples.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef LATENCY_STATS
+#define LATENCY_STATS 1
+#endif
+
+constexpr bool LATENCY_STATS_ENABLED = LATENCY_STATS != 0;
+
+// Cheapest monotonic timestamp available: the TSC on x86, steady_clock
+// nanoseconds elsewhere. Ticks are converted to nanoseconds only when a
+// summary is taken.
+class LatencyClock {
+public:
+    static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Measured once against steady_clock across a 10 ms sleep, then cached.
+    // The first call pays for the measurement, so code that takes summaries
+    // on a timer calls calibrate() up front instead of stalling the timer.
+    static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+        static const double ratio = measure_ns_per_tick();
+        return ratio;
+#else
+        return 1.0;
+#endif
+    }
+
+    static void calibrate() { ns_per_tick(); }
+
+private:
+    static double measure_ns_per_tick() {
+        uint64_t start_ticks = now();
+        auto start_time = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint64_t ticks = now() - start_ticks;
+        auto elapsed = std::chrono::steady_clock::now() - start_time;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(ticks);
+    }
+};
+
+// Picks one call in every mask + 1 on the calling thread; mask must be a
+// power of two minus one. Keeps clock reads off most events.
+inline bool sample_latency(uint32_t mask) noexcept {
+    thread_local uint32_t counter = 0;
+    return (++counter & mask) == 0;
+}
+
+// Rounds a 1-in-N sample rate to the mask sample_latency expects
+inline uint32_t latency_sample_mask(size_t one_in) {
+    return static_cast<uint32_t>(std::bit_ceil(std::clamp<size_t>(one_in, 1, size_t(1) << 31)) - 1);
+}
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_ns = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+class LatencyHistogram {
+public:
+    // Values are in LatencyClock ticks. A batch of events handled together
+    // can be recorded once with its per-event time and a count.
+    void record(uint64_t ticks, uint64_t count = 1) noexcept {
+        m_buckets[bucket_index(ticks)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Reads the buckets without stopping writers, so concurrent records may
+    // be partly included
+    LatencySummary summary() const {
+        uint64_t counts[BUCKET_COUNT];
+        LatencySummary summary;
+        double total = 0;
+        size_t highest = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            if (!counts[i]) continue;
+            summary.count += counts[i];
+            total += static_cast<double>(counts[i]) * (bucket_lowest(i) + bucket_highest(i)) / 2;
+            highest = i;
+        }
+        if (summary.count == 0) return summary;
+
+        double scale = LatencyClock::ns_per_tick();
+        auto percentile = [&](double fraction) {
+            uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * summary.count + 0.5));
+            uint64_t seen = 0;
+            for (size_t i = 0; i <= highest; ++i) {
+                seen += counts[i];
+                if (seen >= rank) return static_cast<uint64_t>(bucket_highest(i) * scale);
+            }
+            return static_cast<uint64_t>(bucket_highest(highest) * scale);
+        };
+        summary.mean_ns = total / summary.count * scale;
+        summary.p50_ns = percentile(0.5);
+        summary.p99_ns = percentile(0.99);
+        summary.p999_ns = percentile(0.999);
+        summary.max_ns = static_cast<uint64_t>(bucket_highest(highest) * scale);
+        return summary;
+    }
+
+    void reset() noexcept {
+        for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_BITS = 44; // About 1.5 hours at 3 GHz; longer values are clamped
+    static constexpr size_t BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucket_index(uint64_t value) noexcept {
+        value = std::min(value, (uint64_t(1) << MAX_BITS) - 1);
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + (value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t bucket_lowest(size_t index) noexcept {
+        if (index < SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    }
+
+    static uint64_t bucket_highest(size_t index) noexcept {
+        if (index < SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        return bucket_lowest(index) + (uint64_t(1) << shift) - 1;
+    }
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT] = {};
+};
+
+inline void write_latency_json(std::ostream& out, const LatencySummary& summary) {
+    out << "{\"count\":" << summary.count
+        << ",\"mean_ns\":" << static_cast<uint64_t>(summary.mean_ns)
+        << ",\"p50_ns\":" << summary.p50_ns
+        << ",\"p99_ns\":" << summary.p99_ns
+        << ",\"p999_ns\":" << summary.p999_ns
+        << ",\"max_ns\":" << summary.max_ns << "}";
+}
@@ -1,133 +1,1164 @@
 // MemoryManager.cpp - Implementation of a custom memory pool allocator.
-// Aims to reduce fragmentation and improve performance for fixed-size allocations.
+// Free blocks are indexed by a two-level segregated fit (TLSF) scheme, so both
+// allocate and deallocate run in O(1), and boundary tags let neighbouring free
+// blocks merge as soon as they are released.
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <mutex>
-#include <map>
-#include <list>
+#include <atomic>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
 #include "MemoryManager.h"
+#include "CoreUtils.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sched.h>
+#endif
 
 // A block header to store metadata for each allocation.
 struct BlockHeader {
-    size_t size;
+    size_t size;            // Payload size in bytes, excluding this header
+    BlockHeader* prev_phys; // Boundary tag: physically preceding block, nullptr for the first
+    const char* tag;        // For debugging
     bool is_free;
-    const char* tag; // For debugging
+    bool in_cache;          // Parked in a thread cache magazine or remote free list
+    uint16_t stats_slot;    // Tag slot the live bytes are charged to, see record_allocation
+    uint32_t owner;         // Thread cache slot that serves this block, 0 for none
+};
+
+// Free blocks keep their free list links in the (otherwise unused) payload.
+struct FreeLinks {
+    BlockHeader* next;
+    BlockHeader* prev;
 };
 
 // Ensure header is aligned to the maximum alignment requirement.
 constexpr size_t ALIGNMENT = alignof(std::max_align_t);
 
 static_assert(sizeof(BlockHeader) % ALIGNMENT == 0, "BlockHeader size must be a multiple of alignment");
+static_assert((ALIGNMENT & (ALIGNMENT - 1)) == 0, "ALIGNMENT must be a power of two");
+
+// Smallest payload a block may have; it must be able to hold the free list links.
+constexpr size_t MIN_BLOCK_SIZE = (sizeof(FreeLinks) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+constexpr size_t log2_constexpr(size_t n) {
+    return n <= 1 ? 0 : 1 + log2_constexpr(n / 2);
+}
+
+// Index of the most significant set bit. x must be non-zero.
+inline size_t highest_bit(uint64_t x) {
+    return 63 - __builtin_clzll(x);
+}
+
+// Index of the least significant set bit. x must be non-zero.
+inline size_t lowest_bit(uint64_t x) {
+    return __builtin_ctzll(x);
+}
+
+// Memory backing one arena, see map_region below.
+struct PoolRegion {
+    void* base = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+// Pool-wide usage, summed over every arena so the peak is that of the
+// total rather than a sum of per-arena peaks reached at different times.
+// Includes headers and blocks parked in thread caches.
+static std::atomic<size_t> g_used_bytes{0};
+static std::atomic<size_t> g_peak_used_bytes{0};
+
+// Two-level segregated fit index over the pool.
+// The first level splits sizes into power-of-two classes, the second level
+// splits each class linearly into SL_INDEX_COUNT bins. Requests below
+// SMALL_BLOCK_SIZE all live in the first class, binned by ALIGNMENT.
+struct PoolArena {
+    static constexpr size_t SL_INDEX_COUNT_LOG2 = 4;
+    static constexpr size_t SL_INDEX_COUNT = size_t(1) << SL_INDEX_COUNT_LOG2;
+    static constexpr size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + log2_constexpr(ALIGNMENT);
+    static constexpr size_t FL_INDEX_MAX = 40; // Blocks up to 1TB
+    static constexpr size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+    static constexpr size_t SMALL_BLOCK_SIZE = size_t(1) << FL_INDEX_SHIFT;
+
+    static_assert(FL_INDEX_COUNT <= 64, "First level bitmap must fit in 64 bits");
+    static_assert(SL_INDEX_COUNT <= 32, "Second level bitmap must fit in 32 bits");
+
+    PoolArena(void* memory, size_t size, int numa_node);
+
+    // Returns a block with a payload of at least aligned_size bytes, or nullptr.
+    BlockHeader* allocate(size_t aligned_size);
+    // Returns a block to the index, merging it with free physical neighbours.
+    void release(BlockHeader* block);
+    // Carves count physically adjacent blocks of aligned_size out of one free
+    // block. Returns false, taking nothing, if no free block is large enough.
+    bool allocate_run(size_t aligned_size, size_t count, BlockHeader** blocks);
+
+    bool contains(const void* ptr) const {
+        return ptr >= m_begin && ptr < m_end;
+    }
+
+    std::mutex mutex;   // Guards the index; each arena is locked independently
+    const int node;     // NUMA node the memory is bound to, -1 if unbound
+    PoolRegion backing; // Released by MemoryManager::shutdown
+
+    // Updated under mutex and readable at any time
+    std::atomic<size_t> free_block_count{0};
+
+    // Payload size of the largest free block. Caller must hold mutex.
+    size_t largest_free_block() const;
+
+private:
+    static FreeLinks* links(BlockHeader* block);
+    static void mapping_insert(size_t size, size_t& fl, size_t& sl);
+    static void mapping_search(size_t size, size_t& fl, size_t& sl);
+
+    BlockHeader* next_phys(BlockHeader* block) const;
+    BlockHeader* find_suitable_block(size_t& fl, size_t& sl) const;
+    void insert_free_block(BlockHeader* block);
+    void remove_free_block(BlockHeader* block);
+
+    char* m_begin;
+    char* m_end;
+
+    uint64_t m_fl_bitmap = 0;
+    uint32_t m_sl_bitmap[FL_INDEX_COUNT] = {};
+    BlockHeader* m_blocks[FL_INDEX_COUNT][SL_INDEX_COUNT] = {};
+};
+
+PoolArena::PoolArena(void* memory, size_t size, int numa_node)
+    : node(numa_node), m_begin(static_cast<char*>(memory)), m_end(static_cast<char*>(memory) + size) {
+    // Create the first free block
+    BlockHeader* first_block = reinterpret_cast<BlockHeader*>(m_begin);
+    first_block->size = size - sizeof(BlockHeader);
+    first_block->prev_phys = nullptr;
+    first_block->is_free = true;
+    first_block->in_cache = false;
+    first_block->owner = 0;
+    first_block->tag = "InitialPool";
+    insert_free_block(first_block);
+}
+
+FreeLinks* PoolArena::links(BlockHeader* block) {
+    return reinterpret_cast<FreeLinks*>(reinterpret_cast<char*>(block) + sizeof(BlockHeader));
+}
+
+void PoolArena::mapping_insert(size_t size, size_t& fl, size_t& sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        fl = 0;
+        sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+    } else {
+        size_t bit = highest_bit(size);
+        sl = (size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        fl = bit - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+void PoolArena::mapping_search(size_t size, size_t& fl, size_t& sl) {
+    // Round up to the next bin so any block found there is large enough.
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += (size_t(1) << (highest_bit(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+BlockHeader* PoolArena::next_phys(BlockHeader* block) const {
+    char* next = reinterpret_cast<char*>(block) + sizeof(BlockHeader) + block->size;
+    return next < m_end ? reinterpret_cast<BlockHeader*>(next) : nullptr;
+}
+
+BlockHeader* PoolArena::find_suitable_block(size_t& fl, size_t& sl) const {
+    if (fl >= FL_INDEX_COUNT) return nullptr;
+
+    uint32_t sl_map = m_sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        // Nothing left in this class, move on to the next non-empty one.
+        uint64_t fl_map = (fl + 1 < 64) ? (m_fl_bitmap & (~uint64_t(0) << (fl + 1))) : 0;
+        if (!fl_map) return nullptr;
+        fl = lowest_bit(fl_map);
+        sl_map = m_sl_bitmap[fl];
+    }
+    sl = lowest_bit(sl_map);
+    return m_blocks[fl][sl];
+}
+
+void PoolArena::insert_free_block(BlockHeader* block) {
+    size_t fl, sl;
+    mapping_insert(block->size, fl, sl);
+
+    BlockHeader* head = m_blocks[fl][sl];
+    links(block)->next = head;
+    links(block)->prev = nullptr;
+    if (head) links(head)->prev = block;
+    m_blocks[fl][sl] = block;
+
+    m_fl_bitmap |= uint64_t(1) << fl;
+    m_sl_bitmap[fl] |= 1u << sl;
+    free_block_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PoolArena::remove_free_block(BlockHeader* block) {
+    size_t fl, sl;
+    mapping_insert(block->size, fl, sl);
+
+    FreeLinks* l = links(block);
+    if (l->next) links(l->next)->prev = l->prev;
+    if (l->prev) links(l->prev)->next = l->next;
+
+    if (m_blocks[fl][sl] == block) {
+        m_blocks[fl][sl] = l->next;
+        if (!l->next) {
+            m_sl_bitmap[fl] &= ~(1u << sl);
+            if (!m_sl_bitmap[fl]) m_fl_bitmap &= ~(uint64_t(1) << fl);
+        }
+    }
+    free_block_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+size_t PoolArena::largest_free_block() const {
+    if (!m_fl_bitmap) return 0;
+
+    // Only the highest non-empty bin can hold the largest block
+    size_t fl = highest_bit(m_fl_bitmap);
+    size_t sl = highest_bit(m_sl_bitmap[fl]);
+    size_t largest = 0;
+    for (BlockHeader* block = m_blocks[fl][sl]; block; block = links(block)->next) {
+        largest = std::max(largest, block->size);
+    }
+    return largest;
+}
+
+BlockHeader* PoolArena::allocate(size_t aligned_size) {
+    if (aligned_size < MIN_BLOCK_SIZE) aligned_size = MIN_BLOCK_SIZE;
+
+    size_t fl, sl;
+    mapping_search(aligned_size, fl, sl);
+    BlockHeader* block = find_suitable_block(fl, sl);
+    if (!block) return nullptr;
+
+    remove_free_block(block);
+
+    // Split off the tail if it is large enough to be a block of its own
+    size_t remaining_size = block->size - aligned_size;
+    if (remaining_size >= sizeof(BlockHeader) + MIN_BLOCK_SIZE) {
+        BlockHeader* new_block = reinterpret_cast<BlockHeader*>(
+            reinterpret_cast<char*>(block) + sizeof(BlockHeader) + aligned_size
+        );
+        new_block->size = remaining_size - sizeof(BlockHeader);
+        new_block->prev_phys = block;
+        new_block->is_free = true;
+        new_block->in_cache = false;
+        new_block->owner = 0;
+        new_block->tag = "SplitBlock";
+
+        if (BlockHeader* next = next_phys(new_block)) next->prev_phys = new_block;
+        block->size = aligned_size;
+        insert_free_block(new_block);
+    }
+
+    block->is_free = false;
+
+    // Arenas update the totals concurrently, so the peak is raised with a CAS
+    size_t used = g_used_bytes.fetch_add(sizeof(BlockHeader) + block->size, std::memory_order_relaxed)
+                  + sizeof(BlockHeader) + block->size;
+    size_t peak = g_peak_used_bytes.load(std::memory_order_relaxed);
+    while (used > peak && !g_peak_used_bytes.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+    return block;
+}
+
+bool PoolArena::allocate_run(size_t aligned_size, size_t count, BlockHeader** blocks) {
+    if (aligned_size < MIN_BLOCK_SIZE) aligned_size = MIN_BLOCK_SIZE;
+    size_t stride = sizeof(BlockHeader) + aligned_size;
+    BlockHeader* run = allocate(stride * count - sizeof(BlockHeader));
+    if (!run) return false;
+
+    // The last block keeps whatever the run got beyond the request
+    char* end = reinterpret_cast<char*>(run) + sizeof(BlockHeader) + run->size;
+    BlockHeader* next = next_phys(run);
+    BlockHeader* prev = run->prev_phys;
+    for (size_t i = 0; i < count; ++i) {
+        BlockHeader* block = reinterpret_cast<BlockHeader*>(reinterpret_cast<char*>(run) + i * stride);
+        block->size = i + 1 < count ? aligned_size : end - reinterpret_cast<char*>(block) - sizeof(BlockHeader);
+        block->prev_phys = prev;
+        block->is_free = false;
+        block->in_cache = false;
+        block->owner = 0;
+        blocks[i] = block;
+        prev = block;
+    }
+    if (next) next->prev_phys = prev;
+    return true;
+}
+
+void PoolArena::release(BlockHeader* block) {
+    block->is_free = true;
+    g_used_bytes.fetch_sub(sizeof(BlockHeader) + block->size, std::memory_order_relaxed);
+
+    // Merge with the preceding block
+    BlockHeader* prev = block->prev_phys;
+    if (prev && prev->is_free) {
+        remove_free_block(prev);
+        prev->size += sizeof(BlockHeader) + block->size;
+        block = prev;
+    }
+
+    // Merge with the following block
+    BlockHeader* next = next_phys(block);
+    if (next && next->is_free) {
+        remove_free_block(next);
+        block->size += sizeof(BlockHeader) + next->size;
+        next = next_phys(block);
+    }
+    if (next) next->prev_phys = block;
+
+    insert_free_block(block);
+}
+
+// Backing memory for the pool. Regions come from ::operator new unless huge
+// pages or NUMA placement are requested, in which case they are mapped directly.
+constexpr size_t PAGE_SIZE_4K = 4096;
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Parses a sysfs list such as "0-3,8,10-11".
+static std::vector<int> parse_id_list(const std::string& list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0]))) continue;
+        auto dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int id = first; id <= last; ++id) ids.push_back(id);
+    }
+    return ids;
+}
+
+static std::string read_sysfs_line(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Maps every CPU id to its NUMA node. Empty if the topology is unavailable.
+static std::vector<int> read_cpu_nodes(std::vector<int>& nodes) {
+    std::vector<int> cpu_nodes;
+    nodes = parse_id_list(read_sysfs_line("/sys/devices/system/node/online"));
+    for (int node : nodes) {
+        std::string cpulist = read_sysfs_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        for (int cpu : parse_id_list(cpulist)) {
+            if (static_cast<size_t>(cpu) >= cpu_nodes.size()) cpu_nodes.resize(cpu + 1, -1);
+            cpu_nodes[cpu] = node;
+        }
+    }
+    return cpu_nodes;
+}
+
+#if defined(__linux__)
+// MPOL_PREFERRED from <numaif.h>, spelled out to avoid a libnuma dependency.
+// Preferred rather than bind, so a full node spills over instead of failing.
+constexpr int MPOL_PREFERRED_POLICY = 1;
+constexpr int MAX_NUMA_NODES = 256;
+
+static void bind_to_node(void* base, size_t size, int node) {
+    if (node < 0 || node >= MAX_NUMA_NODES) return;
+    unsigned long nodemask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+    nodemask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    // The kernel treats maxnode as one past the last valid bit
+    if (syscall(SYS_mbind, base, size, MPOL_PREFERRED_POLICY, nodemask, MAX_NUMA_NODES + 1, 0) != 0) {
+        std::cerr << "Warning: MemoryManager could not bind pool to NUMA node " << node << "." << std::endl;
+    }
+}
+
+static PoolRegion map_anonymous(size_t size, const MemoryPoolOptions& options) {
+    PoolRegion region;
+
+    if (options.huge_pages == HugePageMode::Explicit) {
+        size_t huge_size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void* base = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            region.base = base;
+            region.size = huge_size;
+            region.mapped = true;
+            return region;
+        }
+        std::cerr << "Warning: MAP_HUGETLB pages unavailable, falling back to transparent huge pages." << std::endl;
+    }
+
+    // Over-map by one huge page so the region can start on a huge page boundary
+    size_t region_size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    size_t map_size = region_size + HUGE_PAGE_SIZE;
+    void* raw = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return region;
+
+    char* start = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    size_t head = start - static_cast<char*>(raw);
+    size_t tail = map_size - head - region_size;
+    if (head) munmap(raw, head);
+    if (tail) munmap(start + region_size, tail);
+
+    region.base = start;
+    region.size = region_size;
+    region.mapped = true;
+
+    if (options.huge_pages != HugePageMode::None &&
+        madvise(region.base, region.size, MADV_HUGEPAGE) != 0) {
+        std::cerr << "Warning: Transparent huge pages unavailable for the MemoryManager pool." << std::endl;
+    }
+    return region;
+}
+#endif
+
+static PoolRegion map_region(size_t size, const MemoryPoolOptions& options, int node) {
+    PoolRegion region;
+#if defined(__linux__)
+    if (options.huge_pages != HugePageMode::None || node >= 0) {
+        region = map_anonymous(size, options);
+        if (region.base) bind_to_node(region.base, region.size, node);
+    }
+#endif
+    if (!region.base) {
+        region.base = ::operator new(size);
+        region.size = size;
+        region.mapped = false;
+    }
+
+    if (options.prefault) {
+        // Touch every page now so the first allocations don't take the faults
+        volatile char* bytes = static_cast<char*>(region.base);
+        for (size_t offset = 0; offset < region.size; offset += PAGE_SIZE_4K) {
+            bytes[offset] = 0;
+        }
+    }
+    return region;
+}
+
+static void unmap_region(const PoolRegion& region) {
+#if defined(__linux__)
+    if (region.mapped) {
+        munmap(region.base, region.size);
+        return;
+    }
+#endif
+    ::operator delete(region.base);
+}
+
+// Per-thread magazines of small blocks in front of the shared arena.
+// Each thread owns one magazine per size class. Allocations and frees of
+// small blocks hit the magazine without locking; the arena mutex is only
+// taken to refill or drain a magazine in batches. Every cached block
+// remembers the slot of the cache that serves it, so a block freed on
+// another thread is pushed onto that cache's lock-free remote free list
+// instead of into the wrong thread's magazine.
+constexpr size_t CACHE_MAX_SIZE = 256;
+constexpr size_t CACHE_CLASS_COUNT = CACHE_MAX_SIZE / ALIGNMENT;
+constexpr size_t MAGAZINE_CAPACITY = 64;
+constexpr size_t MAGAZINE_BATCH = MAGAZINE_CAPACITY / 2;
+constexpr uint32_t MAX_THREAD_CACHES = 256; // Slot 0 is reserved for "no owner"
+
+static_assert(CACHE_MAX_SIZE % ALIGNMENT == 0, "Cached size classes must be aligned");
+
+// Size class that a block of the given (aligned) payload size can serve.
+inline size_t cache_class(size_t size) {
+    return std::min(std::max(size, MIN_BLOCK_SIZE), CACHE_MAX_SIZE) / ALIGNMENT - 1;
+}
+
+inline void* payload(BlockHeader* block) {
+    return reinterpret_cast<char*>(block) + sizeof(BlockHeader);
+}
+
+inline BlockHeader*& remote_next(BlockHeader* block) {
+    return *reinterpret_cast<BlockHeader**>(payload(block));
+}
+
+// Shared part of a thread cache, reachable from other threads by slot id.
+struct ThreadCacheSlot {
+    std::atomic<bool> in_use{false};
+    std::atomic<BlockHeader*> remote_free{nullptr};
+};
+
+static ThreadCacheSlot g_cache_slots[MAX_THREAD_CACHES];
+
+struct ThreadCache {
+    struct Magazine {
+        BlockHeader* blocks[MAGAZINE_CAPACITY];
+        size_t count = 0;
+    };
+
+    ~ThreadCache();
+
+    // Claims a slot and drops magazines left over from an earlier pool.
+    // Returns false if the cache cannot be used and callers must go to the arena.
+    bool attach(MemoryManager& mm, uint64_t generation);
+
+    BlockHeader* pop(MemoryManager& mm, size_t cls);
+    void push(MemoryManager& mm, BlockHeader* block);
+
+    void refill(MemoryManager& mm, size_t cls);
+    void drain(MemoryManager& mm, size_t cls, size_t count);
+    void collect_remote_frees(MemoryManager& mm);
+    void flush(MemoryManager& mm);
+
+    // Returns blocks on a released slot's remote free list to their arenas.
+    static void release_remote_frees(MemoryManager& mm, uint32_t slot);
+
+    uint32_t id = 0;
+    uint64_t generation = 0;
+    bool exhausted = false; // No free slot was left for this thread
+    Magazine magazines[CACHE_CLASS_COUNT];
+};
+
+static ThreadCache& local_cache() {
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+bool ThreadCache::attach(MemoryManager& mm, uint64_t current_generation) {
+    if (generation != current_generation) {
+        // The pool was reset underneath us, the cached pointers are gone.
+        for (auto& magazine : magazines) magazine.count = 0;
+        generation = current_generation;
+    }
+    if (id != 0) return true;
+    if (exhausted) return false;
+
+    for (uint32_t slot = 1; slot < MAX_THREAD_CACHES; ++slot) {
+        bool expected = false;
+        if (g_cache_slots[slot].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            id = slot;
+            // Pick up anything freed to this slot after its previous owner exited.
+            collect_remote_frees(mm);
+            return true;
+        }
+    }
+    exhausted = true;
+    return false;
+}
+
+BlockHeader* ThreadCache::pop(MemoryManager& mm, size_t cls) {
+    Magazine& magazine = magazines[cls];
+    if (magazine.count == 0) {
+        refill(mm, cls);
+        if (magazine.count == 0) return nullptr;
+    }
+    return magazine.blocks[--magazine.count];
+}
+
+void ThreadCache::push(MemoryManager& mm, BlockHeader* block) {
+    size_t cls = cache_class(block->size);
+    Magazine& magazine = magazines[cls];
+    if (magazine.count == MAGAZINE_CAPACITY) {
+        drain(mm, cls, MAGAZINE_BATCH);
+    }
+    block->in_cache = true;
+    block->tag = "ThreadCache";
+    magazine.blocks[magazine.count++] = block;
+}
+
+void ThreadCache::refill(MemoryManager& mm, size_t cls) {
+    collect_remote_frees(mm);
+    Magazine& magazine = magazines[cls];
+    if (magazine.count > 0) return;
+
+    if (mm.m_generation.load(std::memory_order_acquire) != generation) return;
+
+    // Take the batch as one contiguous run where possible. Blocks picked
+    // one by one land in whatever holes TLSF finds and, parked in magazines
+    // across the whole pool, keep large free ranges from merging.
+    size_t class_size = (cls + 1) * ALIGNMENT;
+    PoolArena& arena = mm.local_arena();
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    if (arena.allocate_run(class_size, MAGAZINE_BATCH, magazine.blocks)) {
+        // Lowest address on top, so pops walk the run in order
+        std::reverse(magazine.blocks, magazine.blocks + MAGAZINE_BATCH);
+        magazine.count = MAGAZINE_BATCH;
+    }
+    while (magazine.count < MAGAZINE_BATCH) {
+        BlockHeader* block = arena.allocate(class_size);
+        if (!block) break;
+        magazine.blocks[magazine.count++] = block;
+    }
+    for (size_t i = 0; i < magazine.count; ++i) {
+        magazine.blocks[i]->owner = id;
+        magazine.blocks[i]->in_cache = true;
+        magazine.blocks[i]->tag = "ThreadCache";
+    }
+}
+
+void ThreadCache::drain(MemoryManager& mm, size_t cls, size_t count) {
+    Magazine& magazine = magazines[cls];
+    count = std::min(count, magazine.count);
+
+    if (mm.m_generation.load(std::memory_order_acquire) != generation) {
+        magazine.count = 0;
+        return;
+    }
+
+    // Blocks may come from several arenas if this thread moved between nodes
+    std::unique_lock<std::mutex> lock;
+    PoolArena* locked_arena = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        BlockHeader* block = magazine.blocks[--magazine.count];
+        PoolArena* arena = mm.arena_for(block);
+        if (arena != locked_arena) {
+            lock = std::unique_lock<std::mutex>(arena->mutex);
+            locked_arena = arena;
+        }
+        block->owner = 0;
+        block->in_cache = false;
+        block->tag = "FreedBlock";
+        arena->release(block);
+    }
+}
+
+void ThreadCache::collect_remote_frees(MemoryManager& mm) {
+    if (id == 0) return;
+    BlockHeader* block = g_cache_slots[id].remote_free.exchange(nullptr, std::memory_order_seq_cst);
+    while (block) {
+        BlockHeader* next = remote_next(block);
+        push(mm, block);
+        block = next;
+    }
+}
+
+void ThreadCache::flush(MemoryManager& mm) {
+    collect_remote_frees(mm);
+    for (size_t cls = 0; cls < CACHE_CLASS_COUNT; ++cls) {
+        drain(mm, cls, MAGAZINE_CAPACITY);
+    }
+}
+
+void ThreadCache::release_remote_frees(MemoryManager& mm, uint32_t slot) {
+    BlockHeader* block = g_cache_slots[slot].remote_free.exchange(nullptr, std::memory_order_seq_cst);
+    if (!block || !(mm.m_generation.load(std::memory_order_acquire) & 1)) return;
+
+    std::unique_lock<std::mutex> lock;
+    PoolArena* locked_arena = nullptr;
+    while (block) {
+        // Read the link first, release reuses the payload for free list links
+        BlockHeader* next = remote_next(block);
+        if (PoolArena* arena = mm.arena_for(block)) {
+            if (arena != locked_arena) {
+                lock = std::unique_lock<std::mutex>(arena->mutex);
+                locked_arena = arena;
+            }
+            block->owner = 0;
+            block->in_cache = false;
+            block->tag = "FreedBlock";
+            arena->release(block);
+        }
+        block = next;
+    }
+}
+
+ThreadCache::~ThreadCache() {
+    if (id == 0) return;
+    // Pairs with the re-check in MemoryManager::deallocate: a remote free
+    // either lands before the flush below collects the list, or its pusher
+    // sees the slot released and returns the list to the arenas itself.
+    g_cache_slots[id].in_use.store(false, std::memory_order_seq_cst);
+    flush(MemoryManager::getInstance());
+    id = 0;
+}
+
+// Allocation telemetry. Every thread owns a shard of counters and is its
+// only writer, so the hot path updates them with plain relaxed stores rather
+// than atomic read-modify-writes on shared cache lines; a snapshot sums the
+// shards without stopping allocations. A shard keeps its counts when its
+// thread exits and is handed to the next thread that needs one. Threads
+// beyond MAX_STATS_SHARDS share slot 0, which is updated with atomic adds.
+constexpr size_t MAX_STATS_TAGS = 128; // Slot 0 collects tags that did not fit
+constexpr size_t MAX_STATS_SHARDS = 256;
+constexpr size_t SIZE_HISTOGRAM_BUCKETS = 64;
+
+// Bytes a thread may charge to one tag before adding them to the tag's
+// shared total, which raises the tag's high-water mark as it goes.
+constexpr int64_t STATS_PUBLISH_BYTES = 64 * 1024;
+
+// One tag's counters share a cache line, so an allocation touches one line
+// for its tag and one for the size histogram.
+struct TagCounters {
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> live_blocks;
+    std::atomic<uint64_t> allocations;
+    int64_t published_bytes; // Owner only, live_bytes last added to the tag total
+};
+
+struct alignas(64) StatsShard {
+    std::atomic<bool> in_use{false};
+    alignas(64) TagCounters tags[MAX_STATS_TAGS];
+    std::atomic<uint64_t> size_histogram[SIZE_HISTOGRAM_BUCKETS];
+};
+
+static StatsShard g_stats_shards[MAX_STATS_SHARDS];
+static std::atomic<const char*> g_stats_tags[MAX_STATS_TAGS];
+static std::atomic<int64_t> g_stats_tag_published[MAX_STATS_TAGS];
+static std::atomic<int64_t> g_stats_tag_peaks[MAX_STATS_TAGS];
+
+// Plain pointer, so allocations made while thread locals are being destroyed
+// still find a shard: the owner below points it at the shared slot on exit.
+static thread_local StatsShard* t_stats_shard = nullptr;
+
+struct StatsShardOwner {
+    ~StatsShardOwner() {
+        t_stats_shard = &g_stats_shards[0];
+        if (shard) shard->in_use.store(false, std::memory_order_release);
+    }
+    StatsShard* shard = nullptr;
+};
+
+static StatsShard& claim_stats_shard() {
+    static thread_local StatsShardOwner owner;
+    t_stats_shard = &g_stats_shards[0];
+    for (size_t i = 1; i < MAX_STATS_SHARDS; ++i) {
+        bool expected = false;
+        if (g_stats_shards[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            owner.shard = t_stats_shard = &g_stats_shards[i];
+            break;
+        }
+    }
+    return *t_stats_shard;
+}
+
+static StatsShard& local_stats_shard() {
+    if (StatsShard* shard = t_stats_shard) return *shard;
+    return claim_stats_shard();
+}
+
+// Raises a tag's shared total by delta and its high-water mark to match.
+static void publish_tag_bytes(uint16_t slot, int64_t delta) {
+    int64_t total = g_stats_tag_published[slot].fetch_add(delta, std::memory_order_relaxed) + delta;
+    int64_t peak = g_stats_tag_peaks[slot].load(std::memory_order_relaxed);
+    while (total > peak && !g_stats_tag_peaks[slot].compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+}
+
+// Updates a counter only this thread writes
+template<typename T>
+inline void bump(std::atomic<T>& counter, T delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+static void record_shared(uint16_t slot, int64_t bytes, int64_t blocks, uint64_t allocations, size_t bucket) {
+    StatsShard& shard = g_stats_shards[0];
+    shard.tags[slot].live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    shard.tags[slot].live_blocks.fetch_add(blocks, std::memory_order_relaxed);
+    if (allocations) {
+        shard.tags[slot].allocations.fetch_add(allocations, std::memory_order_relaxed);
+        shard.size_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+    publish_tag_bytes(slot, bytes);
+}
+
+// Charges bytes to the tag in this thread's shard, publishing once the
+// shard's live bytes drift STATS_PUBLISH_BYTES from what it last published.
+inline void charge_tag(TagCounters& counters, uint16_t slot, int64_t bytes, int64_t blocks) {
+    int64_t live = counters.live_bytes.load(std::memory_order_relaxed) + bytes;
+    counters.live_bytes.store(live, std::memory_order_relaxed);
+    bump<int64_t>(counters.live_blocks, blocks);
+    int64_t unpublished = live - counters.published_bytes;
+    if (unpublished >= STATS_PUBLISH_BYTES || unpublished <= -STATS_PUBLISH_BYTES) {
+        counters.published_bytes = live;
+        publish_tag_bytes(slot, unpublished);
+    }
+}
+
+static uint64_t tag_hash(const char* tag) {
+    uint64_t hash = 0xCBF29CE484222325;
+    for (; *tag; ++tag) {
+        hash = (hash ^ static_cast<unsigned char>(*tag)) * 0x100000001B3;
+    }
+    return hash;
+}
+
+// Maps a tag to its stats slot by probing the shared tag table. Tags with
+// equal text share a slot.
+static uint16_t lookup_stats_slot(const char* tag) {
+    size_t start = tag_hash(tag) % (MAX_STATS_TAGS - 1);
+    for (size_t i = 0; i < MAX_STATS_TAGS - 1; ++i) {
+        size_t slot = 1 + (start + i) % (MAX_STATS_TAGS - 1);
+        const char* name = g_stats_tags[slot].load(std::memory_order_acquire);
+        if (!name && g_stats_tags[slot].compare_exchange_strong(name, tag, std::memory_order_acq_rel)) {
+            name = tag;
+        }
+        if (name == tag || std::strcmp(name, tag) == 0) return static_cast<uint16_t>(slot);
+    }
+    return 0;
+}
+
+// Tags are nearly always string literals, so each thread remembers the slots
+// of recent tag pointers and only probes the table on a miss.
+inline uint16_t find_stats_slot(const char* tag) {
+    if (!tag) return 0;
+
+    struct CachedTag {
+        const char* tag;
+        uint16_t slot;
+    };
+    static thread_local CachedTag cache[16];
+    CachedTag& cached = cache[(reinterpret_cast<uintptr_t>(tag) >> 3) & 15];
+    if (cached.tag != tag) cached = CachedTag{tag, lookup_stats_slot(tag)};
+    return cached.slot;
+}
+
+inline void record_allocation(BlockHeader* block, size_t requested_size) {
+    StatsShard& shard = local_stats_shard();
+    uint16_t slot = find_stats_slot(block->tag);
+    block->stats_slot = slot;
+    size_t bucket = highest_bit(requested_size | 1);
+    if (&shard == &g_stats_shards[0]) {
+        record_shared(slot, block->size, 1, 1, bucket);
+        return;
+    }
+    charge_tag(shard.tags[slot], slot, block->size, 1);
+    bump<uint64_t>(shard.tags[slot].allocations, 1);
+    bump<uint64_t>(shard.size_histogram[bucket], 1);
+}
+
+inline void record_free(BlockHeader* block) {
+    StatsShard& shard = local_stats_shard();
+    int64_t bytes = -static_cast<int64_t>(block->size);
+    if (&shard == &g_stats_shards[0]) {
+        record_shared(block->stats_slot, bytes, -1, 0, 0);
+        return;
+    }
+    charge_tag(shard.tags[block->stats_slot], block->stats_slot, bytes, -1);
+}
+
+// Counters restart with each pool; tag slots are kept since threads cache them.
+static void reset_stats() {
+    for (auto& shard : g_stats_shards) {
+        for (auto& counters : shard.tags) {
+            counters.live_bytes.store(0, std::memory_order_relaxed);
+            counters.live_blocks.store(0, std::memory_order_relaxed);
+            counters.allocations.store(0, std::memory_order_relaxed);
+            counters.published_bytes = 0;
+        }
+        for (auto& bucket : shard.size_histogram) bucket.store(0, std::memory_order_relaxed);
+    }
+    for (auto& total : g_stats_tag_published) total.store(0, std::memory_order_relaxed);
+    for (auto& peak : g_stats_tag_peaks) peak.store(0, std::memory_order_relaxed);
+    g_used_bytes.store(0, std::memory_order_relaxed);
+    g_peak_used_bytes.store(0, std::memory_order_relaxed);
+}
 
 MemoryManager& MemoryManager::getInstance() {
     static MemoryManager instance;
     return instance;
 }
 
-void MemoryManager::initialize(size_t total_size) {
+void MemoryManager::initialize(size_t total_size, const MemoryPoolOptions& options) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_pool) {
+    if (!m_arenas.empty()) {
         std::cerr << "Warning: MemoryManager already initialized." << std::endl;
         return;
     }
-    
-    m_pool_size = total_size;
-    m_pool = ::operator new(m_pool_size);
-    
-    // Create the first free block
-    BlockHeader* first_block = reinterpret_cast<BlockHeader*>(m_pool);
-    first_block->size = m_pool_size - sizeof(BlockHeader);
-    first_block->is_free = true;
-    first_block->tag = "InitialPool";
-    
-    m_free_list.push_back(first_block);
-    
-    std::cout << "MemoryManager initialized with " << m_pool_size / (1024*1024) << "MB pool." << std::endl;
+
+    // One sub-pool per NUMA node when requested and the machine has several
+    std::vector<int> nodes;
+    std::vector<int> cpu_nodes;
+    if (options.numa_aware) {
+        cpu_nodes = read_cpu_nodes(nodes);
+    }
+    if (nodes.size() <= 1) {
+        nodes.assign(1, -1);
+        cpu_nodes.clear();
+    }
+
+    // Keep every block boundary aligned
+    size_t arena_size = (total_size / nodes.size()) & ~(ALIGNMENT - 1);
+    if (arena_size < sizeof(BlockHeader) + MIN_BLOCK_SIZE) {
+        throw std::invalid_argument("MemoryManager pool size is too small.");
+    }
+
+    for (int node : nodes) {
+        PoolRegion region = map_region(arena_size, options, node);
+        m_arenas.push_back(std::make_unique<PoolArena>(region.base, arena_size, node));
+        m_arenas.back()->backing = region;
+    }
+
+    m_cpu_to_arena.assign(cpu_nodes.size(), 0);
+    for (size_t cpu = 0; cpu < cpu_nodes.size(); ++cpu) {
+        auto it = std::find(nodes.begin(), nodes.end(), cpu_nodes[cpu]);
+        if (it != nodes.end()) m_cpu_to_arena[cpu] = static_cast<size_t>(it - nodes.begin());
+    }
+
+    m_pool_size = arena_size * m_arenas.size();
+    reset_stats();
+    m_generation.fetch_add(1, std::memory_order_release);
+
+    std::cout << "MemoryManager initialized with " << m_pool_size / (1024*1024) << "MB pool";
+    if (m_arenas.size() > 1) std::cout << " across " << m_arenas.size() << " NUMA nodes";
+    std::cout << "." << std::endl;
 }
 
-void* MemoryManager::allocate(size_t size, const char* tag) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+PoolArena& MemoryManager::local_arena() {
+#if defined(__linux__)
+    if (m_arenas.size() > 1) {
+        int cpu = sched_getcpu();
+        if (cpu >= 0 && static_cast<size_t>(cpu) < m_cpu_to_arena.size()) {
+            return *m_arenas[m_cpu_to_arena[cpu]];
+        }
+    }
+#endif
+    return *m_arenas.front();
+}
 
-    if (!m_pool) {
-        throw std::runtime_error("MemoryManager not initialized.");
+PoolArena* MemoryManager::arena_for(const void* ptr) {
+    for (auto& arena : m_arenas) {
+        if (arena->contains(ptr)) return arena.get();
+    }
+    return nullptr;
+}
+
+bool MemoryManager::owns(const void* ptr) {
+    return arena_for(ptr) != nullptr;
+}
+
+BlockHeader* MemoryManager::allocate_block(size_t aligned_size) {
+    PoolArena& local = local_arena();
+    {
+        std::lock_guard<std::mutex> lock(local.mutex);
+        if (BlockHeader* block = local.allocate(aligned_size)) return block;
+    }
+
+    // The local node is exhausted, spill over to the others
+    for (auto& arena : m_arenas) {
+        if (arena.get() == &local) continue;
+        std::lock_guard<std::mutex> lock(arena->mutex);
+        if (BlockHeader* block = arena->allocate(aligned_size)) return block;
     }
-    
+    return nullptr;
+}
+
+void* MemoryManager::allocate(size_t size, const char* tag) {
     // Align requested size
     size_t aligned_size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
-    
-    // First-fit search for a free block
-    for (auto it = m_free_list.begin(); it != m_free_list.end(); ++it) {
-        BlockHeader* block = *it;
-        if (block->is_free && block->size >= aligned_size) {
-            // Found a suitable block, now see if we can split it
-            size_t remaining_size = block->size - aligned_size;
-            
-            if (remaining_size > sizeof(BlockHeader) + ALIGNMENT) {
-                // Split the block
-                BlockHeader* new_block = reinterpret_cast<BlockHeader*>(
-                    reinterpret_cast<char*>(block) + sizeof(BlockHeader) + aligned_size
-                );
-                new_block->size = remaining_size - sizeof(BlockHeader);
-                new_block->is_free = true;
-                new_block->tag = "SplitBlock";
-                
-                block->size = aligned_size;
-                m_free_list.insert(std::next(it), new_block);
+
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+    if (!(generation & 1)) {
+        throw std::runtime_error("MemoryManager not initialized.");
+    }
+
+    // Small blocks come from this thread's magazine without locking
+    if (aligned_size <= CACHE_MAX_SIZE) {
+        ThreadCache& cache = local_cache();
+        if (cache.attach(*this, generation)) {
+            if (BlockHeader* block = cache.pop(*this, cache_class(aligned_size))) {
+                block->in_cache = false;
+                block->tag = tag;
+                record_allocation(block, size);
+                return payload(block);
             }
-            
-            block->is_free = false;
-            block->tag = tag;
-            m_free_list.erase(it);
-            
-            // Return pointer to the data area, just after the header
-            return reinterpret_cast<char*>(block) + sizeof(BlockHeader);
-        }
-    }
-    
-    // Out of memory
-    std::cerr << "MemoryManager: Out of memory for allocation of " << size << " bytes." << std::endl;
-    return nullptr;
+        }
+    }
+
+    BlockHeader* block = allocate_block(aligned_size);
+    if (!block) {
+        // Out of memory
+        std::cerr << "MemoryManager: Out of memory for allocation of " << size << " bytes." << std::endl;
+        return nullptr;
+    }
+
+    block->tag = tag;
+    record_allocation(block, size);
+
+    // Return pointer to the data area, just after the header
+    return payload(block);
 }
 
 void MemoryManager::deallocate(void* ptr, const char* tag) {
     if (!ptr) return;
-    
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
+
     // Get the header from the pointer
     BlockHeader* block = reinterpret_cast<BlockHeader*>(
         reinterpret_cast<char*>(ptr) - sizeof(BlockHeader)
     );
-    
-    if (block->is_free) {
-        std::cerr << "Warning: Double free detected for tag: " << (block->tag ? block->tag : "unknown") << std::endl;
+
+    if (block->is_free || block->in_cache) {
+        // The block's own tag now only says where it went, so name the caller's
+        std::cerr << "Warning: Double free detected for tag: " << (tag ? tag : "unknown")
+                  << " (block is " << (block->tag ? block->tag : "unknown") << ")." << std::endl;
         return;
     }
-    
-    block->is_free = true;
+
+    record_free(block);
+
+    if (block->owner != 0) {
+        uint64_t generation = m_generation.load(std::memory_order_acquire);
+        ThreadCache& cache = local_cache();
+        if (cache.attach(*this, generation) && cache.id == block->owner) {
+            cache.push(*this, block);
+            return;
+        }
+
+        // Cross-thread free: hand the block back to the cache that owns it.
+        uint32_t owner = block->owner;
+        ThreadCacheSlot& slot = g_cache_slots[owner];
+        if (slot.in_use.load(std::memory_order_acquire)) {
+            block->in_cache = true;
+            block->tag = "RemoteFree";
+            BlockHeader* head = slot.remote_free.load(std::memory_order_relaxed);
+            do {
+                remote_next(block) = head;
+            } while (!slot.remote_free.compare_exchange_weak(head, block,
+                         std::memory_order_seq_cst, std::memory_order_relaxed));
+            // The owner may have exited between the check and the push, after
+            // its last look at the list; nobody would collect the block then.
+            if (!slot.in_use.load(std::memory_order_seq_cst)) {
+                ThreadCache::release_remote_frees(*this, owner);
+            }
+            return;
+        }
+        block->owner = 0;
+    }
+
+    PoolArena* arena = arena_for(block);
+    if (!arena) return;
+
+    std::lock_guard<std::mutex> lock(arena->mutex);
     block->tag = "FreedBlock";
-    
-    // Coalesce with adjacent free blocks (simplified logic)
-    // In a real implementation, this would be more complex.
-    m_free_list.push_back(block);
-    m_free_list.sort([](const BlockHeader* a, const BlockHeader* b){
-        return a < b;
-    });
+    arena->release(block);
 }
 
 void MemoryManager::shutdown() {
+    stop_stats_dump();
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    if(m_pool) {
-        ::operator delete(m_pool);
-        m_pool = nullptr;
+    if (!m_arenas.empty()) {
+        m_generation.fetch_add(1, std::memory_order_release);
+        for (auto& slot : g_cache_slots) {
+            slot.remote_free.store(nullptr, std::memory_order_relaxed);
+        }
+        for (auto& arena : m_arenas) {
+            PoolRegion region = arena->backing;
+            arena.reset();
+            unmap_region(region);
+        }
+        m_arenas.clear();
+        m_cpu_to_arena.clear();
         m_pool_size = 0;
-        m_free_list.clear();
         std::cout << "MemoryManager pool released." << std::endl;
     }
 }
 
+size_t MemoryManager::used_bytes() const {
+    return g_used_bytes.load(std::memory_order_relaxed);
+}
+
+MemoryStats MemoryManager::get_stats() {
+    MemoryStats stats;
+    stats.pool_size = m_pool_size;
+    stats.used_bytes = g_used_bytes.load(std::memory_order_relaxed);
+    stats.peak_used_bytes = g_peak_used_bytes.load(std::memory_order_relaxed);
+
+    for (auto& arena : m_arenas) {
+        stats.free_blocks += arena->free_block_count.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(arena->mutex);
+        stats.largest_free_block = std::max(stats.largest_free_block, arena->largest_free_block());
+    }
+
+    for (const auto& shard : g_stats_shards) {
+        for (size_t i = 0; i < SIZE_HISTOGRAM_BUCKETS; ++i) {
+            stats.size_histogram[i] += shard.size_histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    for (size_t slot = 0; slot < MAX_STATS_TAGS; ++slot) {
+        const char* name = g_stats_tags[slot].load(std::memory_order_acquire);
+        MemoryTagStats tag;
+        tag.tag = name ? name : "Other";
+        for (const auto& shard : g_stats_shards) {
+            tag.live_bytes += shard.tags[slot].live_bytes.load(std::memory_order_relaxed);
+            tag.live_blocks += shard.tags[slot].live_blocks.load(std::memory_order_relaxed);
+            tag.allocations += shard.tags[slot].allocations.load(std::memory_order_relaxed);
+        }
+        if (!name && tag.allocations == 0) continue;
+
+        tag.peak_bytes = std::max(g_stats_tag_peaks[slot].load(std::memory_order_relaxed), tag.live_bytes);
+        stats.tags.push_back(std::move(tag));
+    }
+    return stats;
+}
+
+void MemoryManager::write_stats_json(std::ostream& out) {
+    MemoryStats stats = get_stats();
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    out << "{\"timestamp_ms\":" << now
+        << ",\"pool_size\":" << stats.pool_size
+        << ",\"used_bytes\":" << stats.used_bytes
+        << ",\"peak_used_bytes\":" << stats.peak_used_bytes
+        << ",\"free_blocks\":" << stats.free_blocks
+        << ",\"largest_free_block\":" << stats.largest_free_block
+        << ",\"size_histogram\":{";
+    bool first = true;
+    for (size_t i = 0; i < stats.size_histogram.size(); ++i) {
+        if (!stats.size_histogram[i]) continue;
+        out << (first ? "" : ",") << "\"" << (uint64_t(1) << i) << "\":" << stats.size_histogram[i];
+        first = false;
+    }
+    out << "},\"tags\":[";
+    for (size_t i = 0; i < stats.tags.size(); ++i) {
+        const MemoryTagStats& tag = stats.tags[i];
+        out << (i ? "," : "") << "{\"tag\":";
+        Core::write_json_string(out, tag.tag);
+        out << ",\"live_bytes\":" << tag.live_bytes
+            << ",\"live_blocks\":" << tag.live_blocks
+            << ",\"peak_bytes\":" << tag.peak_bytes
+            << ",\"allocations\":" << tag.allocations << "}";
+    }
+    out << "]}";
+}
+
+void MemoryManager::start_stats_dump(const std::string& path, std::chrono::milliseconds interval) {
+    stop_stats_dump();
+
+    std::lock_guard<std::mutex> lock(m_dump_mutex);
+    m_dump_running = true;
+    m_dump_thread = std::thread([this, path, interval] {
+        std::unique_lock<std::mutex> lock(m_dump_mutex);
+        while (!m_dump_condition.wait_for(lock, interval, [this] { return !m_dump_running; })) {
+            lock.unlock();
+            std::ofstream out(path, std::ios::app);
+            if (out) {
+                write_stats_json(out);
+                out << '\n';
+            } else {
+                std::cerr << "Warning: Could not open memory stats file: " << path << std::endl;
+            }
+            lock.lock();
+        }
+    });
+}
+
+void MemoryManager::stop_stats_dump() {
+    {
+        std::lock_guard<std::mutex> lock(m_dump_mutex);
+        if (!m_dump_running) return;
+        m_dump_running = false;
+    }
+    m_dump_condition.notify_all();
+    if (m_dump_thread.joinable()) m_dump_thread.join();
+}
+
 MemoryManager::~MemoryManager() {
-    if (m_pool) {
+    if (!m_arenas.empty()) {
         shutdown();
     }
+    stop_stats_dump();
 }
@@ -4,9 +4,57 @@
 
 #include <cstddef>
 #include <mutex>
-#include <list>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <string>
+#include <ostream>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
 
 struct BlockHeader; // Forward declaration
+struct PoolArena;   // Segregated-fit free block index, see MemoryManager.cpp
+struct ThreadCache; // Per-thread magazines of small blocks, see MemoryManager.cpp
+
+// How the pool's backing memory is obtained, see the [Core] section of ConfigParser.
+enum class HugePageMode {
+    None,        // Plain ::operator new
+    Transparent, // mmap + madvise(MADV_HUGEPAGE)
+    Explicit     // mmap with MAP_HUGETLB, falls back to Transparent
+};
+
+struct MemoryPoolOptions {
+    HugePageMode huge_pages = HugePageMode::None;
+    bool prefault = false;   // Touch every page up front
+    bool numa_aware = false; // One sub-pool per NUMA node, picked by the calling thread's node
+};
+
+// Live usage charged to one allocation tag.
+struct MemoryTagStats {
+    std::string tag;
+    int64_t live_bytes = 0;
+    int64_t live_blocks = 0;
+    // Approximate high-water mark of live_bytes since initialize. Threads
+    // hand their charges over in 64 KiB steps, so this is a lower bound that
+    // can be short by up to 64 KiB per thread allocating under the tag.
+    // MemoryStats::peak_used_bytes is exact, for the pool as a whole.
+    int64_t peak_bytes = 0;
+    uint64_t allocations = 0; // Total since initialize
+};
+
+// Point-in-time view returned by MemoryManager::get_stats.
+struct MemoryStats {
+    size_t pool_size = 0;
+    size_t used_bytes = 0; // Held by allocations and thread caches, including headers
+    size_t peak_used_bytes = 0; // Highest used_bytes since initialize, over the whole pool
+    size_t free_blocks = 0; // Free list length across all arenas
+    size_t largest_free_block = 0;
+    std::array<uint64_t, 64> size_histogram{}; // Allocation count by floor(log2(requested size))
+    std::vector<MemoryTagStats> tags;
+};
 
 class MemoryManager {
 public:
@@ -18,23 +66,64 @@ public:
     void operator=(const MemoryManager&) = delete;
 
     // Must be called before any allocations
-    void initialize(size_t total_size);
+    void initialize(size_t total_size, const MemoryPoolOptions& options = MemoryPoolOptions());
 
-    // Allocate/deallocate memory from the pool
+    // Allocate/deallocate memory from the pool.
+    // Small blocks are served from a per-thread cache without taking the pool lock.
     void* allocate(size_t size, const char* tag = "Default");
     void deallocate(void* ptr, const char* tag = "Default");
 
     // Release all resources
     void shutdown();
-    
+
+    // Changes whenever the pool is initialized or released, so clients that
+    // hold on to pool memory (e.g. ObjectPool slabs) can tell it went away.
+    uint64_t generation() const { return m_generation.load(std::memory_order_acquire); }
+    bool is_initialized() const { return generation() & 1; }
+
+    // Whether ptr points into the live pool
+    bool owns(const void* ptr);
+
+    // Allocation telemetry. Counters are sharded per thread, so a snapshot can be
+    // taken without stopping allocations. Tags are grouped by their text and must
+    // outlive the pool (string literals in practice). A snapshot sums every
+    // shard; for a frequent health check use pool_size and used_bytes instead.
+    MemoryStats get_stats();
+    void write_stats_json(std::ostream& out);
+
+    size_t pool_size() const { return m_pool_size; }
+    // Bytes held by allocations and thread caches, as in MemoryStats; one atomic load
+    size_t used_bytes() const;
+
+    // Appends one JSON line with the current stats to path every interval,
+    // until stop_stats_dump or shutdown is called.
+    void start_stats_dump(const std::string& path, std::chrono::milliseconds interval);
+    void stop_stats_dump();
+
 private:
+    friend struct ThreadCache;
+
     MemoryManager() = default;
     ~MemoryManager();
 
-    void* m_pool = nullptr;
+    PoolArena& local_arena();
+    PoolArena* arena_for(const void* ptr);
+    BlockHeader* allocate_block(size_t aligned_size);
+
     size_t m_pool_size = 0;
-    std::mutex m_mutex;
-    
-    // A list of free blocks for fast searching
-    std::list<BlockHeader*> m_free_list;
+    std::mutex m_mutex; // Guards initialize/shutdown; arenas have their own locks
+
+    // Size-class segregated free lists for O(1) allocate/free, one per NUMA node
+    std::vector<std::unique_ptr<PoolArena>> m_arenas;
+    std::vector<size_t> m_cpu_to_arena;
+
+    // Bumped on initialize and shutdown; odd while the pool is live.
+    // Thread caches compare it to drop pointers into a released pool.
+    std::atomic<uint64_t> m_generation{0};
+
+    // Periodic JSON stats dump
+    std::thread m_dump_thread;
+    std::mutex m_dump_mutex;
+    std::condition_variable m_dump_condition;
+    bool m_dump_running = false;
 };
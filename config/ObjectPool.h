@@ -0,0 +1,324 @@
+// ObjectPool.h - Fixed-size slot pools for hot, frequently recycled objects.
+// Slots are carved out of slabs taken from MemoryManager and recycled through
+// an intrusive free list, so steady-state allocation never touches the global heap.
+// While MemoryManager is not initialized (before initialize, after shutdown)
+// the slabs and other pooled storage come from ::operator new instead, so the
+// pools' users need no particular start-up order.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "MemoryManager.h"
+
+namespace detail {
+
+    // Blocks pooled_allocate took from the heap. Only those go back to it: a
+    // block that is neither here nor in the pool is from a released pool.
+    struct HeapFallbackBlocks {
+        static HeapFallbackBlocks& getInstance() {
+            static HeapFallbackBlocks* instance = new HeapFallbackBlocks();
+            return *instance;
+        }
+
+        std::mutex mutex;
+        std::unordered_set<void*> blocks;
+    };
+
+} // namespace detail
+
+// Pooled storage: from MemoryManager while it is initialized, from the
+// global heap otherwise. Frees go back to wherever the block came from.
+inline void* pooled_allocate(size_t size, const char* tag) {
+    MemoryManager& memory = MemoryManager::getInstance();
+    if (memory.is_initialized()) {
+        void* ptr = memory.allocate(size, tag);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+    void* ptr = ::operator new(size);
+    auto& fallback = detail::HeapFallbackBlocks::getInstance();
+    std::lock_guard<std::mutex> lock(fallback.mutex);
+    try {
+        fallback.blocks.insert(ptr);
+    } catch (...) {
+        ::operator delete(ptr);
+        throw;
+    }
+    return ptr;
+}
+
+inline void pooled_deallocate(void* ptr, const char* tag) noexcept {
+    if (!ptr) return;
+    MemoryManager& memory = MemoryManager::getInstance();
+    if (memory.owns(ptr)) {
+        memory.deallocate(ptr, tag);
+        return;
+    }
+    auto& fallback = detail::HeapFallbackBlocks::getInstance();
+    std::lock_guard<std::mutex> lock(fallback.mutex);
+    if (fallback.blocks.erase(ptr)) ::operator delete(ptr);
+}
+
+// Untyped pool of equally sized slots. One instance exists per slot shape,
+// so every type with the same size and alignment shares the same slabs.
+// Each thread keeps a magazine of free slots in front of the shared free
+// list, so the pool lock is only taken to move slots in batches, to grow,
+// or to pick up slabs another thread added. Instances are never destroyed,
+// since static destructors (the scheduler's among them) still release slots
+// while the program exits.
+template<size_t SlotSize, size_t SlotAlign>
+class FixedSlotPool {
+public:
+    static FixedSlotPool& getInstance() {
+        static FixedSlotPool* instance = new FixedSlotPool();
+        return *instance;
+    }
+
+    FixedSlotPool(const FixedSlotPool&) = delete;
+    void operator=(const FixedSlotPool&) = delete;
+
+    void* allocate() {
+        LocalCache* cache = local_cache();
+        if (!cache) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            drop_stale_slabs();
+            if (!m_free_list) grow();
+            return pop_shared();
+        }
+        if (cache->count == 0) refill(*cache);
+        return cache->slots[--cache->count];
+    }
+
+    // Slots from a pool generation that has since been released are dropped,
+    // not recycled: their memory is gone or already handed out again.
+    void deallocate(void* ptr) {
+        if (!ptr) return;
+        LocalCache* cache = local_cache();
+        if (!cache) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            drop_stale_slabs();
+            if (owns(m_slabs, ptr)) push_shared(static_cast<FreeSlot*>(ptr));
+            return;
+        }
+        if (!owns(cache->slabs, ptr)) {
+            // Maybe a slab another thread added since we last looked
+            sync(*cache);
+            if (!owns(cache->slabs, ptr)) return;
+        }
+        if (cache->count == MAGAZINE_CAPACITY) drain(*cache, MAGAZINE_BATCH);
+        cache->slots[cache->count++] = static_cast<FreeSlot*>(ptr);
+    }
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    static constexpr size_t SLOT_ALIGN = SlotAlign < alignof(FreeSlot) ? alignof(FreeSlot) : SlotAlign;
+    static constexpr size_t SLOT_SIZE =
+        ((SlotSize < sizeof(FreeSlot) ? sizeof(FreeSlot) : SlotSize) + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1);
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+    static constexpr size_t SLOTS_PER_SLAB = SLAB_BYTES / SLOT_SIZE ? SLAB_BYTES / SLOT_SIZE : 1;
+    static constexpr size_t SLAB_SIZE = SLOT_SIZE * SLOTS_PER_SLAB;
+    static constexpr size_t MAGAZINE_CAPACITY = 64;
+    static constexpr size_t MAGAZINE_BATCH = MAGAZINE_CAPACITY / 2;
+    // Slab lists start with room for this many, so a slab added in steady
+    // state (another thread outrunning the rest, say) stays off the heap.
+    static constexpr size_t RESERVED_SLABS = 256;
+
+    static_assert(SLOT_ALIGN <= alignof(std::max_align_t), "MemoryManager blocks are only max_align_t aligned");
+
+    // One thread's free slots, plus its copy of the slab list so the
+    // ownership check in deallocate runs without the lock.
+    struct LocalCache {
+        ~LocalCache() {
+            t_cache = nullptr;
+            t_cache_gone = true;
+            if (count) getInstance().drain(*this, count);
+        }
+
+        FreeSlot* slots[MAGAZINE_CAPACITY];
+        size_t count = 0;
+        uint64_t generation = 0;
+        std::vector<uintptr_t> slabs;
+    };
+
+    // Plain pointers, so slots released after this thread's cache was
+    // destroyed (from static destructors, say) take the locked path instead.
+    static inline thread_local LocalCache* t_cache = nullptr;
+    static inline thread_local bool t_cache_gone = false;
+
+    FixedSlotPool() { m_slabs.reserve(RESERVED_SLABS); }
+
+    static LocalCache* local_cache() {
+        LocalCache* cache = t_cache;
+        if (!cache) {
+            if (t_cache_gone) return nullptr;
+            static thread_local LocalCache owned;
+            owned.slabs.reserve(RESERVED_SLABS);
+            cache = t_cache = &owned;
+        }
+        uint64_t generation = MemoryManager::getInstance().generation();
+        if (cache->generation != generation) {
+            // The pool was reset underneath us, the cached slots are gone
+            cache->count = 0;
+            cache->slabs.clear();
+            cache->generation = generation;
+        }
+        return cache;
+    }
+
+    // Our slabs went away with the previous pool. Caller holds m_mutex.
+    void drop_stale_slabs() {
+        uint64_t generation = MemoryManager::getInstance().generation();
+        if (generation == m_generation) return;
+        m_free_list = nullptr;
+        m_slabs.clear();
+        m_generation = generation;
+    }
+
+    // Brings a thread's cache up to the current slabs. Caller holds m_mutex.
+    void sync_locked(LocalCache& cache) {
+        drop_stale_slabs();
+        if (cache.generation != m_generation) {
+            cache.count = 0;
+            cache.slabs.clear();
+            cache.generation = m_generation;
+        }
+        // Slabs only grow within a generation, so equal sizes mean equal lists
+        if (cache.slabs.size() != m_slabs.size()) cache.slabs = m_slabs;
+    }
+
+    void sync(LocalCache& cache) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sync_locked(cache);
+    }
+
+    void refill(LocalCache& cache) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sync_locked(cache);
+        while (cache.count < MAGAZINE_BATCH) {
+            if (!m_free_list) {
+                if (cache.count) break;
+                grow();
+            }
+            cache.slots[cache.count++] = pop_shared();
+        }
+        if (cache.slabs.size() != m_slabs.size()) cache.slabs = m_slabs;
+    }
+
+    void drain(LocalCache& cache, size_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        drop_stale_slabs();
+        if (cache.generation != m_generation) {
+            cache.count = 0;
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) push_shared(cache.slots[--cache.count]);
+    }
+
+    FreeSlot* pop_shared() {
+        FreeSlot* slot = m_free_list;
+        m_free_list = slot->next;
+        return slot;
+    }
+
+    void push_shared(FreeSlot* slot) {
+        slot->next = m_free_list;
+        m_free_list = slot;
+    }
+
+    static bool owns(const std::vector<uintptr_t>& slabs, const void* ptr) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        auto next = std::upper_bound(slabs.begin(), slabs.end(), address);
+        return next != slabs.begin() && address < *(next - 1) + SLAB_SIZE;
+    }
+
+    // Slabs are never handed back; they are recycled until the pool itself is
+    // released. Heap slabs, taken while there is no pool, are abandoned at
+    // the next initialize like pool slabs are, since their slots may be live.
+    void grow() {
+        char* slab = static_cast<char*>(pooled_allocate(SLAB_SIZE, "ObjectPoolSlab"));
+        uintptr_t address = reinterpret_cast<uintptr_t>(slab);
+        m_slabs.insert(std::upper_bound(m_slabs.begin(), m_slabs.end(), address), address);
+
+        for (size_t i = SLOTS_PER_SLAB; i-- > 0;) {
+            push_shared(reinterpret_cast<FreeSlot*>(slab + i * SLOT_SIZE));
+        }
+    }
+
+    std::mutex m_mutex;
+    FreeSlot* m_free_list = nullptr;
+    std::vector<uintptr_t> m_slabs; // Start addresses, ascending; only grow() and syncs touch the heap
+    uint64_t m_generation = 0;
+};
+
+// Typed front end for FixedSlotPool.
+template<typename T>
+class ObjectPool {
+public:
+    using Slots = FixedSlotPool<sizeof(T), alignof(T)>;
+
+    template<typename... Args>
+    static T* create(Args&&... args) {
+        void* slot = Slots::getInstance().allocate();
+        try {
+            return new (slot) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Slots::getInstance().deallocate(slot);
+            throw;
+        }
+    }
+
+    static void destroy(T* obj) {
+        if (!obj) return;
+        obj->~T();
+        Slots::getInstance().deallocate(obj);
+    }
+
+    // Deleter for std::unique_ptr<T, ObjectPool<T>::Deleter>
+    struct Deleter {
+        void operator()(T* obj) const { ObjectPool<T>::destroy(obj); }
+    };
+};
+
+// Standard allocator backed by the slot pools. Single-object requests (list
+// nodes, shared_ptr control blocks, future states) come from FixedSlotPool;
+// array requests fall through to pooled_allocate. Suitable for std::allocate_shared.
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(FixedSlotPool<sizeof(T), alignof(T)>::getInstance().allocate());
+        }
+        return static_cast<T*>(pooled_allocate(n * sizeof(T), "PoolAllocator"));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            FixedSlotPool<sizeof(T), alignof(T)>::getInstance().deallocate(ptr);
+        } else {
+            pooled_deallocate(ptr, "PoolAllocator");
+        }
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return false; }
@@ -0,0 +1,88 @@
+// ParallelFor.h - Data-parallel loops over AsyncScheduler workers.
+// The range is cut into fixed-size slices. The caller and up to one helper
+// task per worker claim slices until none are left, so the caller never
+// waits on work that has not started. That makes parallel_for safe to call
+// from inside a scheduler task, even with a single worker.
+//
+// Helper tasks come from the ObjectPool slot pools, so they use the
+// MemoryManager pool once it is initialized and the heap before that.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "AsyncScheduler.h"
+
+namespace detail {
+
+    // Helpers that start after the last slice is claimed return without
+    // touching body, so body may live on the caller's stack.
+    struct ParallelJob {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        size_t slices = 0;
+        size_t count = 0;
+        size_t grain = 0;
+        const std::function<void(size_t, size_t)>* body = nullptr;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+
+    inline void run_slices(ParallelJob& job) {
+        size_t slice;
+        while ((slice = job.next.fetch_add(1, std::memory_order_relaxed)) < job.slices) {
+            size_t begin = slice * job.grain;
+            try {
+                (*job.body)(begin, std::min(job.count, begin + job.grain));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error) job.error = std::current_exception();
+            }
+            if (job.done.fetch_add(1, std::memory_order_acq_rel) + 1 == job.slices) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.finished.notify_all();
+            }
+        }
+    }
+
+} // namespace detail
+
+// Calls body(begin, end) over [0, count) in slices of grain items and
+// returns when all are done. The first exception thrown by body is
+// rethrown here once every slice has finished.
+inline void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t slices = (count + grain - 1) / grain;
+    if (slices <= 1) {
+        if (count) body(0, count);
+        return;
+    }
+
+    auto job = std::make_shared<detail::ParallelJob>();
+    job->slices = slices;
+    job->count = count;
+    job->grain = grain;
+    job->body = &body;
+
+    AsyncScheduler& scheduler = AsyncScheduler::getInstance();
+    size_t helpers = std::min(slices - 1, scheduler.worker_count());
+    for (size_t i = 0; i < helpers; ++i) {
+        try {
+            scheduler.post([job] { detail::run_slices(*job); });
+        } catch (...) {
+            break; // Scheduler stopped or out of task slots; the caller does the rest
+        }
+    }
+
+    detail::run_slices(*job);
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == slices; });
+    if (job->error) std::rethrow_exception(job->error);
+}
@@ -0,0 +1,299 @@
+// QuantumBatchKernels.cpp - Mat-mat kernels over batches of states.
+// Every matrix entry is broadcast once and multiplied into a whole tile of
+// states, so the matrix is read once per tile rather than once per state.
+// As in CryptoHashSimd.cpp, the kernels are written once against
+// GCC/Clang vector types and compiled for each instruction set through
+// target attributes.
+
+#include "QuantumKernels.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define QUANTUM_BATCH_SIMD 1
+#else
+#define QUANTUM_BATCH_SIMD 0
+#endif
+
+namespace {
+
+    typedef double BatchVec1 __attribute__((vector_size(8)));
+    typedef double BatchVec4 __attribute__((vector_size(32)));
+    typedef double BatchVec8 __attribute__((vector_size(64)));
+
+    // Register tiles are this many vectors wide; narrower ones cover the rest
+    constexpr size_t TILE_VECTORS = 4;
+
+    // Dense blocking: a ROW_BLOCK x DEPTH_BLOCK tile of the matrix (64 KiB)
+    // stays in L2 while every column tile of the slice passes over it, and a
+    // column tile's DEPTH_BLOCK rows of x (32 KiB at AVX-512 width) stay in
+    // L1 across the rows of the tile
+    constexpr size_t ROW_BLOCK = 64;
+    constexpr size_t DEPTH_BLOCK = 64;
+
+#define BATCH_INLINE inline __attribute__((always_inline))
+
+// Loops over the vectors of a tile are unrolled so the accumulators live in
+// registers rather than on the stack
+#define BATCH_UNROLL _Pragma("GCC unroll 4")
+
+    template<typename V>
+    constexpr size_t lanes = sizeof(V) / sizeof(double);
+
+    // Vectors go by reference: passing them by value outside a target
+    // function would depend on the ABI of the baseline instruction set
+    template<typename V>
+    BATCH_INLINE void load(V& v, const double* p) {
+        memcpy(&v, p, sizeof(V));
+    }
+
+    template<typename V>
+    BATCH_INLINE void store(double* p, const V& v) {
+        memcpy(p, &v, sizeof(V));
+    }
+
+    // acc += (hr + i hi) * x over VECTORS vectors of x's row segment
+    template<typename V, size_t VECTORS>
+    BATCH_INLINE void multiply_add(V* acc_re, V* acc_im, double hr, double hi, const double* xr, const double* xi) {
+        V h_re = hr - V{}, h_im = hi - V{}; // Broadcast; x - 0.0 folds away where x + 0.0 does not
+        BATCH_UNROLL for (size_t v = 0; v < VECTORS; ++v) {
+            V a, b;
+            load(a, xr + v * lanes<V>);
+            load(b, xi + v * lanes<V>);
+            acc_re[v] = acc_re[v] + h_re * a - h_im * b;
+            acc_im[v] = acc_im[v] + h_re * b + h_im * a;
+        }
+    }
+
+    template<typename V, size_t VECTORS>
+    BATCH_INLINE void store_tile(const V* acc_re, const V* acc_im, double* yr, double* yi) {
+        BATCH_UNROLL for (size_t v = 0; v < VECTORS; ++v) {
+            store(yr + v * lanes<V>, acc_re[v]);
+            store(yi + v * lanes<V>, acc_im[v]);
+        }
+    }
+
+    // y[r][c..] (+)= sum over k in [k_begin, k_end) of m[r][k] * x[k][c..]
+    template<typename V, size_t VECTORS>
+    BATCH_INLINE void dense_tile(const ComplexMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                                 size_t r, size_t c, size_t k_begin, size_t k_end) {
+        V acc_re[VECTORS] = {}, acc_im[VECTORS] = {};
+        if (k_begin > 0) {
+            BATCH_UNROLL for (size_t v = 0; v < VECTORS; ++v) {
+                load(acc_re[v], y.row_re(r) + c + v * lanes<V>);
+                load(acc_im[v], y.row_im(r) + c + v * lanes<V>);
+            }
+        }
+        const double* ar = m.row_re(r);
+        const double* ai = m.row_im(r);
+        for (size_t k = k_begin; k < k_end; ++k) {
+            multiply_add<V, VECTORS>(acc_re, acc_im, ar[k], ai[k], x.row_re(k) + c, x.row_im(k) + c);
+        }
+        store_tile<V, VECTORS>(acc_re, acc_im, y.row_re(r) + c, y.row_im(r) + c);
+    }
+
+    template<typename V, size_t VECTORS>
+    BATCH_INLINE void sparse_tile(const BandedMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                                  size_t r, size_t c) {
+        V acc_re[VECTORS] = {}, acc_im[VECTORS] = {};
+        for (size_t d = 0; d < m.diagonal_count(); ++d) {
+            ptrdiff_t k = static_cast<ptrdiff_t>(r) + m.offset(d);
+            if (k < 0 || k >= static_cast<ptrdiff_t>(m.size())) continue;
+            const ComplexVectorSoA& diagonal = m.diagonal(d);
+            multiply_add<V, VECTORS>(acc_re, acc_im, diagonal.re[r], diagonal.im[r], x.row_re(k) + c, x.row_im(k) + c);
+        }
+        store_tile<V, VECTORS>(acc_re, acc_im, y.row_re(r) + c, y.row_im(r) + c);
+    }
+
+    // No gather here: the column index picks a whole row of x
+    template<typename V, size_t VECTORS>
+    BATCH_INLINE void sparse_tile(const CsrMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                                  size_t r, size_t c) {
+        V acc_re[VECTORS] = {}, acc_im[VECTORS] = {};
+        const size_t* offsets = m.row_offsets();
+        for (size_t e = offsets[r]; e < offsets[r + 1]; ++e) {
+            uint32_t k = m.columns()[e];
+            multiply_add<V, VECTORS>(acc_re, acc_im, m.values_re()[e], m.values_im()[e], x.row_re(k) + c, x.row_im(k) + c);
+        }
+        store_tile<V, VECTORS>(acc_re, acc_im, y.row_re(r) + c, y.row_im(r) + c);
+    }
+
+    // Whole vectors from begin; end rounds up into the zero padding columns
+    template<typename V>
+    BATCH_INLINE size_t tile_stop(const ComplexMatrixSoA& x, size_t end) {
+        return std::min(x.stride(), (end + lanes<V> - 1) / lanes<V> * lanes<V>);
+    }
+
+    template<typename V>
+    BATCH_INLINE void batch_columns(const ComplexMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                                    size_t begin, size_t end) {
+        constexpr size_t WIDE = TILE_VECTORS * lanes<V>;
+        size_t stop = tile_stop<V>(x, end);
+        for (size_t k = 0; k < m.cols(); k += DEPTH_BLOCK) {
+            size_t k_end = std::min(m.cols(), k + DEPTH_BLOCK);
+            for (size_t rows = 0; rows < m.rows(); rows += ROW_BLOCK) {
+                size_t rows_end = std::min(m.rows(), rows + ROW_BLOCK);
+                size_t c = begin;
+                for (; c + WIDE <= stop; c += WIDE) {
+                    for (size_t r = rows; r < rows_end; ++r) dense_tile<V, TILE_VECTORS>(m, x, y, r, c, k, k_end);
+                }
+                for (; c < stop; c += lanes<V>) {
+                    for (size_t r = rows; r < rows_end; ++r) dense_tile<V, 1>(m, x, y, r, c, k, k_end);
+                }
+            }
+        }
+    }
+
+    template<typename V, typename Sparse>
+    BATCH_INLINE void batch_columns(const Sparse& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                                    size_t begin, size_t end) {
+        constexpr size_t WIDE = TILE_VECTORS * lanes<V>;
+        size_t stop = tile_stop<V>(x, end);
+        for (size_t rows = 0; rows < y.rows(); rows += ROW_BLOCK) {
+            size_t rows_end = std::min(y.rows(), rows + ROW_BLOCK);
+            size_t c = begin;
+            for (; c + WIDE <= stop; c += WIDE) {
+                for (size_t r = rows; r < rows_end; ++r) sparse_tile<V, TILE_VECTORS>(m, x, y, r, c);
+            }
+            for (; c < stop; c += lanes<V>) {
+                for (size_t r = rows; r < rows_end; ++r) sparse_tile<V, 1>(m, x, y, r, c);
+            }
+        }
+    }
+
+    // Walks each column tile down the rows, keeping the running sums,
+    // maxima and argmax rows in registers
+    template<typename V>
+    BATCH_INLINE void statistics_columns(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                                         double* peak_probabilities, size_t* peak_rows) {
+        using Mask = decltype(V{} > V{});
+        size_t stop = tile_stop<V>(x, end);
+        for (size_t c = begin; c < stop; c += lanes<V>) {
+            V norm{}, peak{};
+            Mask peak_row{};
+            for (size_t r = 0; r < x.rows(); ++r) {
+                V a, b;
+                load(a, x.row_re(r) + c);
+                load(b, x.row_im(r) + c);
+                V probability = a * a + b * b;
+                norm += probability;
+                Mask higher = probability > peak;
+                peak = higher ? probability : peak;
+                peak_row = higher ? Mask{} + static_cast<int64_t>(r) : peak_row;
+            }
+            store(squared_norms + c, norm);
+            store(peak_probabilities + c, peak);
+            for (size_t l = 0; l < lanes<V>; ++l) peak_rows[c + l] = static_cast<size_t>(peak_row[l]);
+        }
+    }
+
+#undef BATCH_UNROLL
+#undef BATCH_INLINE
+
+    template<typename Matrix>
+    void matmul_scalar(const Matrix& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end) {
+        batch_columns<BatchVec1>(m, x, y, begin, end);
+    }
+
+    void statistics_scalar(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                           double* peak_probabilities, size_t* peak_rows) {
+        statistics_columns<BatchVec1>(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+    }
+
+#if QUANTUM_BATCH_SIMD
+
+    template<typename Matrix>
+    __attribute__((target("avx2,fma")))
+    void matmul_avx2(const Matrix& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end) {
+        batch_columns<BatchVec4>(m, x, y, begin, end);
+    }
+
+    template<typename Matrix>
+    __attribute__((target("avx512f")))
+    void matmul_avx512(const Matrix& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end) {
+        batch_columns<BatchVec8>(m, x, y, begin, end);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void statistics_avx2(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                         double* peak_probabilities, size_t* peak_rows) {
+        statistics_columns<BatchVec4>(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+    }
+
+    __attribute__((target("avx512f")))
+    void statistics_avx512(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                           double* peak_probabilities, size_t* peak_rows) {
+        statistics_columns<BatchVec8>(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+    }
+
+#endif
+
+    void check_batch(size_t matrix_rows, size_t matrix_cols, const ComplexMatrixSoA& x, const ComplexMatrixSoA& y,
+                     size_t begin, size_t end) {
+        if (x.rows() != matrix_cols || matrix_rows != matrix_cols) {
+            throw std::runtime_error("QuantumKernels::matmul: batch size does not match the matrix");
+        }
+        if (y.rows() != x.rows() || y.cols() != x.cols()) {
+            throw std::runtime_error("QuantumKernels::matmul: output batch has the wrong shape");
+        }
+        if (begin % QuantumKernels::BATCH_COLUMN_ALIGNMENT != 0 || begin > end || end > x.cols()) {
+            throw std::runtime_error("QuantumKernels::matmul: bad column range");
+        }
+    }
+
+    template<typename Matrix>
+    void matmul_dispatch(const Matrix& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end,
+                         KernelBackend backend) {
+        switch (QuantumKernels::resolve(backend)) {
+#if QUANTUM_BATCH_SIMD
+            case KernelBackend::AVX512: matmul_avx512(m, x, y, begin, end); break;
+            case KernelBackend::AVX2: matmul_avx2(m, x, y, begin, end); break;
+#endif
+            default: matmul_scalar(m, x, y, begin, end); break;
+        }
+    }
+
+} // namespace
+
+namespace QuantumKernels {
+
+    void matmul(const ComplexMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend) {
+        check_batch(m.rows(), m.cols(), x, y, begin, end);
+        matmul_dispatch(m, x, y, begin, end, backend);
+    }
+
+    void matmul(const BandedMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend) {
+        check_batch(m.size(), m.size(), x, y, begin, end);
+        matmul_dispatch(m, x, y, begin, end, backend);
+    }
+
+    void matmul(const CsrMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend) {
+        check_batch(m.rows(), m.cols(), x, y, begin, end);
+        matmul_dispatch(m, x, y, begin, end, backend);
+    }
+
+    void column_statistics(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                           double* peak_probabilities, size_t* peak_rows, KernelBackend backend) {
+        if (begin % BATCH_COLUMN_ALIGNMENT != 0 || begin > end || end > x.cols()) {
+            throw std::runtime_error("QuantumKernels::column_statistics: bad column range");
+        }
+        switch (resolve(backend)) {
+#if QUANTUM_BATCH_SIMD
+            case KernelBackend::AVX512:
+                statistics_avx512(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+                break;
+            case KernelBackend::AVX2:
+                statistics_avx2(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+                break;
+#endif
+            default:
+                statistics_scalar(x, begin, end, squared_norms, peak_probabilities, peak_rows);
+                break;
+        }
+    }
+
+} // namespace QuantumKernels
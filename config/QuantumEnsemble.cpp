@@ -0,0 +1,138 @@
+// QuantumEnsemble.cpp - Batched evolution of independent trajectories.
+
+#include "QuantumEnsemble.h"
+#include "ParallelFor.h"
+#include "QuantumKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+    // Multiply-adds below which a step stays on the calling thread, and
+    // roughly the work given to each parallel slice of trajectories
+    constexpr size_t PARALLEL_MIN_WORK = size_t(1) << 18;
+    constexpr size_t PARALLEL_SLICE_WORK = size_t(1) << 18;
+
+    // Slices cover at least this many column groups, so the kernels mostly
+    // run on full-width register tiles
+    constexpr size_t MIN_SLICE_GROUPS = 4;
+
+} // namespace
+
+QuantumEnsemble::QuantumEnsemble(size_t trajectories, size_t dimension, size_t coupling_range, MatrixFormat format)
+    : m_hamiltonian(QuantumFluctuator::build_hamiltonian(dimension, coupling_range,
+                                                         QuantumFluctuator::DEFAULT_INTERACTION_POTENTIAL, format)),
+      m_states(dimension, trajectories),
+      m_products(dimension, trajectories),
+      m_energies(m_states.stride(), 0.0),
+      m_norms(m_states.stride(), 0.0),
+      m_peaks(m_states.stride(), 0.0),
+      m_peak_rows(m_states.stride(), 0),
+      m_decoherence_threshold(QuantumFluctuator::DEFAULT_DECOHERENCE_THRESHOLD) {
+    if (trajectories == 0) {
+        throw std::runtime_error("QuantumEnsemble needs at least one trajectory");
+    }
+
+    // Start in the uniform superposition; padding columns stay zero
+    double amplitude = 1.0 / std::sqrt(static_cast<double>(dimension));
+    for (size_t i = 0; i < dimension; ++i) {
+        std::fill(m_states.row_re(i), m_states.row_re(i) + trajectories, amplitude);
+    }
+}
+
+void QuantumEnsemble::update(double dt) {
+    size_t groups = m_states.stride() / QuantumKernels::BATCH_COLUMN_ALIGNMENT;
+    size_t group_work = std::max<size_t>(1, m_hamiltonian.nonzeros() * QuantumKernels::BATCH_COLUMN_ALIGNMENT);
+    size_t grain = groups * group_work < PARALLEL_MIN_WORK
+        ? groups
+        : std::max(MIN_SLICE_GROUPS, PARALLEL_SLICE_WORK / group_work);
+
+    std::atomic<size_t> collapses{0};
+    parallel_for(groups, grain, [&](size_t begin, size_t end) {
+        begin *= QuantumKernels::BATCH_COLUMN_ALIGNMENT;
+        end = std::min(trajectories(), end * QuantumKernels::BATCH_COLUMN_ALIGNMENT);
+        collapses.fetch_add(step_columns(dt, begin, end), std::memory_order_relaxed);
+    });
+    m_collapses = collapses.load(std::memory_order_relaxed);
+    m_timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// The loops run row by row across the slice's columns, so the inner loops
+// are contiguous and carry no dependency between trajectories. They run up
+// to the padded end; padding columns are zero and stay zero.
+size_t QuantumEnsemble::step_columns(double dt, size_t begin, size_t end) {
+    size_t stop = std::min(m_states.stride(), simd_padded(end));
+    m_hamiltonian.apply(m_states, m_products, begin, end);
+
+    // psi += -i dt H psi, with <psi|H|psi> from the same product
+    double* energies = m_energies.data();
+    std::fill(energies + begin, energies + stop, 0.0);
+    for (size_t r = 0; r < dimension(); ++r) {
+        double* re = m_states.row_re(r);
+        double* im = m_states.row_im(r);
+        const double* h_re = m_products.row_re(r);
+        const double* h_im = m_products.row_im(r);
+        for (size_t c = begin; c < stop; ++c) {
+            energies[c] += re[c] * h_re[c] + im[c] * h_im[c];
+            re[c] += dt * h_im[c];
+            im[c] -= dt * h_re[c];
+        }
+    }
+
+    QuantumKernels::column_statistics(m_states, begin, end, m_norms.data(), m_peaks.data(), m_peak_rows.data());
+
+    // Renormalize; m_norms turns into the scale factors
+    double* factors = m_norms.data();
+    for (size_t c = begin; c < stop; ++c) {
+        double norm = std::sqrt(factors[c]);
+        m_peaks[c] = norm > 0.0 ? m_peaks[c] / factors[c] : 0.0;
+        factors[c] = norm > 0.0 ? 1.0 / norm : 1.0;
+    }
+    for (size_t r = 0; r < dimension(); ++r) {
+        double* re = m_states.row_re(r);
+        double* im = m_states.row_im(r);
+        for (size_t c = begin; c < stop; ++c) {
+            re[c] *= factors[c];
+            im[c] *= factors[c];
+        }
+    }
+
+    // Collapses are rare; each one rewrites its column
+    size_t collapses = 0;
+    for (size_t c = begin; c < end; ++c) {
+        if (m_peaks[c] <= m_decoherence_threshold) continue;
+        size_t peak = m_peak_rows[c];
+        std::complex<double> amplitude = m_states.get(peak, c);
+        std::complex<double> phase = amplitude / std::abs(amplitude);
+        for (size_t r = 0; r < dimension(); ++r) m_states.set(r, c, 0.0);
+        m_states.set(peak, c, phase);
+        ++collapses;
+    }
+    return collapses;
+}
+
+QuantumStateVector QuantumEnsemble::state(size_t trajectory) const {
+    if (trajectory >= trajectories()) {
+        throw std::runtime_error("QuantumEnsemble trajectory index out of range");
+    }
+    QuantumStateVector state;
+    state.amplitudes.resize(dimension());
+    for (size_t i = 0; i < dimension(); ++i) state.amplitudes[i] = m_states.get(i, trajectory);
+    state.energy_level = m_energies[trajectory];
+    state.timestamp = m_timestamp;
+    return state;
+}
+
+void QuantumEnsemble::set_state(size_t trajectory, std::span<const std::complex<double>> amplitudes) {
+    if (trajectory >= trajectories()) {
+        throw std::runtime_error("QuantumEnsemble trajectory index out of range");
+    }
+    if (amplitudes.size() != dimension()) {
+        throw std::runtime_error("QuantumEnsemble state size does not match the dimension");
+    }
+    for (size_t i = 0; i < dimension(); ++i) m_states.set(i, trajectory, amplitudes[i]);
+}
@@ -0,0 +1,67 @@
+// QuantumEnsemble.h - Many independent trajectories under one Hamiltonian.
+// A QuantumFluctuator per trajectory streams the whole Hamiltonian from
+// memory once per trajectory per step. The ensemble stores the states as
+// the columns of one matrix instead, so a step is a single mat-mat product
+// that reads each Hamiltonian entry once per tile of trajectories.
+// Normalization and the decoherence check run down the columns, a register
+// of trajectories at a time.
+//
+// Column slices of the batch are stepped on the AsyncScheduler workers with
+// parallel_for.
+
+#pragma once
+
+#include <complex>
+#include <span>
+#include <vector>
+#include "QuantumFluctuator.h"
+#include "SimdStorage.h"
+#include "SparseMatrix.h"
+
+class QuantumEnsemble {
+public:
+    // Trajectories see the Hamiltonian of
+    // QuantumFluctuator(dimension, coupling_range, format) and start in its
+    // initial state, the uniform superposition.
+    explicit QuantumEnsemble(size_t trajectories, size_t dimension = 64, size_t coupling_range = 1,
+                             MatrixFormat format = MatrixFormat::Auto);
+
+    // Advances every trajectory the way QuantumFluctuator::update does in
+    // Euler mode: one explicit step, renormalization, then collapse where
+    // one basis state holds more than the decoherence threshold.
+    void update(double dt);
+
+    size_t trajectories() const { return m_states.cols(); }
+    size_t dimension() const { return m_states.rows(); }
+    const HamiltonianMatrix& hamiltonian() const { return m_hamiltonian; }
+
+    std::complex<double> amplitude(size_t trajectory, size_t index) const { return m_states.get(index, trajectory); }
+    // <psi|H|psi> at the start of the last update
+    double energy(size_t trajectory) const { return m_energies[trajectory]; }
+    // Number of trajectories that collapsed during the last update
+    size_t collapses() const { return m_collapses; }
+
+    // A copy of one trajectory with its energy and the last update time
+    QuantumStateVector state(size_t trajectory) const;
+    // Amplitudes must have dimension() entries; they are used as given
+    void set_state(size_t trajectory, std::span<const std::complex<double>> amplitudes);
+
+private:
+    // Steps the trajectories in [begin, end); begin is a multiple of
+    // QuantumKernels::BATCH_COLUMN_ALIGNMENT
+    size_t step_columns(double dt, size_t begin, size_t end);
+
+    HamiltonianMatrix m_hamiltonian;
+    ComplexMatrixSoA m_states;   // Row i is amplitude i of every trajectory
+    ComplexMatrixSoA m_products; // H * m_states
+
+    // Per trajectory, padded to m_states.stride()
+    AlignedVector<double> m_energies;
+    AlignedVector<double> m_norms;
+    AlignedVector<double> m_peaks;
+    std::vector<size_t> m_peak_rows;
+
+    double m_decoherence_threshold;
+    size_t m_collapses = 0;
+    uint64_t m_timestamp = 0;
+};
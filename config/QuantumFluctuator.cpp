@@ -0,0 +1,122 @@
+// QuantumFluctuator.cpp - Evolution of the simulated quantum state.
+
+#include "QuantumFluctuator.h"
+#include "QuantumKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+QuantumFluctuator::QuantumFluctuator(size_t dimension, size_t coupling_range, MatrixFormat format)
+    : m_amplitudes(dimension),
+      m_scratch(dimension),
+      m_decoherence_threshold(DEFAULT_DECOHERENCE_THRESHOLD),
+      m_interaction_potential(DEFAULT_INTERACTION_POTENTIAL) {
+    m_hamiltonian_matrix = build_hamiltonian(dimension, coupling_range, m_interaction_potential, format);
+
+    // Start in the uniform superposition
+    double amplitude = 1.0 / std::sqrt(static_cast<double>(dimension));
+    for (size_t j = 0; j < dimension; ++j) m_amplitudes.set(j, amplitude);
+
+    publish_state();
+}
+
+HamiltonianMatrix QuantumFluctuator::build_hamiltonian(size_t dimension, size_t coupling_range,
+                                                       double interaction_potential, MatrixFormat format) {
+    if (dimension == 0) {
+        throw std::runtime_error("QuantumFluctuator dimension must be non-zero");
+    }
+    if (coupling_range == 0 || coupling_range >= dimension) coupling_range = dimension - 1;
+
+    // Hermitian Hamiltonian: evenly spaced levels on the diagonal, couplings
+    // falling off with distance and carrying a phase off it. Entries are
+    // generated row by row, already in CSR order.
+    std::vector<MatrixEntry> entries;
+    entries.reserve(dimension * (2 * coupling_range + 1));
+    for (size_t j = 0; j < dimension; ++j) {
+        size_t first = j > coupling_range ? j - coupling_range : 0;
+        size_t last = std::min(dimension - 1, j + coupling_range);
+        for (size_t k = first; k <= last; ++k) {
+            if (k == j) {
+                entries.push_back({j, j, static_cast<double>(j) / static_cast<double>(dimension)});
+                continue;
+            }
+            double distance = static_cast<double>(k > j ? k - j : j - k);
+            std::complex<double> coupling = std::polar(interaction_potential / (1.0 + distance), 0.1 * distance);
+            entries.push_back({j, k, k > j ? coupling : std::conj(coupling)});
+        }
+    }
+    return HamiltonianMatrix(dimension, std::move(entries), format);
+}
+
+void QuantumFluctuator::update(double dt) {
+    if (m_integrator_options.mode == IntegratorMode::Krylov) {
+        m_energy_level = m_krylov.propagate(m_hamiltonian_matrix, m_amplitudes, dt).energy;
+    } else {
+        apply_hamiltonian(dt);
+    }
+    normalize_state();
+    check_for_decoherence();
+    publish_state();
+}
+
+void QuantumFluctuator::set_integrator(const IntegratorOptions& options) {
+    m_krylov = KrylovIntegrator(options.krylov_dimension, options.tolerance);
+    m_integrator_options = options;
+}
+
+const StateSnapshot& QuantumFluctuator::get_current_state() const {
+    return m_publisher.current();
+}
+
+// One explicit step of the Schrodinger equation, psi += -i dt H psi. The
+// energy expectation <psi|H|psi> falls out of the same mat-vec.
+void QuantumFluctuator::apply_hamiltonian(double dt) {
+    m_hamiltonian_matrix.apply(m_amplitudes, m_scratch);
+
+    double* re = m_amplitudes.re.data();
+    double* im = m_amplitudes.im.data();
+    const double* h_re = m_scratch.re.data();
+    const double* h_im = m_scratch.im.data();
+    double energy = 0.0;
+    for (size_t i = 0; i < m_amplitudes.padded_size(); ++i) {
+        energy += re[i] * h_re[i] + im[i] * h_im[i];
+        re[i] += dt * h_im[i];
+        im[i] -= dt * h_re[i];
+    }
+    m_energy_level = energy;
+}
+
+// The explicit step does not preserve the norm and the Krylov one only up
+// to its tolerance; bring it back to 1
+void QuantumFluctuator::normalize_state() {
+    double norm = std::sqrt(QuantumKernels::squared_norm(m_amplitudes));
+    if (norm > 0.0) QuantumKernels::scale(m_amplitudes, 1.0 / norm);
+}
+
+// When one basis state holds more than the threshold of the probability,
+// the state collapses onto it
+void QuantumFluctuator::check_for_decoherence() {
+    size_t peak = 0;
+    double peak_probability = 0.0;
+    for (size_t i = 0; i < m_amplitudes.size(); ++i) {
+        double probability = std::norm(m_amplitudes.get(i));
+        if (probability > peak_probability) {
+            peak = i;
+            peak_probability = probability;
+        }
+    }
+    if (peak_probability <= m_decoherence_threshold) return;
+
+    std::complex<double> phase = m_amplitudes.get(peak) / std::sqrt(peak_probability);
+    m_amplitudes = ComplexVectorSoA(m_amplitudes.size());
+    m_amplitudes.set(peak, phase);
+}
+
+void QuantumFluctuator::publish_state() {
+    uint64_t timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    m_publisher.publish(m_amplitudes.size(), m_energy_level, timestamp, [&](std::span<std::complex<double>> out) {
+        for (size_t i = 0; i < out.size(); ++i) out[i] = m_amplitudes.get(i);
+    });
+}
@@ -5,6 +5,10 @@
 #include <vector>
 #include <complex>
 #include "EventDispatcher.h" // For firing events
+#include "KrylovIntegrator.h"
+#include "SimdStorage.h"
+#include "SparseMatrix.h"
+#include "StateSnapshot.h"
 
 // Represents the state of a quantum system.
 // In reality this would be much more complex.
@@ -14,33 +18,76 @@ struct QuantumStateVector {
     uint64_t timestamp;
 };
 
-// An event fired when a significant quantum fluctuation occurs.
+// An event fired when a significant quantum fluctuation occurs. It holds a
+// handle to the shared snapshot, not a copy of the amplitudes.
 struct QuantumEvent : public BaseEvent {
-    int simulation_tick;
-    QuantumStateVector resulting_state;
-    
-    QuantumEvent(int tick, QuantumStateVector state)
+    int simulation_tick = 0;
+    StateSnapshot resulting_state;
+
+    QuantumEvent() = default; // For the preallocated slots of a Channel<QuantumEvent>
+    QuantumEvent(int tick, StateSnapshot state)
         : simulation_tick(tick), resulting_state(std::move(state)) {}
 };
 
+// How update() advances the state.
+enum class IntegratorMode {
+    Euler,  // One explicit step per update, then renormalized; cheap but
+            // only accurate for dt well below 1 / |H|
+    Krylov  // exp(-i H dt) by Lanczos projection with adaptive substeps
+};
+
+struct IntegratorOptions {
+    IntegratorMode mode = IntegratorMode::Euler;
+    double tolerance = 1e-10;    // Krylov only: error bound per update
+    size_t krylov_dimension = 24; // Krylov only: Lanczos steps per substep
+};
 
 // A class to manage and evolve the quantum simulation.
+// The working state and Hamiltonian are kept in aligned split real/imag
+// storage for the SIMD kernels. After every step the state is published as
+// a StateSnapshot, copy-on-write: the previous snapshot's buffer is reused
+// unless an event or handler still holds it. MemoryManager must be
+// initialized before construction.
 class QuantumFluctuator {
 public:
-    QuantumFluctuator();
+    // Basis states are coupled to neighbours up to coupling_range apart
+    // (0 couples every pair). Short ranges give a sparse Hamiltonian, stored
+    // banded or CSR unless another format is asked for, so a step costs
+    // O(dimension * coupling_range).
+    explicit QuantumFluctuator(size_t dimension = 64, size_t coupling_range = 1,
+                               MatrixFormat format = MatrixFormat::Auto);
 
     // Evolve the system by one time step.
     void update(double dt);
+
+    void set_integrator(const IntegratorOptions& options);
+    const IntegratorOptions& integrator() const { return m_integrator_options; }
     
-    const QuantumStateVector& get_current_state() const;
+    // The snapshot published by the last update; copy the handle to keep it
+    const StateSnapshot& get_current_state() const;
+    const HamiltonianMatrix& hamiltonian() const { return m_hamiltonian_matrix; }
+
+    // The Hamiltonian the constructor builds, also used by QuantumEnsemble
+    static HamiltonianMatrix build_hamiltonian(size_t dimension, size_t coupling_range,
+                                               double interaction_potential, MatrixFormat format);
+
+    static constexpr double DEFAULT_DECOHERENCE_THRESHOLD = 0.9;
+    static constexpr double DEFAULT_INTERACTION_POTENTIAL = 0.05;
 
 private:
     void normalize_state();
     void apply_hamiltonian(double dt);
     void check_for_decoherence();
 
-    QuantumStateVector m_state;
-    std::vector<std::vector<std::complex<double>>> m_hamiltonian_matrix;
+    void publish_state();
+
+    SnapshotPublisher m_publisher;
+    double m_energy_level = 0.0;
+    ComplexVectorSoA m_amplitudes;
+    ComplexVectorSoA m_scratch; // H * m_amplitudes
+    HamiltonianMatrix m_hamiltonian_matrix;
+    IntegratorOptions m_integrator_options;
+    KrylovIntegrator m_krylov;
     
     // Internal parameters controlling the simulation's behavior
     double m_decoherence_threshold;
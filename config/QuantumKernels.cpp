@@ -0,0 +1,407 @@
+// QuantumKernels.cpp - Scalar, AVX2 and AVX-512 complex kernels.
+
+#include "QuantumKernels.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define QUANTUM_KERNELS_SIMD 1
+#include <immintrin.h>
+#else
+#define QUANTUM_KERNELS_SIMD 0
+#endif
+
+namespace {
+
+    // Mat-vec work, in multiply-adds, below which a call stays on the
+    // calling thread, and roughly the work given to each parallel slice
+    constexpr size_t PARALLEL_MIN_WORK = size_t(1) << 18;
+    constexpr size_t PARALLEL_SLICE_WORK = size_t(1) << 16;
+
+    // Runs kernel(begin, end) over rows, in parallel when there is enough work
+    template<typename Kernel>
+    void for_row_slices(size_t rows, size_t work_per_row, Kernel&& kernel) {
+        work_per_row = std::max<size_t>(work_per_row, 1);
+        if (rows * work_per_row < PARALLEL_MIN_WORK) {
+            kernel(size_t(0), rows);
+            return;
+        }
+        parallel_for(rows, std::max<size_t>(1, PARALLEL_SLICE_WORK / work_per_row), kernel);
+    }
+
+    // (yr + i yi)[r] = sum over c of (ar + i ai)[r][c] * (xr + i xi)[c]
+    void matvec_scalar(const ComplexMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                       size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* ar = m.row_re(r);
+            const double* ai = m.row_im(r);
+            double sum_re = 0.0, sum_im = 0.0;
+            for (size_t c = 0; c < m.cols(); ++c) {
+                sum_re += ar[c] * xr[c] - ai[c] * xi[c];
+                sum_im += ar[c] * xi[c] + ai[c] * xr[c];
+            }
+            yr[r] = sum_re;
+            yi[r] = sum_im;
+        }
+    }
+
+    // Rows of the banded matrix's diagonal d that fall within [begin, end)
+    // and the matrix: i + offset must stay in [0, size)
+    void diagonal_rows(const BandedMatrixSoA& m, size_t d, size_t begin, size_t end, size_t& first, size_t& last) {
+        ptrdiff_t offset = m.offset(d);
+        first = std::max<size_t>(begin, offset < 0 ? static_cast<size_t>(-offset) : 0);
+        last = std::min<size_t>(end, offset > 0 ? m.size() - std::min<size_t>(m.size(), offset) : m.size());
+    }
+
+    void clear_rows(double* yr, double* yi, size_t begin, size_t end) {
+        std::fill(yr + begin, yr + end, 0.0);
+        std::fill(yi + begin, yi + end, 0.0);
+    }
+
+    // y[i] += diagonal(d)[i] * x[i + offset(d)], one diagonal at a time
+    void banded_scalar(const BandedMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                       size_t begin, size_t end) {
+        clear_rows(yr, yi, begin, end);
+        for (size_t d = 0; d < m.diagonal_count(); ++d) {
+            const double* dr = m.diagonal(d).re.data();
+            const double* di = m.diagonal(d).im.data();
+            size_t first, last;
+            diagonal_rows(m, d, begin, end, first, last);
+            if (first >= last) continue;
+            ptrdiff_t shift = m.offset(d); // i + shift is in range for every row used
+            for (size_t i = first; i < last; ++i) {
+                yr[i] += dr[i] * xr[i + shift] - di[i] * xi[i + shift];
+                yi[i] += dr[i] * xi[i + shift] + di[i] * xr[i + shift];
+            }
+        }
+    }
+
+    void csr_scalar(const CsrMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                    size_t begin, size_t end) {
+        const size_t* offsets = m.row_offsets();
+        const uint32_t* columns = m.columns();
+        const double* vr = m.values_re();
+        const double* vi = m.values_im();
+        for (size_t r = begin; r < end; ++r) {
+            double sum_re = 0.0, sum_im = 0.0;
+            for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+                uint32_t c = columns[k];
+                sum_re += vr[k] * xr[c] - vi[k] * xi[c];
+                sum_im += vr[k] * xi[c] + vi[k] * xr[c];
+            }
+            yr[r] = sum_re;
+            yi[r] = sum_im;
+        }
+    }
+
+    double squared_norm_scalar(const double* re, const double* im, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) sum += re[i] * re[i] + im[i] * im[i];
+        return sum;
+    }
+
+#if QUANTUM_KERNELS_SIMD
+
+    // The loops below run over the padded row length, which is a multiple
+    // of 8 doubles; padding is zero in both the matrix and the vectors.
+
+    __attribute__((target("avx2,fma")))
+    double horizontal_sum(__m256d v) {
+        __m128d low = _mm256_castpd256_pd128(v);
+        __m128d high = _mm256_extractf128_pd(v, 1);
+        low = _mm_add_pd(low, high);
+        return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    void matvec_avx2(const ComplexMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                    size_t begin, size_t end) {
+        size_t stride = m.stride();
+        for (size_t r = begin; r < end; ++r) {
+            const double* ar = m.row_re(r);
+            const double* ai = m.row_im(r);
+            // Two accumulator pairs to cover the FMA latency
+            __m256d re0 = _mm256_setzero_pd(), im0 = _mm256_setzero_pd();
+            __m256d re1 = _mm256_setzero_pd(), im1 = _mm256_setzero_pd();
+            for (size_t c = 0; c < stride; c += 8) {
+                __m256d a_re = _mm256_load_pd(ar + c), a_im = _mm256_load_pd(ai + c);
+                __m256d x_re = _mm256_load_pd(xr + c), x_im = _mm256_load_pd(xi + c);
+                re0 = _mm256_fnmadd_pd(a_im, x_im, _mm256_fmadd_pd(a_re, x_re, re0));
+                im0 = _mm256_fmadd_pd(a_im, x_re, _mm256_fmadd_pd(a_re, x_im, im0));
+
+                a_re = _mm256_load_pd(ar + c + 4);
+                a_im = _mm256_load_pd(ai + c + 4);
+                x_re = _mm256_load_pd(xr + c + 4);
+                x_im = _mm256_load_pd(xi + c + 4);
+                re1 = _mm256_fnmadd_pd(a_im, x_im, _mm256_fmadd_pd(a_re, x_re, re1));
+                im1 = _mm256_fmadd_pd(a_im, x_re, _mm256_fmadd_pd(a_re, x_im, im1));
+            }
+            yr[r] = horizontal_sum(_mm256_add_pd(re0, re1));
+            yi[r] = horizontal_sum(_mm256_add_pd(im0, im1));
+        }
+    }
+
+    __attribute__((target("avx2,fma")))
+    double squared_norm_avx2(const double* re, const double* im, size_t padded) {
+        __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+        for (size_t i = 0; i < padded; i += 8) {
+            __m256d r0 = _mm256_load_pd(re + i), i0 = _mm256_load_pd(im + i);
+            __m256d r1 = _mm256_load_pd(re + i + 4), i1 = _mm256_load_pd(im + i + 4);
+            sum0 = _mm256_fmadd_pd(i0, i0, _mm256_fmadd_pd(r0, r0, sum0));
+            sum1 = _mm256_fmadd_pd(i1, i1, _mm256_fmadd_pd(r1, r1, sum1));
+        }
+        return horizontal_sum(_mm256_add_pd(sum0, sum1));
+    }
+
+    // Like _mm512_reduce_add_pd. GCC 12 builds that (and the plain 256-bit
+    // extracts and casts) on _mm256_undefined_pd, which trips
+    // -Wuninitialized; the masked extract takes an explicit source instead.
+    __attribute__((target("avx512f")))
+    double horizontal_sum(__m512d v) {
+        __m256d low = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 0);
+        __m256d high = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 1);
+        __m256d sum = _mm256_add_pd(low, high);
+        __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    }
+
+    __attribute__((target("avx512f")))
+    void matvec_avx512(const ComplexMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                      size_t begin, size_t end) {
+        size_t stride = m.stride();
+        for (size_t r = begin; r < end; ++r) {
+            const double* ar = m.row_re(r);
+            const double* ai = m.row_im(r);
+            __m512d re0 = _mm512_setzero_pd(), im0 = _mm512_setzero_pd();
+            __m512d re1 = _mm512_setzero_pd(), im1 = _mm512_setzero_pd();
+            size_t c = 0;
+            for (; c + 16 <= stride; c += 16) {
+                __m512d a_re = _mm512_load_pd(ar + c), a_im = _mm512_load_pd(ai + c);
+                __m512d x_re = _mm512_load_pd(xr + c), x_im = _mm512_load_pd(xi + c);
+                re0 = _mm512_fnmadd_pd(a_im, x_im, _mm512_fmadd_pd(a_re, x_re, re0));
+                im0 = _mm512_fmadd_pd(a_im, x_re, _mm512_fmadd_pd(a_re, x_im, im0));
+
+                a_re = _mm512_load_pd(ar + c + 8);
+                a_im = _mm512_load_pd(ai + c + 8);
+                x_re = _mm512_load_pd(xr + c + 8);
+                x_im = _mm512_load_pd(xi + c + 8);
+                re1 = _mm512_fnmadd_pd(a_im, x_im, _mm512_fmadd_pd(a_re, x_re, re1));
+                im1 = _mm512_fmadd_pd(a_im, x_re, _mm512_fmadd_pd(a_re, x_im, im1));
+            }
+            if (c < stride) {
+                __m512d a_re = _mm512_load_pd(ar + c), a_im = _mm512_load_pd(ai + c);
+                __m512d x_re = _mm512_load_pd(xr + c), x_im = _mm512_load_pd(xi + c);
+                re0 = _mm512_fnmadd_pd(a_im, x_im, _mm512_fmadd_pd(a_re, x_re, re0));
+                im0 = _mm512_fmadd_pd(a_im, x_re, _mm512_fmadd_pd(a_re, x_im, im0));
+            }
+            yr[r] = horizontal_sum(_mm512_add_pd(re0, re1));
+            yi[r] = horizontal_sum(_mm512_add_pd(im0, im1));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    double squared_norm_avx512(const double* re, const double* im, size_t padded) {
+        __m512d sum = _mm512_setzero_pd();
+        for (size_t i = 0; i < padded; i += 8) {
+            __m512d r = _mm512_load_pd(re + i), m = _mm512_load_pd(im + i);
+            sum = _mm512_fmadd_pd(m, m, _mm512_fmadd_pd(r, r, sum));
+        }
+        return horizontal_sum(sum);
+    }
+
+    // Diagonals are read unaligned: x is shifted by the diagonal's offset,
+    // and slices start on arbitrary rows
+    __attribute__((target("avx2,fma")))
+    void banded_avx2(const BandedMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                     size_t begin, size_t end) {
+        clear_rows(yr, yi, begin, end);
+        for (size_t d = 0; d < m.diagonal_count(); ++d) {
+            const double* dr = m.diagonal(d).re.data();
+            const double* di = m.diagonal(d).im.data();
+            size_t first, last;
+            diagonal_rows(m, d, begin, end, first, last);
+            if (first >= last) continue;
+            ptrdiff_t shift = m.offset(d); // i + shift is in range for every row used
+            size_t i = first;
+            for (; i + 4 <= last; i += 4) {
+                __m256d a_re = _mm256_loadu_pd(dr + i), a_im = _mm256_loadu_pd(di + i);
+                __m256d x_re = _mm256_loadu_pd(xr + i + shift), x_im = _mm256_loadu_pd(xi + i + shift);
+                __m256d y_re = _mm256_loadu_pd(yr + i), y_im = _mm256_loadu_pd(yi + i);
+                _mm256_storeu_pd(yr + i, _mm256_fnmadd_pd(a_im, x_im, _mm256_fmadd_pd(a_re, x_re, y_re)));
+                _mm256_storeu_pd(yi + i, _mm256_fmadd_pd(a_im, x_re, _mm256_fmadd_pd(a_re, x_im, y_im)));
+            }
+            for (; i < last; ++i) {
+                yr[i] += dr[i] * xr[i + shift] - di[i] * xi[i + shift];
+                yi[i] += dr[i] * xi[i + shift] + di[i] * xr[i + shift];
+            }
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void banded_avx512(const BandedMatrixSoA& m, const double* xr, const double* xi, double* yr, double* yi,
+                       size_t begin, size_t end) {
+        clear_rows(yr, yi, begin, end);
+        for (size_t d = 0; d < m.diagonal_count(); ++d) {
+            const double* dr = m.diagonal(d).re.data();
+            const double* di = m.diagonal(d).im.data();
+            size_t first, last;
+            diagonal_rows(m, d, begin, end, first, last);
+            if (first >= last) continue;
+            ptrdiff_t shift = m.offset(d); // i + shift is in range for every row used
+            size_t i = first;
+            for (; i + 8 <= last; i += 8) {
+                __m512d a_re = _mm512_loadu_pd(dr + i), a_im = _mm512_loadu_pd(di + i);
+                __m512d x_re = _mm512_loadu_pd(xr + i + shift), x_im = _mm512_loadu_pd(xi + i + shift);
+                __m512d y_re = _mm512_loadu_pd(yr + i), y_im = _mm512_loadu_pd(yi + i);
+                _mm512_storeu_pd(yr + i, _mm512_fnmadd_pd(a_im, x_im, _mm512_fmadd_pd(a_re, x_re, y_re)));
+                _mm512_storeu_pd(yi + i, _mm512_fmadd_pd(a_im, x_re, _mm512_fmadd_pd(a_re, x_im, y_im)));
+            }
+            if (i < last) {
+                __mmask8 mask = static_cast<__mmask8>((1u << (last - i)) - 1);
+                __m512d a_re = _mm512_maskz_loadu_pd(mask, dr + i), a_im = _mm512_maskz_loadu_pd(mask, di + i);
+                __m512d x_re = _mm512_maskz_loadu_pd(mask, xr + i + shift), x_im = _mm512_maskz_loadu_pd(mask, xi + i + shift);
+                __m512d y_re = _mm512_maskz_loadu_pd(mask, yr + i), y_im = _mm512_maskz_loadu_pd(mask, yi + i);
+                _mm512_mask_storeu_pd(yr + i, mask, _mm512_fnmadd_pd(a_im, x_im, _mm512_fmadd_pd(a_re, x_re, y_re)));
+                _mm512_mask_storeu_pd(yi + i, mask, _mm512_fmadd_pd(a_im, x_re, _mm512_fmadd_pd(a_re, x_im, y_im)));
+            }
+        }
+    }
+
+    bool backend_supported(KernelBackend backend) {
+        switch (backend) {
+            case KernelBackend::AVX512: return __builtin_cpu_supports("avx512f");
+            case KernelBackend::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            default: return true;
+        }
+    }
+
+#else
+
+    bool backend_supported(KernelBackend backend) {
+        return backend == KernelBackend::Scalar || backend == KernelBackend::Auto;
+    }
+
+#endif
+
+} // namespace
+
+namespace QuantumKernels {
+
+    KernelBackend best_backend() {
+        static const KernelBackend best = [] {
+            for (KernelBackend backend : {KernelBackend::AVX512, KernelBackend::AVX2}) {
+                if (backend_supported(backend)) return backend;
+            }
+            return KernelBackend::Scalar;
+        }();
+        return best;
+    }
+
+    KernelBackend resolve(KernelBackend backend) {
+        if (backend == KernelBackend::Auto) return best_backend();
+        while (backend != KernelBackend::Scalar && !backend_supported(backend)) {
+            backend = static_cast<KernelBackend>(static_cast<int>(backend) - 1);
+        }
+        return backend;
+    }
+
+    void matvec(const ComplexMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y, KernelBackend backend) {
+        if (x.size() != m.cols()) {
+            throw std::runtime_error("QuantumKernels::matvec: vector size does not match the matrix");
+        }
+        if (y.size() != m.rows()) y = ComplexVectorSoA(m.rows());
+
+        auto kernel = matvec_scalar;
+        switch (resolve(backend)) {
+#if QUANTUM_KERNELS_SIMD
+            case KernelBackend::AVX512: kernel = matvec_avx512; break;
+            case KernelBackend::AVX2: kernel = matvec_avx2; break;
+#endif
+            default: break;
+        }
+        for_row_slices(m.rows(), m.cols(), [&](size_t begin, size_t end) {
+            kernel(m, x.re.data(), x.im.data(), y.re.data(), y.im.data(), begin, end);
+        });
+    }
+
+    void matvec(const BandedMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y, KernelBackend backend) {
+        if (x.size() != m.size()) {
+            throw std::runtime_error("QuantumKernels::matvec: vector size does not match the matrix");
+        }
+        if (y.size() != m.size()) y = ComplexVectorSoA(m.size());
+
+        auto kernel = banded_scalar;
+        switch (resolve(backend)) {
+#if QUANTUM_KERNELS_SIMD
+            case KernelBackend::AVX512: kernel = banded_avx512; break;
+            case KernelBackend::AVX2: kernel = banded_avx2; break;
+#endif
+            default: break;
+        }
+        for_row_slices(m.size(), m.diagonal_count(), [&](size_t begin, size_t end) {
+            kernel(m, x.re.data(), x.im.data(), y.re.data(), y.im.data(), begin, end);
+        });
+    }
+
+    void matvec(const CsrMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y) {
+        if (x.size() != m.cols()) {
+            throw std::runtime_error("QuantumKernels::matvec: vector size does not match the matrix");
+        }
+        if (y.size() != m.rows()) y = ComplexVectorSoA(m.rows());
+
+        size_t per_row = m.rows() ? m.nonzeros() / m.rows() : 0;
+        for_row_slices(m.rows(), per_row, [&](size_t begin, size_t end) {
+            csr_scalar(m, x.re.data(), x.im.data(), y.re.data(), y.im.data(), begin, end);
+        });
+    }
+
+    double squared_norm(const ComplexVectorSoA& x, KernelBackend backend) {
+        switch (resolve(backend)) {
+#if QUANTUM_KERNELS_SIMD
+            case KernelBackend::AVX512: return squared_norm_avx512(x.re.data(), x.im.data(), x.padded_size());
+            case KernelBackend::AVX2: return squared_norm_avx2(x.re.data(), x.im.data(), x.padded_size());
+#endif
+            default: return squared_norm_scalar(x.re.data(), x.im.data(), x.size());
+        }
+    }
+
+    void scale(ComplexVectorSoA& x, double factor) {
+        // Plain loop over the padded length; compilers vectorize it at -O2
+        double* re = x.re.data();
+        double* im = x.im.data();
+        for (size_t i = 0; i < x.padded_size(); ++i) {
+            re[i] *= factor;
+            im[i] *= factor;
+        }
+    }
+
+    // Plain loops as well. Without -ffast-math the dot reduction stays
+    // scalar, which is cheap next to the mat-vec it always accompanies.
+
+    std::complex<double> dot(const ComplexVectorSoA& x, const ComplexVectorSoA& y) {
+        const double* xr = x.re.data();
+        const double* xi = x.im.data();
+        const double* yr = y.re.data();
+        const double* yi = y.im.data();
+        double sum_re = 0.0, sum_im = 0.0;
+        for (size_t i = 0; i < x.padded_size(); ++i) {
+            sum_re += xr[i] * yr[i] + xi[i] * yi[i];
+            sum_im += xr[i] * yi[i] - xi[i] * yr[i];
+        }
+        return {sum_re, sum_im};
+    }
+
+    void axpy(std::complex<double> a, const ComplexVectorSoA& x, ComplexVectorSoA& y) {
+        const double* xr = x.re.data();
+        const double* xi = x.im.data();
+        double* yr = y.re.data();
+        double* yi = y.im.data();
+        double ar = a.real(), ai = a.imag();
+        for (size_t i = 0; i < x.padded_size(); ++i) {
+            yr[i] += ar * xr[i] - ai * xi[i];
+            yi[i] += ar * xi[i] + ai * xr[i];
+        }
+    }
+
+} // namespace QuantumKernels
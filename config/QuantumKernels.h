@@ -0,0 +1,75 @@
+// QuantumKernels.h - Vectorized complex linear algebra on SoA storage.
+// Each kernel has a scalar reference and AVX2 (with FMA) and AVX-512
+// versions, compiled through target attributes and picked at runtime. SIMD
+// results match the scalar reference up to rounding; the order of the
+// additions differs. Mat-vecs over large matrices are split by rows across
+// the AsyncScheduler workers with parallel_for.
+
+#pragma once
+
+#include "SimdStorage.h"
+#include "SparseMatrix.h"
+
+// Instruction sets the kernels can run on.
+enum class KernelBackend {
+    Auto,   // Widest one the CPU supports
+    Scalar,
+    AVX2,   // AVX2 + FMA, 4 doubles per register
+    AVX512  // AVX-512F, 8 doubles per register
+};
+
+namespace QuantumKernels {
+
+    // The backend used for KernelBackend::Auto
+    KernelBackend best_backend();
+
+    // A backend the CPU lacks steps down to the next narrower one
+    KernelBackend resolve(KernelBackend backend);
+
+    // y = m * x. x must have m.cols() elements and must not be y; y is
+    // resized to m.rows().
+    void matvec(const ComplexMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y,
+                KernelBackend backend = KernelBackend::Auto);
+    void matvec(const BandedMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y,
+                KernelBackend backend = KernelBackend::Auto);
+    // Gathers through the column indices; scalar on every backend
+    void matvec(const CsrMatrixSoA& m, const ComplexVectorSoA& x, ComplexVectorSoA& y);
+
+    // Sum of |x_i|^2
+    double squared_norm(const ComplexVectorSoA& x, KernelBackend backend = KernelBackend::Auto);
+
+    // x *= factor
+    void scale(ComplexVectorSoA& x, double factor);
+
+    // Sum of conj(x_i) * y_i; x and y must have the same size
+    std::complex<double> dot(const ComplexVectorSoA& x, const ComplexVectorSoA& y);
+
+    // y += a * x; x and y must have the same size
+    void axpy(std::complex<double> a, const ComplexVectorSoA& x, ComplexVectorSoA& y);
+
+    // Batched kernels (QuantumBatchKernels.cpp). A batch is a
+    // ComplexMatrixSoA holding one state per column, so row r is amplitude
+    // r of every state and a vector register spans several states. Each
+    // call covers the columns [begin, end), where begin is a multiple of
+    // BATCH_COLUMN_ALIGNMENT; callers split a batch between threads that
+    // way. Nothing is parallelized inside.
+    constexpr size_t BATCH_COLUMN_ALIGNMENT = SIMD_ALIGNMENT / sizeof(double);
+
+    // Columns [begin, end) of y = m * x. x must have m.cols() rows and
+    // must not be y; y must already have x's shape. The dense product is
+    // cache blocked so a tile of m is reused across the columns.
+    void matmul(const ComplexMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend = KernelBackend::Auto);
+    void matmul(const BandedMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend = KernelBackend::Auto);
+    void matmul(const CsrMatrixSoA& m, const ComplexMatrixSoA& x, ComplexMatrixSoA& y,
+                size_t begin, size_t end, KernelBackend backend = KernelBackend::Auto);
+
+    // For every column c in [begin, end): the sum of |x[r][c]|^2 and the
+    // largest |x[r][c]|^2 with its row. The outputs are indexed by column
+    // and need x.stride() entries.
+    void column_statistics(const ComplexMatrixSoA& x, size_t begin, size_t end, double* squared_norms,
+                           double* peak_probabilities, size_t* peak_rows,
+                           KernelBackend backend = KernelBackend::Auto);
+
+} // namespace QuantumKernels
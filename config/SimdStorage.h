@@ -0,0 +1,105 @@
+// SimdStorage.h - Cache-line aligned structure-of-arrays numeric storage.
+// Complex data is kept as separate real and imaginary arrays, so a vector
+// register holds 4 or 8 real parts rather than interleaved pairs. Every
+// array starts on a 64-byte boundary and is padded with zeros to a whole
+// number of cache lines. SIMD loops can therefore run over the padded length
+// with aligned loads and no remainder handling.
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+constexpr size_t SIMD_ALIGNMENT = 64;
+
+// Rounds n up to a whole number of cache lines worth of doubles
+constexpr size_t simd_padded(size_t n) {
+    constexpr size_t lanes = SIMD_ALIGNMENT / sizeof(double);
+    return (n + lanes - 1) / lanes * lanes;
+}
+
+template<typename T, size_t Align = SIMD_ALIGNMENT>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() noexcept = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        ::operator delete(ptr, std::align_val_t(Align));
+    }
+};
+
+template<typename T, typename U, size_t Align>
+bool operator==(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&) noexcept { return true; }
+
+template<typename T, typename U, size_t Align>
+bool operator!=(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&) noexcept { return false; }
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Complex vector of size() elements; entries past size() are always zero.
+struct ComplexVectorSoA {
+    AlignedVector<double> re;
+    AlignedVector<double> im;
+
+    ComplexVectorSoA() = default;
+    explicit ComplexVectorSoA(size_t size)
+        : re(simd_padded(size), 0.0), im(simd_padded(size), 0.0), m_size(size) {}
+
+    size_t size() const { return m_size; }
+    size_t padded_size() const { return re.size(); }
+
+    std::complex<double> get(size_t i) const { return {re[i], im[i]}; }
+    void set(size_t i, std::complex<double> value) {
+        re[i] = value.real();
+        im[i] = value.imag();
+    }
+
+private:
+    size_t m_size = 0;
+};
+
+// Dense row-major complex matrix. Each row starts on a cache line; the
+// padding columns are zero, so a row times a padded vector needs no tail.
+class ComplexMatrixSoA {
+public:
+    ComplexMatrixSoA() = default;
+    ComplexMatrixSoA(size_t rows, size_t cols)
+        : m_rows(rows), m_cols(cols), m_stride(simd_padded(cols)),
+          m_re(rows * m_stride, 0.0), m_im(rows * m_stride, 0.0) {}
+
+    size_t rows() const { return m_rows; }
+    size_t cols() const { return m_cols; }
+    size_t stride() const { return m_stride; } // Doubles between row starts
+
+    const double* row_re(size_t r) const { return m_re.data() + r * m_stride; }
+    const double* row_im(size_t r) const { return m_im.data() + r * m_stride; }
+    double* row_re(size_t r) { return m_re.data() + r * m_stride; }
+    double* row_im(size_t r) { return m_im.data() + r * m_stride; }
+
+    std::complex<double> get(size_t r, size_t c) const { return {row_re(r)[c], row_im(r)[c]}; }
+    void set(size_t r, size_t c, std::complex<double> value) {
+        row_re(r)[c] = value.real();
+        row_im(r)[c] = value.imag();
+    }
+
+private:
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    size_t m_stride = 0;
+    AlignedVector<double> m_re;
+    AlignedVector<double> m_im;
+};
@@ -0,0 +1,152 @@
+// SparseMatrix.cpp - Construction of the sparse formats and format choice.
+
+#include "SparseMatrix.h"
+#include "QuantumKernels.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+    bool row_major_less(const MatrixEntry& a, const MatrixEntry& b) {
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    }
+
+    ptrdiff_t diagonal_of(const MatrixEntry& entry) {
+        return static_cast<ptrdiff_t>(entry.col) - static_cast<ptrdiff_t>(entry.row);
+    }
+
+    // Distinct diagonals of the entries, ascending
+    std::vector<ptrdiff_t> diagonal_offsets(std::span<const MatrixEntry> entries) {
+        std::vector<ptrdiff_t> offsets;
+        offsets.reserve(entries.size());
+        for (const MatrixEntry& entry : entries) offsets.push_back(diagonal_of(entry));
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+        return offsets;
+    }
+
+    void check_bounds(size_t rows, size_t cols, std::span<const MatrixEntry> entries) {
+        for (const MatrixEntry& entry : entries) {
+            if (entry.row >= rows || entry.col >= cols) {
+                throw std::runtime_error("Sparse matrix entry lies outside the matrix");
+            }
+        }
+    }
+
+} // namespace
+
+CsrMatrixSoA::CsrMatrixSoA(size_t rows, size_t cols, std::span<const MatrixEntry> entries)
+    : m_rows(rows), m_cols(cols), m_row_offsets(rows + 1, 0) {
+    if (cols > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("CsrMatrixSoA supports at most 2^32 columns");
+    }
+    if (!std::is_sorted(entries.begin(), entries.end(), row_major_less)) {
+        throw std::runtime_error("CsrMatrixSoA entries must be sorted by row and column");
+    }
+    check_bounds(rows, cols, entries);
+
+    m_columns.reserve(entries.size());
+    m_re.reserve(entries.size());
+    m_im.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const MatrixEntry& entry = entries[i];
+        if (i > 0 && entry.row == entries[i - 1].row && entry.col == entries[i - 1].col) {
+            m_re.back() += entry.value.real();
+            m_im.back() += entry.value.imag();
+            continue;
+        }
+        m_columns.push_back(static_cast<uint32_t>(entry.col));
+        m_re.push_back(entry.value.real());
+        m_im.push_back(entry.value.imag());
+        ++m_row_offsets[entry.row + 1];
+    }
+    for (size_t r = 0; r < rows; ++r) m_row_offsets[r + 1] += m_row_offsets[r];
+}
+
+size_t CsrMatrixSoA::memory_bytes() const {
+    return m_row_offsets.size() * sizeof(size_t) + m_columns.size() * sizeof(uint32_t) +
+           (m_re.size() + m_im.size()) * sizeof(double);
+}
+
+BandedMatrixSoA::BandedMatrixSoA(size_t size, std::span<const MatrixEntry> entries)
+    : m_size(size), m_offsets(diagonal_offsets(entries)) {
+    check_bounds(size, size, entries);
+
+    m_diagonals.reserve(m_offsets.size());
+    for (size_t d = 0; d < m_offsets.size(); ++d) m_diagonals.emplace_back(size);
+    for (const MatrixEntry& entry : entries) {
+        size_t d = std::lower_bound(m_offsets.begin(), m_offsets.end(), diagonal_of(entry)) - m_offsets.begin();
+        ComplexVectorSoA& diagonal = m_diagonals[d];
+        diagonal.set(entry.row, diagonal.get(entry.row) + entry.value);
+    }
+}
+
+size_t BandedMatrixSoA::memory_bytes() const {
+    size_t bytes = m_offsets.size() * sizeof(ptrdiff_t);
+    for (const ComplexVectorSoA& diagonal : m_diagonals) bytes += 2 * diagonal.padded_size() * sizeof(double);
+    return bytes;
+}
+
+MatrixFormat HamiltonianMatrix::choose_format(size_t size, std::span<const MatrixEntry> entries) {
+    if (size == 0) return MatrixFormat::Dense;
+    double density = static_cast<double>(entries.size()) / (static_cast<double>(size) * static_cast<double>(size));
+    if (density >= 0.25) return MatrixFormat::Dense;
+    size_t diagonals = diagonal_offsets(entries).size();
+    return diagonals * size <= 2 * entries.size() ? MatrixFormat::Banded : MatrixFormat::CSR;
+}
+
+HamiltonianMatrix::HamiltonianMatrix(size_t size, std::vector<MatrixEntry> entries, MatrixFormat format)
+    : m_size(size) {
+    m_format = format == MatrixFormat::Auto ? choose_format(size, entries) : format;
+    switch (m_format) {
+        case MatrixFormat::Banded:
+            m_banded = BandedMatrixSoA(size, entries);
+            break;
+        case MatrixFormat::CSR:
+            if (!std::is_sorted(entries.begin(), entries.end(), row_major_less)) {
+                std::sort(entries.begin(), entries.end(), row_major_less);
+            }
+            m_csr = CsrMatrixSoA(size, size, entries);
+            break;
+        default:
+            check_bounds(size, size, entries);
+            m_dense = ComplexMatrixSoA(size, size);
+            for (const MatrixEntry& entry : entries) {
+                m_dense.set(entry.row, entry.col, m_dense.get(entry.row, entry.col) + entry.value);
+            }
+            break;
+    }
+}
+
+size_t HamiltonianMatrix::memory_bytes() const {
+    switch (m_format) {
+        case MatrixFormat::Banded: return m_banded.memory_bytes();
+        case MatrixFormat::CSR: return m_csr.memory_bytes();
+        default: return 2 * m_dense.rows() * m_dense.stride() * sizeof(double);
+    }
+}
+
+size_t HamiltonianMatrix::nonzeros() const {
+    switch (m_format) {
+        case MatrixFormat::Banded: return m_banded.diagonal_count() * m_size;
+        case MatrixFormat::CSR: return m_csr.nonzeros();
+        default: return m_size * m_size;
+    }
+}
+
+void HamiltonianMatrix::apply(const ComplexVectorSoA& x, ComplexVectorSoA& y) const {
+    switch (m_format) {
+        case MatrixFormat::Banded: QuantumKernels::matvec(m_banded, x, y); break;
+        case MatrixFormat::CSR: QuantumKernels::matvec(m_csr, x, y); break;
+        default: QuantumKernels::matvec(m_dense, x, y); break;
+    }
+}
+
+void HamiltonianMatrix::apply(const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end) const {
+    switch (m_format) {
+        case MatrixFormat::Banded: QuantumKernels::matmul(m_banded, x, y, begin, end); break;
+        case MatrixFormat::CSR: QuantumKernels::matmul(m_csr, x, y, begin, end); break;
+        default: QuantumKernels::matmul(m_dense, x, y, begin, end); break;
+    }
+}
@@ -0,0 +1,112 @@
+// SparseMatrix.h - Sparse complex matrix formats for Hamiltonians.
+// Nearest-neighbour style Hamiltonians have a handful of entries per row, so
+// dense storage wastes O(n^2) memory and time. Two sparse layouts are
+// offered next to ComplexMatrixSoA:
+//   BandedMatrixSoA - one aligned SoA vector per occupied diagonal; best when
+//                     the entries sit on a few diagonals, and its mat-vec is
+//                     plain SIMD streaming
+//   CsrMatrixSoA    - compressed sparse rows for arbitrary patterns
+// HamiltonianMatrix holds one of the three and picks the format from the
+// sparsity pattern unless one is requested.
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "SimdStorage.h"
+
+enum class MatrixFormat {
+    Auto,   // Chosen from the sparsity pattern
+    Dense,
+    Banded,
+    CSR
+};
+
+struct MatrixEntry {
+    size_t row;
+    size_t col;
+    std::complex<double> value;
+};
+
+// Compressed sparse rows. Column indices are 32-bit, which caps the number
+// of columns at 2^32.
+class CsrMatrixSoA {
+public:
+    CsrMatrixSoA() = default;
+    // Entries must be sorted by row, then column; duplicates are summed.
+    CsrMatrixSoA(size_t rows, size_t cols, std::span<const MatrixEntry> entries);
+
+    size_t rows() const { return m_rows; }
+    size_t cols() const { return m_cols; }
+    size_t nonzeros() const { return m_columns.size(); }
+    size_t memory_bytes() const;
+
+    // Entries of row r are [row_offsets()[r], row_offsets()[r + 1])
+    const size_t* row_offsets() const { return m_row_offsets.data(); }
+    const uint32_t* columns() const { return m_columns.data(); }
+    const double* values_re() const { return m_re.data(); }
+    const double* values_im() const { return m_im.data(); }
+
+private:
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    std::vector<size_t> m_row_offsets;
+    AlignedVector<uint32_t> m_columns;
+    AlignedVector<double> m_re;
+    AlignedVector<double> m_im;
+};
+
+// Square matrix stored by diagonals: diagonal(d)[i] is the entry at
+// (i, i + offset(d)). Positions that fall outside the matrix are zero.
+class BandedMatrixSoA {
+public:
+    BandedMatrixSoA() = default;
+    // Duplicates are summed.
+    BandedMatrixSoA(size_t size, std::span<const MatrixEntry> entries);
+
+    size_t size() const { return m_size; }
+    size_t diagonal_count() const { return m_offsets.size(); }
+    ptrdiff_t offset(size_t d) const { return m_offsets[d]; }
+    const ComplexVectorSoA& diagonal(size_t d) const { return m_diagonals[d]; }
+    size_t memory_bytes() const;
+
+private:
+    size_t m_size = 0;
+    std::vector<ptrdiff_t> m_offsets; // Ascending
+    std::vector<ComplexVectorSoA> m_diagonals;
+};
+
+// A square Hamiltonian in whichever format suits its sparsity.
+class HamiltonianMatrix {
+public:
+    HamiltonianMatrix() = default;
+    // Entries may come in any order; duplicates are summed.
+    HamiltonianMatrix(size_t size, std::vector<MatrixEntry> entries, MatrixFormat format = MatrixFormat::Auto);
+
+    // Dense from 25% density up; below that banded if the entries fill at
+    // least half of their diagonals, else CSR.
+    static MatrixFormat choose_format(size_t size, std::span<const MatrixEntry> entries);
+
+    MatrixFormat format() const { return m_format; }
+    size_t size() const { return m_size; }
+    size_t memory_bytes() const;
+    // Stored entries, padding excluded; the multiply-adds per mat-vec
+    size_t nonzeros() const;
+
+    // y = H x, split across AsyncScheduler workers for large matrices
+    void apply(const ComplexVectorSoA& x, ComplexVectorSoA& y) const;
+
+    // Columns [begin, end) of y = H x for a batch with one state per
+    // column; see QuantumKernels::matmul. Runs on the calling thread.
+    void apply(const ComplexMatrixSoA& x, ComplexMatrixSoA& y, size_t begin, size_t end) const;
+
+private:
+    size_t m_size = 0;
+    MatrixFormat m_format = MatrixFormat::Dense;
+    ComplexMatrixSoA m_dense;
+    BandedMatrixSoA m_banded;
+    CsrMatrixSoA m_csr;
+};
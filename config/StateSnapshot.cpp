@@ -0,0 +1,99 @@
+// StateSnapshot.cpp - Recycling pool for snapshot buffers.
+
+#include "StateSnapshot.h"
+#include "MemoryManager.h"
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+namespace {
+
+    // Idle buffers kept per size; more than this many are handed back to
+    // MemoryManager. Enough to cover the snapshots a few ticks keep alive.
+    constexpr size_t MAX_IDLE_PER_SIZE = 8;
+
+    class SnapshotPool {
+    public:
+        static SnapshotPool& getInstance() {
+            static SnapshotPool instance;
+            return instance;
+        }
+
+        detail::SnapshotBuffer* acquire(size_t size) {
+            MemoryManager& memory = MemoryManager::getInstance();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                drop_stale(memory.generation());
+                IdleList& idle = m_idle[size];
+                if (detail::SnapshotBuffer* buffer = idle.head) {
+                    idle.head = buffer->next_free;
+                    --idle.count;
+                    buffer->next_free = nullptr;
+                    buffer->references.store(1, std::memory_order_relaxed);
+                    return buffer;
+                }
+            }
+
+            void* memory_block = memory.allocate(sizeof(detail::SnapshotBuffer) + size * sizeof(std::complex<double>),
+                                                 "StateSnapshot");
+            if (!memory_block) throw std::bad_alloc();
+            auto* buffer = new (memory_block) detail::SnapshotBuffer();
+            buffer->size = size;
+            buffer->generation = memory.generation();
+            return buffer;
+        }
+
+        void recycle(detail::SnapshotBuffer* buffer) {
+            MemoryManager& memory = MemoryManager::getInstance();
+            uint64_t generation = memory.generation();
+            // Buffers from a released pool are already gone
+            if (buffer->generation != generation) return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                drop_stale(generation);
+                IdleList& idle = m_idle[buffer->size];
+                if (idle.count < MAX_IDLE_PER_SIZE) {
+                    buffer->next_free = idle.head;
+                    idle.head = buffer;
+                    ++idle.count;
+                    return;
+                }
+            }
+            buffer->~SnapshotBuffer();
+            memory.deallocate(buffer, "StateSnapshot");
+        }
+
+    private:
+        struct IdleList {
+            detail::SnapshotBuffer* head = nullptr;
+            size_t count = 0;
+        };
+
+        SnapshotPool() = default;
+
+        // Idle buffers went away with the previous MemoryManager pool
+        void drop_stale(uint64_t generation) {
+            if (generation == m_generation) return;
+            m_idle.clear();
+            m_generation = generation;
+        }
+
+        std::mutex m_mutex;
+        std::unordered_map<size_t, IdleList> m_idle;
+        uint64_t m_generation = 0;
+    };
+
+} // namespace
+
+namespace detail {
+
+    SnapshotBuffer* acquire_snapshot_buffer(size_t size) {
+        return SnapshotPool::getInstance().acquire(size);
+    }
+
+    void recycle_snapshot_buffer(SnapshotBuffer* buffer) {
+        SnapshotPool::getInstance().recycle(buffer);
+    }
+
+} // namespace detail
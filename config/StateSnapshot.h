@@ -0,0 +1,116 @@
+// StateSnapshot.h - Shared immutable snapshots of a quantum state.
+// A snapshot is one pooled buffer holding the amplitudes, energy and
+// timestamp behind an intrusive reference count. A StateSnapshot handle is
+// one pointer wide and copying it only bumps the count, so any number of
+// queued events and handlers can hold one tick's state without copying the
+// amplitudes. Released buffers go back to a pool keyed by amplitude count
+// and are reused by later snapshots of the same size.
+//
+// Buffers come from MemoryManager, so it must be initialized first, and
+// every handle must be gone before it shuts down.
+
+#pragma once
+
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace detail {
+
+    // Header of a pooled buffer; the amplitudes follow it in memory
+    struct SnapshotBuffer {
+        std::atomic<uint32_t> references{1};
+        size_t size = 0;
+        uint64_t generation = 0; // MemoryManager generation it came from
+        double energy_level = 0.0;
+        uint64_t timestamp = 0;
+        SnapshotBuffer* next_free = nullptr;
+
+        std::complex<double>* amplitudes() { return reinterpret_cast<std::complex<double>*>(this + 1); }
+        const std::complex<double>* amplitudes() const {
+            return reinterpret_cast<const std::complex<double>*>(this + 1);
+        }
+    };
+
+    static_assert(sizeof(SnapshotBuffer) % alignof(std::complex<double>) == 0,
+                  "Amplitudes must be aligned after the header");
+
+    // A buffer for size amplitudes with one reference
+    SnapshotBuffer* acquire_snapshot_buffer(size_t size);
+    // Called when the last reference goes away
+    void recycle_snapshot_buffer(SnapshotBuffer* buffer);
+
+} // namespace detail
+
+// Read-only handle to a published snapshot. Empty when default constructed.
+class StateSnapshot {
+public:
+    StateSnapshot() = default;
+    StateSnapshot(const StateSnapshot& other) noexcept : m_buffer(other.m_buffer) { retain(); }
+    StateSnapshot(StateSnapshot&& other) noexcept : m_buffer(std::exchange(other.m_buffer, nullptr)) {}
+    StateSnapshot& operator=(StateSnapshot other) noexcept {
+        std::swap(m_buffer, other.m_buffer);
+        return *this;
+    }
+    ~StateSnapshot() { release(); }
+
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+    size_t size() const { return m_buffer ? m_buffer->size : 0; }
+    std::span<const std::complex<double>> amplitudes() const {
+        if (!m_buffer) return {};
+        return {m_buffer->amplitudes(), m_buffer->size};
+    }
+    double energy_level() const { return m_buffer ? m_buffer->energy_level : 0.0; }
+    uint64_t timestamp() const { return m_buffer ? m_buffer->timestamp : 0; }
+
+    // Handles sharing this snapshot, this one included
+    size_t use_count() const { return m_buffer ? m_buffer->references.load(std::memory_order_acquire) : 0; }
+
+private:
+    friend class SnapshotPublisher;
+
+    explicit StateSnapshot(detail::SnapshotBuffer* buffer) noexcept : m_buffer(buffer) {}
+
+    void retain() noexcept {
+        if (m_buffer) m_buffer->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (m_buffer && m_buffer->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            detail::recycle_snapshot_buffer(m_buffer);
+        }
+        m_buffer = nullptr;
+    }
+
+    detail::SnapshotBuffer* m_buffer = nullptr;
+};
+
+// Publishes a producer's successive states copy-on-write. A new state is
+// written over the current snapshot's buffer when no other handle holds it
+// and into a fresh pooled buffer otherwise, so readers never see a
+// snapshot change. Owned by a single producer; not thread-safe.
+class SnapshotPublisher {
+public:
+    // fill(std::span<std::complex<double>>) writes the size amplitudes of
+    // the new snapshot; the span starts out with unspecified contents.
+    template<typename Fill>
+    const StateSnapshot& publish(size_t size, double energy_level, uint64_t timestamp, Fill&& fill) {
+        if (m_current.use_count() != 1 || m_current.size() != size) {
+            m_current = StateSnapshot(detail::acquire_snapshot_buffer(size));
+        }
+        detail::SnapshotBuffer* buffer = m_current.m_buffer;
+        fill(std::span<std::complex<double>>(buffer->amplitudes(), size));
+        buffer->energy_level = energy_level;
+        buffer->timestamp = timestamp;
+        return m_current;
+    }
+
+    const StateSnapshot& current() const { return m_current; }
+
+private:
+    StateSnapshot m_current;
+};
@@ -0,0 +1,388 @@
+// TaskGraph.h - Continuations and dependency graphs on top of AsyncScheduler.
+// Work is chained by scheduling successors when their inputs complete, so no
+// worker thread ever blocks waiting on another task's result.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "AsyncScheduler.h"
+#include "ObjectPool.h"
+
+template<typename T> class TaskFuture;
+
+namespace detail {
+
+    // Placeholder value for TaskFuture<void>
+    struct VoidResult {};
+
+    template<typename T>
+    using stored_result_t = std::conditional_t<std::is_void<T>::value, VoidResult, T>;
+
+    // Shared completion state behind a TaskFuture. The state and its
+    // continuation list come from the ObjectPool slot pools; a single
+    // continuation, the common case, takes one slot.
+    template<typename T>
+    class TaskFutureState {
+    public:
+        using value_type = stored_result_t<T>;
+        using Continuations = std::vector<TaskFunction, PoolAllocator<TaskFunction>>;
+
+        void set_value(value_type value) {
+            complete([&] { m_value.emplace(std::move(value)); });
+        }
+
+        void set_exception(std::exception_ptr error) {
+            complete([&] { m_error = std::move(error); });
+        }
+
+        // Runs fn once the state is ready, inline if it already is.
+        void on_ready(TaskFunction fn) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_ready) {
+                    m_continuations.push_back(std::move(fn));
+                    return;
+                }
+            }
+            fn();
+        }
+
+        bool is_ready() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_ready;
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready_condition.wait(lock, [this] { return m_ready; });
+        }
+
+        // Only valid once ready
+        const std::exception_ptr& error() const { return m_error; }
+        value_type& value() { return *m_value; }
+
+    private:
+        template<typename Store>
+        void complete(Store&& store) {
+            Continuations continuations;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_ready) return;
+                store();
+                m_ready = true;
+                continuations.swap(m_continuations);
+            }
+            m_ready_condition.notify_all();
+            for (auto& fn : continuations) fn();
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_ready_condition;
+        bool m_ready = false;
+        std::optional<value_type> m_value;
+        std::exception_ptr m_error;
+        Continuations m_continuations;
+    };
+
+    template<typename T>
+    std::shared_ptr<TaskFutureState<T>> make_task_state() {
+        return std::allocate_shared<TaskFutureState<T>>(PoolAllocator<TaskFutureState<T>>());
+    }
+
+    // Runs fn(args...) and stores its result or exception in state.
+    template<typename T, typename F, typename... Args>
+    void fulfill(TaskFutureState<T>& state, F& fn, Args&&... args) {
+        try {
+            if constexpr (std::is_void<T>::value) {
+                fn(std::forward<Args>(args)...);
+                state.set_value(VoidResult{});
+            } else {
+                state.set_value(fn(std::forward<Args>(args)...));
+            }
+        } catch (...) {
+            state.set_exception(std::current_exception());
+        }
+    }
+
+    template<typename T, typename F>
+    struct continuation_result {
+        using type = std::invoke_result_t<F, const T&>;
+    };
+
+    template<typename F>
+    struct continuation_result<void, F> {
+        using type = std::invoke_result_t<F>;
+    };
+
+} // namespace detail
+
+// A result that will be produced by a scheduled task.
+// Unlike std::future it supports continuations, so dependent work is
+// scheduled when the value arrives instead of parking a worker in get().
+template<typename T>
+class TaskFuture {
+public:
+    using State = detail::TaskFutureState<T>;
+
+    TaskFuture() = default;
+    explicit TaskFuture(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+    bool valid() const { return static_cast<bool>(m_state); }
+    bool is_ready() const { return m_state->is_ready(); }
+
+    // Blocking accessors, meant for threads outside the worker pool.
+    void wait() const { m_state->wait(); }
+
+    decltype(auto) get() const {
+        m_state->wait();
+        if (m_state->error()) std::rethrow_exception(m_state->error());
+        if constexpr (!std::is_void<T>::value) {
+            return static_cast<const T&>(m_state->value());
+        }
+    }
+
+    // Schedules fn on the given priority once this result is ready.
+    // fn receives the value (nothing for TaskFuture<void>). Errors skip fn
+    // and propagate to the returned future.
+    template<typename F>
+    auto then(F&& fn, TaskPriority priority = TaskPriority::NORMAL) const
+        -> TaskFuture<typename detail::continuation_result<T, std::decay_t<F>>::type> {
+        using U = typename detail::continuation_result<T, std::decay_t<F>>::type;
+        auto next = detail::make_task_state<U>();
+        auto self = m_state;
+        self->on_ready([self, next, priority, fn = std::forward<F>(fn)]() mutable {
+            if (self->error()) {
+                next->set_exception(self->error());
+                return;
+            }
+            AsyncScheduler::getInstance().post([self, next, fn = std::move(fn)]() mutable {
+                if constexpr (std::is_void<T>::value) {
+                    detail::fulfill(*next, fn);
+                } else {
+                    detail::fulfill(*next, fn, static_cast<const T&>(self->value()));
+                }
+            }, priority);
+        });
+        return TaskFuture<U>(std::move(next));
+    }
+
+    // Runs fn inline on whichever thread completes this future.
+    void on_ready(TaskFunction fn) const { m_state->on_ready(std::move(fn)); }
+
+    const std::shared_ptr<State>& state() const { return m_state; }
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+// Schedules fn on AsyncScheduler and returns a TaskFuture for its result.
+template<typename F>
+auto spawn_task(F&& fn, TaskPriority priority = TaskPriority::NORMAL) -> TaskFuture<std::invoke_result_t<std::decay_t<F>>> {
+    using R = std::invoke_result_t<std::decay_t<F>>;
+    auto state = detail::make_task_state<R>();
+    AsyncScheduler::getInstance().post([state, fn = std::forward<F>(fn)]() mutable {
+        detail::fulfill(*state, fn);
+    }, priority);
+    return TaskFuture<R>(std::move(state));
+}
+
+// A future that is already complete.
+template<typename T>
+TaskFuture<T> make_ready_task(T value) {
+    auto state = detail::make_task_state<T>();
+    state->set_value(std::move(value));
+    return TaskFuture<T>(std::move(state));
+}
+
+inline TaskFuture<void> make_ready_task() {
+    auto state = detail::make_task_state<void>();
+    state->set_value(detail::VoidResult{});
+    return TaskFuture<void>(std::move(state));
+}
+
+// Completes when every input has completed. Values keep the input order;
+// the first error seen is propagated instead.
+template<typename T>
+auto when_all(std::vector<TaskFuture<T>> inputs)
+    -> TaskFuture<std::conditional_t<std::is_void<T>::value, void, std::vector<T>>> {
+    using R = std::conditional_t<std::is_void<T>::value, void, std::vector<T>>;
+    auto result = detail::make_task_state<R>();
+    if (inputs.empty()) {
+        result->set_value(detail::stored_result_t<R>{});
+        return TaskFuture<R>(std::move(result));
+    }
+
+    struct Join {
+        std::vector<TaskFuture<T>> inputs;
+        std::atomic<size_t> remaining;
+    };
+    auto join = std::allocate_shared<Join>(PoolAllocator<Join>());
+    join->remaining.store(inputs.size(), std::memory_order_relaxed);
+    join->inputs = std::move(inputs);
+
+    for (const auto& input : join->inputs) {
+        input.on_ready([join, result] {
+            if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            for (const auto& in : join->inputs) {
+                if (in.state()->error()) {
+                    result->set_exception(in.state()->error());
+                    return;
+                }
+            }
+            if constexpr (std::is_void<T>::value) {
+                result->set_value(detail::VoidResult{});
+            } else {
+                std::vector<T> values;
+                values.reserve(join->inputs.size());
+                for (const auto& in : join->inputs) values.push_back(in.state()->value());
+                result->set_value(std::move(values));
+            }
+        });
+    }
+    return TaskFuture<R>(std::move(result));
+}
+
+// Completes with the index of the first input to complete, successfully or not.
+template<typename T>
+TaskFuture<size_t> when_any(const std::vector<TaskFuture<T>>& inputs) {
+    auto result = detail::make_task_state<size_t>();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i].on_ready([result, i] { result->set_value(i); });
+    }
+    return TaskFuture<size_t>(std::move(result));
+}
+
+// A reusable DAG of tasks. Each node is scheduled as soon as all of its
+// predecessors have finished; run() returns a future for the whole graph.
+// The graph must stay alive, and unmodified, until that future completes.
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    NodeId add(TaskFunction fn, TaskPriority priority = TaskPriority::NORMAL) {
+        auto node = std::make_unique<Node>();
+        node->fn = std::move(fn);
+        node->priority = priority;
+        m_nodes.push_back(std::move(node));
+        return m_nodes.size() - 1;
+    }
+
+    // after will not start until before has finished. Throws
+    // std::invalid_argument if after already leads to before: the nodes of a
+    // cycle would never be scheduled and run() would never complete.
+    void precede(NodeId before, NodeId after) {
+        Node& from = *m_nodes.at(before);
+        Node& to = *m_nodes.at(after);
+        if (reaches(after, before)) throw std::invalid_argument("TaskGraph::precede would create a cycle");
+        from.successors.push_back(after);
+        to.predecessor_count++;
+    }
+
+    // Launches every node without predecessors. If a node throws, the nodes
+    // that depend on it are skipped and the error is reported through the future.
+    TaskFuture<void> run() {
+        m_completion = detail::make_task_state<void>();
+        TaskFuture<void> done(m_completion);
+        if (m_nodes.empty()) {
+            m_completion->set_value(detail::VoidResult{});
+            return done;
+        }
+
+        m_remaining.store(m_nodes.size(), std::memory_order_relaxed);
+        m_error = nullptr;
+        for (auto& node : m_nodes) {
+            node->pending.store(node->predecessor_count, std::memory_order_relaxed);
+            node->skipped.store(false, std::memory_order_relaxed);
+        }
+        for (NodeId id = 0; id < m_nodes.size(); ++id) {
+            if (m_nodes[id]->predecessor_count == 0) schedule(id);
+        }
+        return done;
+    }
+
+    size_t size() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        TaskFunction fn;
+        TaskPriority priority = TaskPriority::NORMAL;
+        std::vector<NodeId> successors;
+        size_t predecessor_count = 0;
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> skipped{false};
+    };
+
+    // Whether target can be reached from start along successor edges. Graphs
+    // are usually built towards new nodes, which have no successors yet.
+    bool reaches(NodeId start, NodeId target) const {
+        if (start == target) return true;
+        if (m_nodes[start]->successors.empty()) return false;
+        std::vector<bool> seen(m_nodes.size());
+        std::vector<NodeId> stack{start};
+        seen[start] = true;
+        while (!stack.empty()) {
+            NodeId id = stack.back();
+            stack.pop_back();
+            for (NodeId next : m_nodes[id]->successors) {
+                if (next == target) return true;
+                if (!seen[next]) {
+                    seen[next] = true;
+                    stack.push_back(next);
+                }
+            }
+        }
+        return false;
+    }
+
+    void schedule(NodeId id) {
+        AsyncScheduler::getInstance().post([this, id] { execute(id); }, m_nodes[id]->priority);
+    }
+
+    void execute(NodeId id) {
+        Node& node = *m_nodes[id];
+        bool failed = node.skipped.load(std::memory_order_acquire);
+        if (!failed) {
+            try {
+                node.fn();
+            } catch (...) {
+                failed = true;
+                std::lock_guard<std::mutex> lock(m_error_mutex);
+                if (!m_error) m_error = std::current_exception();
+            }
+        }
+
+        for (NodeId next : node.successors) {
+            Node& successor = *m_nodes[next];
+            if (failed) successor.skipped.store(true, std::memory_order_release);
+            if (successor.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) schedule(next);
+        }
+
+        if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Keep the state alive past set_value; continuations may drop the graph
+            auto completion = m_completion;
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(m_error_mutex);
+                error = m_error;
+            }
+            if (error) completion->set_exception(error);
+            else completion->set_value(detail::VoidResult{});
+        }
+    }
+
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::atomic<size_t> m_remaining{0};
+    std::shared_ptr<detail::TaskFutureState<void>> m_completion;
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+};
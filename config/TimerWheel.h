@@ -0,0 +1,281 @@
+// TimerWheel.h - Hierarchical timing wheel.
+// Four levels of 256 slots each, indexed by the absolute expiry tick as in
+// the classic Linux timer wheel (Varghese & Lauck, "Hashed and Hierarchical
+// Timing Wheels"). Insert and cancel are O(1); timers on the outer levels are
+// moved inward once per level as their expiry approaches.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Identifies a timer in a TimerWheel. Stale ids are detected by generation.
+struct TimerId {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool valid() const { return index != std::numeric_limits<uint32_t>::max(); }
+};
+
+// Not thread-safe; the owner serializes access.
+template<typename T>
+class TimerWheel {
+public:
+    static constexpr uint64_t NO_EXPIRY = std::numeric_limits<uint64_t>::max();
+
+    explicit TimerWheel(uint64_t start_tick = 0) : m_current(start_tick) {
+        m_heads.fill(NIL);
+        for (auto& level : m_occupied) level.fill(0);
+    }
+
+    // Next tick that has not been processed yet.
+    uint64_t current_tick() const { return m_current; }
+
+    // Timers waiting in the wheel, not counting detached ones.
+    size_t size() const { return m_linked; }
+
+    // Adds a timer for the given tick. Ticks in the past fire on the next advance.
+    TimerId add(uint64_t expires, T payload) {
+        uint32_t index;
+        if (m_free != NIL) {
+            index = m_free;
+            m_free = m_nodes[index].next;
+            m_nodes[index].payload = std::move(payload);
+        } else {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+            m_nodes.back().payload = std::move(payload);
+        }
+        Node& node = m_nodes[index];
+        node.expires = expires;
+        link(index);
+        return TimerId{index, node.generation};
+    }
+
+    // Removes a waiting timer. Returns false if it already fired or is stale.
+    bool cancel(TimerId id) {
+        Node* node = lookup(id);
+        if (!node || node->state != State::Linked) return false;
+        unlink(id.index);
+        release_node(id.index);
+        return true;
+    }
+
+    // Payload of a waiting or detached timer, nullptr once released.
+    // Invalidated by add().
+    T* find(TimerId id) {
+        Node* node = lookup(id);
+        return node ? &node->payload : nullptr;
+    }
+
+    // Fired timers are detached: they leave the wheel but keep their payload
+    // until released or re-armed.
+    bool is_detached(TimerId id) {
+        Node* node = lookup(id);
+        return node && node->state == State::Detached;
+    }
+
+    void rearm(TimerId id, uint64_t expires) {
+        Node* node = lookup(id);
+        if (!node || node->state != State::Detached) return;
+        node->expires = expires;
+        link(id.index);
+    }
+
+    void release(TimerId id) {
+        Node* node = lookup(id);
+        if (!node || node->state != State::Detached) return;
+        release_node(id.index);
+    }
+
+    // Lower bound on the next tick at which advance() has work to do:
+    // either a timer expiring or an outer slot cascading inward.
+    uint64_t next_expiry() const {
+        if (m_linked == 0) return NO_EXPIRY;
+
+        uint64_t next = NO_EXPIRY;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            unsigned shift = static_cast<unsigned>(level * SLOT_BITS);
+            // First tick, at or after current, at which this level's slot turns over
+            uint64_t start = ((m_current + (uint64_t(1) << shift) - 1) >> shift) << shift;
+            size_t start_slot = (start >> shift) & SLOT_MASK;
+            size_t distance = 0;
+            if (!next_occupied(level, start_slot, distance)) continue;
+            uint64_t tick = start + (uint64_t(distance) << shift);
+            if (tick < next) next = tick;
+        }
+        return next;
+    }
+
+    // Processes every tick up to and including now. on_expired(TimerId) is
+    // called for each due timer, after it has been detached; it may add,
+    // cancel or re-arm timers. Empty stretches of the wheel are skipped.
+    template<typename F>
+    void advance(uint64_t now, F&& on_expired) {
+        while (m_current <= now) {
+            uint64_t next = next_expiry();
+            if (next > now) {
+                m_current = now + 1;
+                return;
+            }
+            m_current = next;
+            process_tick(on_expired);
+        }
+    }
+
+private:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr size_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint64_t MAX_DELTA = (uint64_t(1) << (LEVELS * SLOT_BITS)) - 1;
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+    enum class State : uint8_t { Free, Linked, Detached };
+
+    struct Node {
+        T payload{};
+        uint64_t expires = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 0;
+        uint16_t slot = 0;
+        State state = State::Free;
+    };
+
+    Node* lookup(TimerId id) {
+        if (id.index >= m_nodes.size()) return nullptr;
+        Node& node = m_nodes[id.index];
+        if (node.generation != id.generation || node.state == State::Free) return nullptr;
+        return &node;
+    }
+
+    void link(uint32_t index) {
+        Node& node = m_nodes[index];
+        if (node.expires < m_current) node.expires = m_current;
+
+        // Timers beyond the wheel's range park in the last slot that reaches
+        // furthest and are re-filed when it cascades.
+        uint64_t delta = node.expires - m_current;
+        uint64_t filed = delta > MAX_DELTA ? m_current + MAX_DELTA : node.expires;
+        delta = filed - m_current;
+
+        size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS))) ++level;
+        size_t slot = level * SLOTS + ((filed >> (level * SLOT_BITS)) & SLOT_MASK);
+
+        node.slot = static_cast<uint16_t>(slot);
+        node.prev = NIL;
+        node.next = m_heads[slot];
+        if (node.next != NIL) m_nodes[node.next].prev = index;
+        m_heads[slot] = index;
+        m_occupied[level][(slot & SLOT_MASK) >> 6] |= uint64_t(1) << (slot & 63);
+        node.state = State::Linked;
+        ++m_linked;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = m_nodes[index];
+        if (node.prev != NIL) m_nodes[node.prev].next = node.next;
+        else m_heads[node.slot] = node.next;
+        if (node.next != NIL) m_nodes[node.next].prev = node.prev;
+        if (m_heads[node.slot] == NIL) clear_occupied(node.slot);
+        node.prev = node.next = NIL;
+        node.state = State::Detached;
+        --m_linked;
+    }
+
+    void release_node(uint32_t index) {
+        Node& node = m_nodes[index];
+        node.payload = T{};
+        node.state = State::Free;
+        ++node.generation;
+        node.next = m_free;
+        m_free = index;
+    }
+
+    // Detaches a whole slot and returns its list
+    uint32_t take_slot(size_t slot) {
+        uint32_t head = m_heads[slot];
+        m_heads[slot] = NIL;
+        clear_occupied(slot);
+        for (uint32_t i = head; i != NIL; i = m_nodes[i].next) {
+            m_nodes[i].state = State::Detached;
+            --m_linked;
+        }
+        return head;
+    }
+
+    void clear_occupied(size_t slot) {
+        m_occupied[slot / SLOTS][(slot & SLOT_MASK) >> 6] &= ~(uint64_t(1) << (slot & 63));
+    }
+
+    // Circular search for the first occupied slot at or after from.
+    bool next_occupied(size_t level, size_t from, size_t& distance) const {
+        const auto& bits = m_occupied[level];
+        for (size_t step = 0; step < SLOTS; step += 64) {
+            size_t pos = (from + step) & SLOT_MASK;
+            size_t word = pos >> 6;
+            unsigned offset = static_cast<unsigned>(pos & 63);
+            // Bits at or after pos in this word, then the low bits of the following word
+            uint64_t mask = bits[word] >> offset;
+            if (mask) {
+                distance = step + static_cast<size_t>(__builtin_ctzll(mask));
+                return true;
+            }
+            if (offset != 0) {
+                uint64_t wrap = bits[(word + 1) & 3] & ((uint64_t(1) << offset) - 1);
+                if (wrap) {
+                    distance = step + (64 - offset) + static_cast<size_t>(__builtin_ctzll(wrap));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template<typename F>
+    void process_tick(F& on_expired) {
+        uint64_t tick = m_current;
+
+        // Move the outer slots whose range starts at this tick inward
+        for (size_t level = 1; level < LEVELS; ++level) {
+            unsigned shift = static_cast<unsigned>(level * SLOT_BITS);
+            if (tick & ((uint64_t(1) << shift) - 1)) break;
+            uint32_t i = take_slot(level * SLOTS + ((tick >> shift) & SLOT_MASK));
+            while (i != NIL) {
+                uint32_t next = m_nodes[i].next;
+                link(i);
+                i = next;
+            }
+        }
+
+        // Collect first: callbacks may add (growing m_nodes) or re-arm timers
+        m_expired.clear();
+        for (uint32_t i = take_slot(tick & SLOT_MASK); i != NIL;) {
+            Node& node = m_nodes[i];
+            uint32_t next = node.next;
+            node.prev = node.next = NIL;
+            m_expired.push_back(TimerId{i, node.generation});
+            i = next;
+        }
+
+        // Anything re-armed for this tick from a callback lands in the next one
+        m_current = tick + 1;
+        for (size_t k = 0; k < m_expired.size(); ++k) {
+            on_expired(m_expired[k]);
+        }
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<TimerId> m_expired; // Scratch for process_tick
+    uint32_t m_free = NIL;
+    std::array<uint32_t, LEVELS * SLOTS> m_heads;
+    std::array<std::array<uint64_t, SLOTS / 64>, LEVELS> m_occupied;
+    uint64_t m_current;
+    size_t m_linked = 0;
+};
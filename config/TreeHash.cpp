@@ -0,0 +1,226 @@
+// TreeHash.cpp - Parallel Merkle tree mode of CryptoHash.
+
+#include "TreeHash.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+    constexpr uint8_t LEAF_PREFIX = 0x00;
+    constexpr uint8_t NODE_PREFIX = 0x01;
+    constexpr uint8_t ROOT_PREFIX = 0x02;
+
+    // Leaves per task: one full pass of the widest compute_many backend
+    constexpr size_t LEAVES_PER_TASK = 16;
+
+    std::string_view as_view(const uint8_t* data, size_t length) {
+        return std::string_view(reinterpret_cast<const char*>(data), length);
+    }
+
+    // out[i] = H(LEAF_PREFIX || H(chunks[i]))
+    void hash_leaves(std::span<const std::string_view> chunks, Digest* out) {
+        parallel_for(chunks.size(), LEAVES_PER_TASK, [&](size_t begin, size_t end) {
+            std::vector<Digest> inner = CryptoHash::compute_many(chunks.subspan(begin, end - begin));
+            std::vector<std::array<uint8_t, 1 + HASH_SIZE>> tagged(inner.size());
+            std::vector<std::string_view> views(inner.size());
+            for (size_t i = 0; i < inner.size(); ++i) {
+                tagged[i][0] = LEAF_PREFIX;
+                memcpy(tagged[i].data() + 1, inner[i].data(), HASH_SIZE);
+                views[i] = as_view(tagged[i].data(), tagged[i].size());
+            }
+            std::vector<Digest> leaves = CryptoHash::compute_many(views);
+            std::copy(leaves.begin(), leaves.end(), out + begin);
+        });
+    }
+
+    // Recomputes the listed parents (sorted) from their children in level
+    void hash_parents(const std::vector<Digest>& level, std::vector<Digest>& parents,
+                      const std::vector<size_t>& indices) {
+        std::vector<std::array<uint8_t, 1 + 2 * HASH_SIZE>> inputs;
+        std::vector<size_t> targets;
+        inputs.reserve(indices.size());
+        targets.reserve(indices.size());
+        for (size_t p : indices) {
+            size_t left = 2 * p;
+            if (left + 1 >= level.size()) {
+                parents[p] = level[left];
+                continue;
+            }
+            auto& input = inputs.emplace_back();
+            input[0] = NODE_PREFIX;
+            memcpy(input.data() + 1, level[left].data(), HASH_SIZE);
+            memcpy(input.data() + 1 + HASH_SIZE, level[left + 1].data(), HASH_SIZE);
+            targets.push_back(p);
+        }
+
+        std::vector<std::string_view> views(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) views[i] = as_view(inputs[i].data(), inputs[i].size());
+        std::vector<Digest> digests = CryptoHash::compute_many(views);
+        for (size_t i = 0; i < targets.size(); ++i) parents[targets[i]] = digests[i];
+    }
+
+    void append_be64(uint8_t* out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (56 - i * 8));
+    }
+
+} // namespace
+
+TreeHash::TreeHash(size_t chunk_size) : m_chunk_size(chunk_size) {
+    if (chunk_size == 0) {
+        throw std::runtime_error("TreeHash chunk size must be non-zero");
+    }
+    reset();
+}
+
+void TreeHash::reset() {
+    m_total_length = 0;
+    m_levels.assign(1, {});
+    m_full_leaves = 0;
+    m_pending.clear();
+    m_dirty.clear();
+    m_dirty_from = 0;
+}
+
+void TreeHash::update(const uint8_t* data, size_t length) {
+    if (!data) return;
+    m_total_length += length;
+
+    size_t batch = m_chunk_size * PENDING_CHUNKS;
+    while (length > 0) {
+        // Whole chunks straight from the caller's buffer
+        if (m_pending.empty() && length >= m_chunk_size) {
+            size_t count = length / m_chunk_size;
+            append_leaves(data, count);
+            data += count * m_chunk_size;
+            length -= count * m_chunk_size;
+            continue;
+        }
+
+        size_t take = std::min(length, batch - m_pending.size());
+        m_pending.insert(m_pending.end(), data, data + take);
+        data += take;
+        length -= take;
+        if (m_pending.size() == batch) {
+            append_leaves(m_pending.data(), PENDING_CHUNKS);
+            m_pending.clear();
+        }
+    }
+}
+
+void TreeHash::update(std::string_view str) {
+    update(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+void TreeHash::append_leaves(const uint8_t* data, size_t count) {
+    std::vector<std::string_view> chunks(count);
+    for (size_t i = 0; i < count; ++i) chunks[i] = as_view(data + i * m_chunk_size, m_chunk_size);
+
+    // Drop the tail leaf of an earlier digest; a new one is made when needed
+    std::vector<Digest>& leaves = m_levels[0];
+    leaves.resize(m_full_leaves + count);
+    hash_leaves(chunks, leaves.data() + m_full_leaves);
+
+    m_dirty_from = std::min(m_dirty_from, m_full_leaves);
+    m_full_leaves += count;
+}
+
+void TreeHash::flush_pending() {
+    size_t count = m_pending.size() / m_chunk_size;
+    if (count == 0) return;
+    append_leaves(m_pending.data(), count);
+    m_pending.erase(m_pending.begin(), m_pending.begin() + count * m_chunk_size);
+}
+
+void TreeHash::rehash_chunks(const uint8_t* data, size_t length, std::span<const size_t> chunks) {
+    if (length != m_total_length) {
+        throw std::runtime_error("TreeHash::rehash_chunks: input length changed");
+    }
+    flush_pending();
+
+    std::vector<std::string_view> views;
+    std::vector<size_t> indices;
+    for (size_t index : chunks) {
+        if (index < m_full_leaves) {
+            views.push_back(as_view(data + index * m_chunk_size, m_chunk_size));
+            indices.push_back(index);
+        } else if (index == m_full_leaves && !m_pending.empty()) {
+            // The tail leaf is rebuilt from m_pending on every digest
+            memcpy(m_pending.data(), data + index * m_chunk_size, m_pending.size());
+        } else {
+            throw std::runtime_error("TreeHash::rehash_chunks: chunk index out of range");
+        }
+    }
+
+    std::vector<Digest> leaves(views.size());
+    hash_leaves(views, leaves.data());
+    for (size_t i = 0; i < indices.size(); ++i) m_levels[0][indices[i]] = leaves[i];
+    m_dirty.insert(m_dirty.end(), indices.begin(), indices.end());
+}
+
+void TreeHash::rebuild_levels() {
+    flush_pending();
+
+    std::vector<Digest>& leaves = m_levels[0];
+    leaves.resize(m_full_leaves);
+    if (!m_pending.empty() || m_full_leaves == 0) {
+        std::string_view tail = as_view(m_pending.data(), m_pending.size());
+        hash_leaves(std::span(&tail, 1), &leaves.emplace_back());
+    }
+
+    size_t from = std::min(m_dirty_from, m_full_leaves);
+    std::vector<size_t> dirty;
+    std::sort(m_dirty.begin(), m_dirty.end());
+    for (size_t index : m_dirty) {
+        if (index < from && (dirty.empty() || dirty.back() != index)) dirty.push_back(index);
+    }
+
+    size_t level = 0;
+    for (; m_levels[level].size() > 1; ++level) {
+        if (m_levels.size() == level + 1) m_levels.emplace_back();
+        const std::vector<Digest>& nodes = m_levels[level];
+        std::vector<Digest>& parents = m_levels[level + 1];
+        size_t count = (nodes.size() + 1) / 2;
+        parents.resize(count);
+
+        from /= 2;
+        std::vector<size_t> changed;
+        for (size_t index : dirty) {
+            size_t parent = index / 2;
+            if (parent < from && (changed.empty() || changed.back() != parent)) changed.push_back(parent);
+        }
+        std::vector<size_t> work = changed;
+        for (size_t parent = from; parent < count; ++parent) work.push_back(parent);
+        hash_parents(nodes, parents, work);
+        dirty = std::move(changed);
+    }
+    m_levels.resize(level + 1);
+
+    m_dirty.clear();
+    m_dirty_from = m_full_leaves;
+}
+
+Digest TreeHash::digest() {
+    rebuild_levels();
+
+    uint8_t root[1 + HASH_SIZE + 16];
+    root[0] = ROOT_PREFIX;
+    memcpy(root + 1, m_levels.back()[0].data(), HASH_SIZE);
+    append_be64(root + 1 + HASH_SIZE, m_total_length);
+    append_be64(root + 1 + HASH_SIZE + 8, m_chunk_size);
+
+    CryptoHash hasher;
+    hasher.update(root, sizeof(root));
+    return hasher.finalize();
+}
+
+Digest TreeHash::compute(const uint8_t* data, size_t length, size_t chunk_size) {
+    TreeHash tree(chunk_size);
+    tree.update(data, length);
+    return tree.digest();
+}
+
+Digest TreeHash::compute(std::string_view data, size_t chunk_size) {
+    return compute(reinterpret_cast<const uint8_t*>(data.data()), data.size(), chunk_size);
+}
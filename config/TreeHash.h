@@ -0,0 +1,77 @@
+// TreeHash.h - Parallel Merkle tree mode of CryptoHash for large buffers.
+// Input is split into fixed-size chunks. The chunks are hashed as leaves,
+// spread over the AsyncScheduler workers with the multi-buffer
+// CryptoHash::compute_many. The leaves are then combined pairwise up to a
+// root. The last node of an odd-sized level moves up unchanged.
+//
+// The inputs of the three kinds of hash are prefixed with a different byte:
+// leaves H(0x00 || H(chunk)), inner nodes H(0x01 || left || right), and the
+// root H(0x02 || top || length || chunk size). A tree digest therefore never
+// collides with a node inside another tree, or with a tree of another chunk
+// size. It is a separate digest from CryptoHash::compute of the same bytes.
+//
+// The whole tree is kept, so after some chunks of a buffer change only those
+// leaves and their paths to the root are hashed again.
+//
+// Leaves are hashed with parallel_for; a TreeHash may be used from inside a
+// scheduler task.
+
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <vector>
+#include "CryptoHash.h"
+
+class TreeHash {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit TreeHash(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    // Streaming input. Chunks are hashed in parallel batches as they fill up,
+    // so feeding large spans at once gives the most parallelism.
+    void update(const uint8_t* data, size_t length);
+    void update(std::string_view str);
+
+    // Re-reads the listed chunks of data, the complete current input, after
+    // they were modified in place. The length must not change.
+    void rehash_chunks(const uint8_t* data, size_t length, std::span<const size_t> chunks);
+
+    // Root digest of everything seen so far. Only the nodes changed since the
+    // last call are hashed again; the tree keeps accepting input.
+    Digest digest();
+
+    void reset();
+
+    size_t chunk_size() const { return m_chunk_size; }
+    uint64_t length() const { return m_total_length; }
+
+    // One-shot tree hash of a buffer.
+    static Digest compute(const uint8_t* data, size_t length, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    static Digest compute(std::string_view data, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+private:
+    // Full chunks buffered before a streamed batch is hashed
+    static constexpr size_t PENDING_CHUNKS = 16;
+
+    void append_leaves(const uint8_t* data, size_t count);
+    void flush_pending();
+    void rebuild_levels();
+
+    size_t m_chunk_size;
+    uint64_t m_total_length = 0;
+
+    // m_levels[0] holds the leaves: the full chunks, then the tail leaf if
+    // the input does not end on a chunk boundary
+    std::vector<std::vector<Digest>> m_levels;
+    size_t m_full_leaves = 0;
+
+    // Streamed bytes not hashed yet; always starts on a chunk boundary
+    std::vector<uint8_t> m_pending;
+
+    // Leaves changed since the last digest: the listed ones, and everything
+    // from m_dirty_from on
+    std::vector<size_t> m_dirty;
+    size_t m_dirty_from = 0;
+};
@@ -4,13 +4,16 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <future>
 
 #include "CoreUtils.h"
 #include "AsyncScheduler.h"
 #include "MemoryManager.h"
 #include "ConfigParser.h"
 #include "EventDispatcher.h"
+#include "ObjectPool.h"
 #include "QuantumFluctuator.h"
+#include "TaskGraph.h"
 
 // Global state handle, for interfacing with legacy modules
 static void* g_legacySystemHandle = nullptr;
@@ -19,10 +22,43 @@ void initialize_subsystems(const AppConfig& config) {
     std::cout << "Initializing core subsystems..." << std::endl;
 
     // Initialize the custom memory manager with a pre-allocated pool
-    MemoryManager::getInstance().initialize(config.memory_pool_size_mb * 1024 * 1024);
+    MemoryPoolOptions pool_options;
+    if (config.memory_huge_pages == "transparent") pool_options.huge_pages = HugePageMode::Transparent;
+    else if (config.memory_huge_pages == "explicit") pool_options.huge_pages = HugePageMode::Explicit;
+    else if (config.memory_huge_pages != "none") {
+        std::cerr << "Warning: Unknown memory_huge_pages \"" << config.memory_huge_pages
+                  << "\", using none." << std::endl;
+    }
+    pool_options.prefault = config.memory_prefault;
+    pool_options.numa_aware = config.memory_numa_aware;
+    MemoryManager::getInstance().initialize(config.memory_pool_size_mb * 1024 * 1024, pool_options);
+    if (!config.memory_stats_path.empty()) {
+        MemoryManager::getInstance().start_stats_dump(config.memory_stats_path,
+            std::chrono::milliseconds(config.memory_stats_interval_ms));
+    }
     
     // Set up the event dispatcher with a specified thread count
-    EventDispatcher::getInstance().start(config.worker_threads);
+    EventQueueOptions queue_options;
+    queue_options.capacity = config.event_queue_capacity;
+    queue_options.batch_size = config.event_batch_size;
+    queue_options.latency_sample_rate = config.latency_sample_rate;
+    if (config.event_queue_policy == "drop_oldest") queue_options.policy = BackpressurePolicy::DropOldest;
+    else if (config.event_queue_policy == "reject") queue_options.policy = BackpressurePolicy::Reject;
+    else if (config.event_queue_policy != "block") {
+        std::cerr << "Warning: Unknown event_queue_policy \"" << config.event_queue_policy
+                  << "\", using block." << std::endl;
+    }
+    EventDispatcher::getInstance().start(config.worker_threads, queue_options);
+
+    // Queue wait and run time telemetry
+    AsyncScheduler::getInstance().set_latency_sample_rate(config.latency_sample_rate);
+    std::chrono::milliseconds latency_interval(config.latency_stats_interval_ms);
+    if (!config.event_stats_path.empty()) {
+        EventDispatcher::getInstance().start_stats_dump(config.event_stats_path, latency_interval);
+    }
+    if (!config.scheduler_stats_path.empty()) {
+        AsyncScheduler::getInstance().start_stats_dump(config.scheduler_stats_path, latency_interval);
+    }
 
     // Create a legacy handle for backward compatibility
     g_legacySystemHandle = MemoryManager::getInstance().allocate(128, "LegacyHandle");
@@ -31,32 +67,82 @@ void initialize_subsystems(const AppConfig& config) {
     std::cout << "Subsystem initialization complete." << std::endl;
 }
 
-void main_loop() {
+// Cheap health check run after every cycle
+void check_system_integrity() {
+    // The global counters only; get_stats sums every thread's shard
+    MemoryManager& memory = MemoryManager::getInstance();
+    size_t pool_size = memory.pool_size();
+    size_t used = memory.used_bytes();
+    if (pool_size && used > pool_size / 10 * 9) {
+        std::cerr << "Warning: Memory pool is over 90% full (" << used << " of "
+                  << pool_size << " bytes)." << std::endl;
+    }
+}
+
+void main_loop(const AppConfig& config) {
+    constexpr int CYCLE_COUNT = 5;
+    constexpr std::chrono::milliseconds CYCLE_PERIOD(500);
+
     auto& scheduler = AsyncScheduler::getInstance();
     auto& dispatcher = EventDispatcher::getInstance();
-    
-    // Register a high-priority system integrity check
-    auto integrity_task = []() {
-        // In a real system, this would check for memory corruption or deadlocks
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    };
-    scheduler.submit(integrity_task, TaskPriority::CRITICAL);
-
-    // Simulate main workload
-    for (int i = 0; i < 5; ++i) {
-        std::cout << "Processing cycle " << i + 1 << "..." << std::endl;
-        
-        // Create and dispatch a quantum fluctuation event
-        auto q_event = std::make_shared<QuantumEvent>(i, generate_random_state_vector());
-        dispatcher.dispatch(q_event);
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    }
+    QuantumFluctuator fluctuator;
+    IntegratorOptions integrator;
+    if (config.simulation_integrator == "krylov") integrator.mode = IntegratorMode::Krylov;
+    integrator.tolerance = config.integrator_tolerance;
+    integrator.krylov_dimension = config.krylov_dimension;
+    fluctuator.set_integrator(integrator);
+    int tick = 0;
+
+    // Each cycle is a pipeline: evolve the state, publish it, then verify the
+    // system. Stages are released by their predecessors, not by blocking waits.
+    TaskGraph cycle;
+    auto evolve = cycle.add([&]() {
+        fluctuator.update(config.simulation_timestep);
+    }, TaskPriority::HIGH);
+    auto publish = cycle.add([&]() {
+        // Create and dispatch a quantum fluctuation event. It shares the
+        // tick's snapshot with every handler instead of copying the state.
+        dispatcher.dispatch(std::allocate_shared<QuantumEvent>(PoolAllocator<QuantumEvent>(), tick,
+                                                               fluctuator.get_current_state()));
+    });
+    auto integrity_check = cycle.add(check_system_integrity, TaskPriority::CRITICAL);
+    cycle.precede(evolve, publish);
+    cycle.precede(publish, integrity_check);
+
+    // Cycles are started by a periodic timer rather than a sleeping loop.
+    // Timer runs never overlap, and one that finds the previous cycle still
+    // in flight skips its turn.
+    TaskFuture<void> last_cycle = make_ready_task();
+    std::promise<void> finished;
+    int started = 0;
+    auto cadence = scheduler.submit_every(CYCLE_PERIOD, [&]() {
+        if (started > CYCLE_COUNT || !last_cycle.is_ready()) return;
+        if (started > 0) {
+            try {
+                last_cycle.get();
+            } catch (const std::exception& e) {
+                std::cerr << "Warning: Processing cycle " << started << " failed: " << e.what() << std::endl;
+            }
+        }
+        if (started == CYCLE_COUNT) {
+            ++started;
+            finished.set_value();
+            return;
+        }
+
+        tick = started++;
+        std::cout << "Processing cycle " << tick + 1 << "..." << std::endl;
+        last_cycle = cycle.run();
+    }, TaskPriority::HIGH);
+
+    finished.get_future().wait();
+    scheduler.cancel(cadence);
 }
 
 void shutdown_subsystems() {
     std::cout << "Shutting down subsystems..." << std::endl;
     
+    AsyncScheduler::getInstance().stop_stats_dump();
     EventDispatcher::getInstance().stop();
     MemoryManager::getInstance().deallocate(g_legacySystemHandle, "LegacyHandle");
     MemoryManager::getInstance().shutdown();
@@ -78,7 +164,7 @@ int main(int argc, char* argv[]) {
     
     initialize_subsystems(config);
     
-    main_loop();
+    main_loop(config);
     
     shutdown_subsystems();
     
@@ -0,0 +1,212 @@
+// AllocationTest.cpp - Steady-state dispatch, publish and submit stay off the global heap.
+// Counts every global operator new across all threads while a warmed-up
+// dispatcher, typed channel and scheduler run a fixed loop; the count must
+// not move. post is measured with a capture that fits InlineFunction's
+// inline buffer and with one that spills to an ObjectPool slot. Also checks
+// that posted tasks throwing a std::exception or anything else are
+// reported and swallowed, leaving the workers running.
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <new>
+#include <thread>
+
+#include "AsyncScheduler.h"
+#include "EventChannel.h"
+#include "EventDispatcher.h"
+#include "MemoryManager.h"
+#include "ObjectPool.h"
+
+namespace {
+
+    std::atomic<size_t> g_heap_allocations{0};
+
+    struct TestEvent : public BaseEvent {
+        explicit TestEvent(int v) : value(v) {}
+        int value;
+    };
+
+    // Stored by value in the channel's ring
+    struct TestSample {
+        int index = 0;
+        double value = 0;
+    };
+
+    constexpr int WARMUP_ROUNDS = 10000;
+    constexpr int MEASURED_ROUNDS = 100000;
+    constexpr int DISPATCH_WORKERS = 2;
+
+    void wait_for(const std::atomic<int>& counter, int expected) {
+        while (counter.load(std::memory_order_acquire) < expected) std::this_thread::yield();
+    }
+
+    void dispatch_rounds(EventDispatcher& dispatcher, std::atomic<int>& handled, int rounds) {
+        int target = handled.load() + rounds;
+        for (int i = 0; i < rounds; ++i) {
+            while (!dispatcher.dispatch(std::allocate_shared<TestEvent>(PoolAllocator<TestEvent>(), i))) {
+                std::this_thread::yield();
+            }
+        }
+        wait_for(handled, target);
+    }
+
+    template<typename ChannelPtr>
+    void publish_rounds(ChannelPtr& channel, std::atomic<int>& handled, int rounds) {
+        int target = handled.load() + rounds;
+        for (int i = 0; i < rounds; ++i) {
+            while (!channel->publish(TestSample{i, i * 0.5})) std::this_thread::yield();
+        }
+        wait_for(handled, target);
+    }
+
+    void submit_rounds(AsyncScheduler& scheduler, int rounds) {
+        for (int i = 0; i < rounds; ++i) {
+            int result = scheduler.submit([](int v) { return v + 1; }, TaskPriority::NORMAL, i).get();
+            assert(result == i + 1);
+            (void)result;
+        }
+    }
+
+    // Larger than InlineFunction's 48-byte buffer
+    struct Oversized {
+        std::array<int, 16> values;
+    };
+
+    // Posts in batches that drain before the next, so the injection queue
+    // and the slot pools stop growing once warm-up has seen one batch
+    constexpr int POST_BATCH = 1000;
+
+    void post_rounds(AsyncScheduler& scheduler, std::atomic<int>& ran, int rounds) {
+        for (int done = 0; done < rounds; done += POST_BATCH) {
+            int target = ran.load() + POST_BATCH;
+            for (int i = 0; i < POST_BATCH; ++i) {
+                scheduler.post([&ran] { ran.fetch_add(1, std::memory_order_release); });
+            }
+            wait_for(ran, target);
+        }
+    }
+
+    void post_oversized_rounds(AsyncScheduler& scheduler, std::atomic<int>& ran, int rounds) {
+        for (int done = 0; done < rounds; done += POST_BATCH) {
+            int target = ran.load() + POST_BATCH;
+            for (int i = 0; i < POST_BATCH; ++i) {
+                Oversized payload{};
+                payload.values.back() = 1;
+                static_assert(sizeof(payload) > 48);
+                scheduler.post([&ran, payload] {
+                    ran.fetch_add(payload.values.back(), std::memory_order_release);
+                });
+            }
+            wait_for(ran, target);
+        }
+    }
+
+    // One throwing task per worker and then some, so every worker likely
+    // takes one; a throw escaping a worker would terminate the process
+    void check_throwing_post(AsyncScheduler& scheduler) {
+        std::atomic<int> thrown{0};
+        int count = static_cast<int>(scheduler.worker_count()) * 4;
+        for (int i = 0; i < count; ++i) {
+            scheduler.post([&thrown, i] {
+                thrown.fetch_add(1, std::memory_order_release);
+                if (i % 2) throw std::runtime_error("posted task failure");
+                throw i;
+            });
+        }
+        wait_for(thrown, count);
+
+        std::atomic<int> ran{0};
+        post_rounds(scheduler, ran, 1000);
+        assert(scheduler.submit([] { return 7; }, TaskPriority::NORMAL).get() == 7);
+    }
+
+} // namespace
+
+// The replacements are kept out of line: GCC otherwise sees the
+// malloc and free inside and reports -Wmismatched-new-delete.
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t align) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    auto& dispatcher = EventDispatcher::getInstance();
+    auto& scheduler = AsyncScheduler::getInstance();
+    std::atomic<int> handled{0};
+    std::atomic<int> workers_seen{0};
+    dispatcher.register_handler<TestEvent>([&](std::shared_ptr<TestEvent>) {
+        static thread_local bool seen = false;
+        if (!seen) {
+            seen = true;
+            workers_seen.fetch_add(1, std::memory_order_relaxed);
+        }
+        handled.fetch_add(1, std::memory_order_release);
+    });
+    std::atomic<int> samples_handled{0};
+    auto channel = make_channel<TestSample>(1024, [&](const TestSample&) {
+        samples_handled.fetch_add(1, std::memory_order_release);
+    });
+    dispatcher.attach_channel(channel);
+    dispatcher.start(DISPATCH_WORKERS);
+
+    // Warm-up grows the slabs, queues and per-thread caches to their steady
+    // size; a worker that sat it out would set up its caches while measured
+    do {
+        dispatch_rounds(dispatcher, handled, WARMUP_ROUNDS);
+    } while (workers_seen.load(std::memory_order_relaxed) < DISPATCH_WORKERS);
+    publish_rounds(channel, samples_handled, WARMUP_ROUNDS);
+    submit_rounds(scheduler, WARMUP_ROUNDS);
+    std::atomic<int> posted{0};
+    post_rounds(scheduler, posted, WARMUP_ROUNDS);
+    post_oversized_rounds(scheduler, posted, WARMUP_ROUNDS);
+
+    size_t before = g_heap_allocations.load();
+    dispatch_rounds(dispatcher, handled, MEASURED_ROUNDS);
+    size_t after_dispatch = g_heap_allocations.load();
+    publish_rounds(channel, samples_handled, MEASURED_ROUNDS);
+    size_t after_publish = g_heap_allocations.load();
+    submit_rounds(scheduler, MEASURED_ROUNDS);
+    size_t after_submit = g_heap_allocations.load();
+    post_rounds(scheduler, posted, MEASURED_ROUNDS);
+    size_t after_post = g_heap_allocations.load();
+    post_oversized_rounds(scheduler, posted, MEASURED_ROUNDS);
+    size_t after_oversized = g_heap_allocations.load();
+
+    std::printf("dispatch: %zu heap allocations in %d rounds\n", after_dispatch - before, MEASURED_ROUNDS);
+    std::printf("publish: %zu heap allocations in %d rounds\n", after_publish - after_dispatch, MEASURED_ROUNDS);
+    std::printf("submit: %zu heap allocations in %d rounds\n", after_submit - after_publish, MEASURED_ROUNDS);
+    std::printf("post: %zu heap allocations in %d rounds\n", after_post - after_submit, MEASURED_ROUNDS);
+    std::printf("post, oversized capture: %zu heap allocations in %d rounds\n", after_oversized - after_post,
+                MEASURED_ROUNDS);
+    assert(after_dispatch == before);
+    assert(after_publish == after_dispatch);
+    assert(after_submit == after_publish);
+    assert(after_post == after_submit);
+    assert(after_oversized == after_post);
+
+    check_throwing_post(scheduler);
+
+    dispatcher.stop();
+    std::puts("AllocationTest passed");
+    return 0;
+}
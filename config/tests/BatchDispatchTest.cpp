@@ -0,0 +1,129 @@
+// BatchDispatchTest.cpp - Batch handlers see every event once, grouped by type.
+// Events of three types are dispatched one at a time and through
+// dispatch_batch, some queued before the workers start so the first passes
+// are full. Two batch handlers on one type and one on another must each
+// receive every event of their type exactly once, only that type, at most
+// batch_size at a time and in dispatch order within a batch. Per-event
+// handlers on the same types still see every event, after the batch
+// handlers have, and a type with only per-event handlers is unaffected.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <typeinfo>
+#include <vector>
+
+#include "EventDispatcher.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr int EVENTS = 30000; // Ids are shared across the types
+    constexpr size_t BATCH_SIZE = 16;
+    constexpr int QUEUED_BEFORE_START = 1000;
+
+    struct IdEvent : public BaseEvent {
+        explicit IdEvent(int i) : id(i) {}
+        int id;
+    };
+    struct EventA : public IdEvent { using IdEvent::IdEvent; };
+    struct EventB : public IdEvent { using IdEvent::IdEvent; };
+    struct EventC : public IdEvent { using IdEvent::IdEvent; };
+
+    std::vector<std::atomic<int>> g_batched(EVENTS); // Batch handler calls per event
+    std::vector<std::atomic<int>> g_single(EVENTS);  // Per-event handler calls per event
+    std::atomic<bool> g_misgrouped{false};
+    std::atomic<bool> g_out_of_order{false};
+    std::atomic<bool> g_single_first{false};
+    std::atomic<size_t> g_largest_batch{0};
+
+    template<typename T>
+    void check_batch(std::span<const std::shared_ptr<T>> events) {
+        if (events.empty() || events.size() > BATCH_SIZE) g_misgrouped = true;
+        size_t largest = g_largest_batch.load();
+        while (events.size() > largest && !g_largest_batch.compare_exchange_weak(largest, events.size())) {}
+
+        int previous = -1;
+        for (const auto& event : events) {
+            if (typeid(*event) != typeid(T)) g_misgrouped = true;
+            if (event->id <= previous) g_out_of_order = true;
+            previous = event->id;
+            g_batched[event->id].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    void count_single(const std::shared_ptr<T>& event, int batch_handlers) {
+        // Every batch handler of the type has already had this event
+        if (g_batched[event->id].load(std::memory_order_relaxed) < batch_handlers) g_single_first = true;
+        g_single[event->id].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<BaseEvent> make_event(int id) {
+        switch (id % 3) {
+        case 0: return std::make_shared<EventA>(id);
+        case 1: return std::make_shared<EventB>(id);
+        default: return std::make_shared<EventC>(id);
+        }
+    }
+
+    // Alternates single dispatches with batches of uneven size
+    void dispatch_range(EventDispatcher& dispatcher, int begin, int end) {
+        std::vector<std::shared_ptr<BaseEvent>> batch;
+        for (int id = begin; id < end;) {
+            if (id % 100 < 50) {
+                bool queued = dispatcher.dispatch(make_event(id++));
+                assert(queued);
+                (void)queued;
+                continue;
+            }
+            batch.clear();
+            for (int n = 0; n < 37 && id < end; ++n) batch.push_back(make_event(id++));
+            size_t queued = dispatcher.dispatch_batch(batch);
+            assert(queued == batch.size());
+            (void)queued;
+        }
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    auto& dispatcher = EventDispatcher::getInstance();
+    for (int h = 0; h < 2; ++h) {
+        dispatcher.register_batch_handler<EventA>([](std::span<const std::shared_ptr<EventA>> events) {
+            check_batch(events);
+        });
+    }
+    dispatcher.register_handler<EventA>([](std::shared_ptr<EventA> event) { count_single(event, 2); });
+    dispatcher.register_batch_handler<EventB>([](std::span<const std::shared_ptr<EventB>> events) {
+        check_batch(events);
+    });
+    dispatcher.register_handler<EventB>([](std::shared_ptr<EventB> event) { count_single(event, 1); });
+    dispatcher.register_handler<EventC>([](std::shared_ptr<EventC> event) { count_single(event, 0); });
+
+    // Queued while no worker runs, so the first passes take full batches
+    dispatch_range(dispatcher, 0, QUEUED_BEFORE_START);
+    EventQueueOptions options;
+    options.batch_size = BATCH_SIZE;
+    dispatcher.start(2, options);
+    dispatch_range(dispatcher, QUEUED_BEFORE_START, EVENTS);
+    dispatcher.stop();
+
+    assert(!g_misgrouped.load());
+    assert(!g_out_of_order.load());
+    assert(!g_single_first.load());
+    // Every pass takes BATCH_SIZE events of three types, so one type never gets all of them
+    assert(g_largest_batch.load() > 1 && g_largest_batch.load() < BATCH_SIZE);
+    for (int id = 0; id < EVENTS; ++id) {
+        int batch_handlers = id % 3 == 0 ? 2 : id % 3 == 1 ? 1 : 0;
+        assert(g_batched[id].load() == batch_handlers);
+        assert(g_single[id].load() == 1);
+    }
+    std::puts("BatchDispatchTest passed");
+    return 0;
+}
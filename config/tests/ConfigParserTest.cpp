@@ -0,0 +1,110 @@
+// ConfigParserTest.cpp - The [Core] keys reach AppConfig.
+// Parses a file that sets every memory, event queue and integrator key in
+// [Core], with stray whitespace and mixed-case booleans, and checks each
+// field. Keys left out keep their defaults, a missing file is invalid, and
+// keys before any section header belong to [Core]. A krylov_dimension below
+// 2 or a tolerance that is not positive makes the config invalid, since the
+// KrylovIntegrator would otherwise throw once the simulation starts.
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <variant>
+
+#include "ConfigParser.h"
+
+namespace {
+
+    std::string temp_path(const std::string& name) {
+        return "/tmp/ConfigParserTest." + std::to_string(getpid()) + "." + name;
+    }
+
+    AppConfig parse_text(const std::string& name, const std::string& text) {
+        std::string path = temp_path(name);
+        {
+            std::ofstream out(path);
+            out << text;
+        }
+        AppConfig config = ConfigParser().parse(path);
+        std::remove(path.c_str());
+        return config;
+    }
+
+    void check_core_keys() {
+        AppConfig config = parse_text("core.sys",
+            "# Memory, event queue and integrator settings\n"
+            "[Core]\n"
+            "memory_pool_size_mb = 512\n"
+            "memory_huge_pages = explicit\n"
+            "memory_prefault = TRUE\n"
+            "  memory_numa_aware=on  \n"
+            "memory_stats_path = /tmp/memory.json\n"
+            "memory_stats_interval_ms = 250\n"
+            "event_queue_capacity = 1024\n"
+            "event_queue_policy = drop_oldest\n"
+            "event_batch_size = 16\n"
+            "latency_sample_rate = 4\n"
+            "simulation_integrator = krylov\n"
+            "integrator_tolerance = 1e-8\n"
+            "krylov_dimension = 12\n"
+            "\n"
+            "[Plugins]\n"
+            "memory_huge_pages = none\n"
+            "gain = 1.5\n");
+        assert(config.is_valid);
+        assert(config.memory_pool_size_mb == 512);
+        assert(config.memory_huge_pages == "explicit");
+        assert(config.memory_prefault);
+        assert(config.memory_numa_aware);
+        assert(config.memory_stats_path == "/tmp/memory.json");
+        assert(config.memory_stats_interval_ms == 250);
+        assert(config.event_queue_capacity == 1024);
+        assert(config.event_queue_policy == "drop_oldest");
+        assert(config.event_batch_size == 16);
+        assert(config.latency_sample_rate == 4);
+        assert(config.simulation_integrator == "krylov");
+        assert(config.integrator_tolerance == 1e-8);
+        assert(config.krylov_dimension == 12);
+
+        // [Plugins] keys do not leak into [Core]
+        assert(std::get<double>(config.plugin_settings.at("gain")) == 1.5);
+        assert(config.plugin_settings.count("memory_huge_pages") == 1);
+    }
+
+    void check_defaults() {
+        AppConfig config = parse_text("defaults.sys",
+            "memory_huge_pages = transparent\n"
+            "memory_prefault = no\n");
+        assert(config.is_valid);
+        assert(config.memory_huge_pages == "transparent");
+        assert(!config.memory_prefault);
+        assert(!config.memory_numa_aware);
+        assert(config.event_queue_policy == "block");
+        assert(config.simulation_integrator == "euler");
+        assert(config.krylov_dimension == 24);
+
+        assert(!ConfigParser().parse(temp_path("missing.sys")).is_valid);
+    }
+
+    void check_integrator_limits() {
+        assert(parse_text("dimension.sys", "krylov_dimension = 2\nintegrator_tolerance = 1e-300\n").is_valid);
+        assert(!parse_text("dimension.sys", "krylov_dimension = 1\n").is_valid);
+        assert(!parse_text("dimension.sys", "krylov_dimension = 0\n").is_valid);
+        assert(!parse_text("tolerance.sys", "integrator_tolerance = 0\n").is_valid);
+        assert(!parse_text("tolerance.sys", "integrator_tolerance = -1e-6\n").is_valid);
+        assert(!parse_text("tolerance.sys", "integrator_tolerance = nan\n").is_valid);
+    }
+
+} // namespace
+
+int main() {
+    check_core_keys();
+    check_defaults();
+    check_integrator_limits();
+
+    std::puts("ConfigParserTest passed");
+    return 0;
+}
@@ -0,0 +1,132 @@
+// CoroutineBench.cpp - A coroutine switch against a thread switch.
+// Times one hand-off of control four ways: resuming a suspended coroutine
+// from a loop and letting it suspend again, co_await yield() on a
+// scheduler worker, and two threads passing a turn back and forth through
+// std::atomic::wait/notify_one and through a condition_variable. The
+// coroutine figures include the resume and the suspend; the thread figures
+// are per hand-off, so one round trip counts twice. On a single core the
+// thread hand-offs are context switches. Best of several rounds.
+//
+// Usage: CoroutineBench [switches]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "AsyncScheduler.h"
+#include "Coroutine.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr int ROUNDS = 3;
+
+    // A coroutine that suspends after every step until it is destroyed
+    struct Stepper {
+        struct promise_type {
+            Stepper get_return_object() { return Stepper{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    Stepper count_steps(long& steps) {
+        for (;;) {
+            ++steps;
+            co_await std::suspend_always{};
+        }
+    }
+
+    Task<void> yield_loop(long switches) {
+        AsyncScheduler& scheduler = AsyncScheduler::getInstance();
+        co_await scheduler.schedule();
+        for (long i = 0; i < switches; ++i) co_await scheduler.yield();
+    }
+
+    template<typename Run>
+    double best_ns(long switches, Run&& run) {
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best / switches * 1e9;
+    }
+
+    // turn is 0 when the main thread may go, 1 for the partner
+    void atomic_ping_pong(long switches) {
+        std::atomic<int> turn{0};
+        std::thread partner([&] {
+            for (long i = 0; i < switches / 2; ++i) {
+                turn.wait(0, std::memory_order_acquire);
+                turn.store(0, std::memory_order_release);
+                turn.notify_one();
+            }
+        });
+        for (long i = 0; i < switches / 2; ++i) {
+            turn.store(1, std::memory_order_release);
+            turn.notify_one();
+            turn.wait(1, std::memory_order_acquire);
+        }
+        partner.join();
+    }
+
+    void condition_ping_pong(long switches) {
+        std::mutex mutex;
+        std::condition_variable changed;
+        int turn = 0;
+        std::thread partner([&] {
+            for (long i = 0; i < switches / 2; ++i) {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return turn == 1; });
+                turn = 0;
+                changed.notify_one();
+            }
+        });
+        for (long i = 0; i < switches / 2; ++i) {
+            std::unique_lock<std::mutex> lock(mutex);
+            turn = 1;
+            changed.notify_one();
+            changed.wait(lock, [&] { return turn == 0; });
+        }
+        partner.join();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long switches = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200000;
+
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+    std::printf("hardware concurrency %u, %ld switches, best of %d rounds\n", std::thread::hardware_concurrency(),
+                switches, ROUNDS);
+
+    long steps = 0;
+    Stepper stepper = count_steps(steps);
+    double resume = best_ns(switches, [&] {
+        for (long i = 0; i < switches; ++i) stepper.handle.resume();
+    });
+    stepper.handle.destroy();
+    std::printf("%-28s %10.1f ns\n", "coroutine resume + suspend", resume);
+
+    double yield = best_ns(switches, [&] { spawn_task(yield_loop(switches)).get(); });
+    std::printf("%-28s %10.1f ns\n", "scheduler yield", yield);
+
+    double atomic_wait = best_ns(switches, [&] { atomic_ping_pong(switches); });
+    std::printf("%-28s %10.1f ns\n", "thread atomic::wait", atomic_wait);
+
+    double condition = best_ns(switches, [&] { condition_ping_pong(switches); });
+    std::printf("%-28s %10.1f ns\n", "thread condition_variable", condition);
+    return 0;
+}
@@ -0,0 +1,232 @@
+// CoroutineTest.cpp - Task<T> chains, errors and frame lifetimes.
+// A chain of awaits far deeper than a worker's stack could hold without
+// symmetric transfer must complete. Exceptions travel up through co_await,
+// can be caught on the way, and otherwise reach the spawn_task future.
+// Every coroutine frame, finished, failed or never started, must be back
+// in the pool afterwards; the frames are counted by their allocation tag.
+// co_await yield() must let other queued work run before the coroutine
+// continues, and co_await next_event<T>() must resume only on a T, after
+// its handlers, or with nullptr once the dispatcher stops.
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "AsyncScheduler.h"
+#include "Coroutine.h"
+#include "EventDispatcher.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    // At a few hundred bytes of stack per nested resume this would need
+    // far more than the 8 MiB a worker thread gets
+    constexpr int CHAIN_DEPTH = 200000;
+
+    int64_t live_frames() {
+        for (const MemoryTagStats& tag : MemoryManager::getInstance().get_stats().tags) {
+            if (tag.tag == "CoroutineFrame") return tag.live_blocks;
+        }
+        return 0;
+    }
+
+    // spawn_task's own frame finishes just after it completes the future
+    void wait_for_frames_released() {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (live_frames() != 0) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::yield();
+        }
+    }
+
+    Task<int> nested(int depth) {
+        if (depth == 0) co_return 0;
+        co_return 1 + co_await nested(depth - 1);
+    }
+
+    Task<int> fail_at(int depth) {
+        if (depth == 0) throw std::runtime_error("innermost");
+        co_return co_await fail_at(depth - 1);
+    }
+
+    Task<std::string> catch_inner() {
+        try {
+            co_await fail_at(10);
+        } catch (const std::runtime_error& e) {
+            co_return std::string("caught ") + e.what();
+        }
+        co_return "not thrown";
+    }
+
+    Task<void> on_worker(std::thread::id caller, bool& moved) {
+        co_await AsyncScheduler::getInstance().schedule(TaskPriority::HIGH);
+        moved = std::this_thread::get_id() != caller;
+        co_await sleep_for(std::chrono::milliseconds(2));
+    }
+
+    // Yields until a task posted behind it has run
+    Task<int> yield_until(const std::atomic<bool>& done, int max_yields) {
+        AsyncScheduler& scheduler = AsyncScheduler::getInstance();
+        co_await scheduler.schedule();
+        int yields = 0;
+        while (!done.load() && yields < max_yields) {
+            co_await scheduler.yield();
+            ++yields;
+        }
+        co_return yields;
+    }
+
+    struct OtherEvent : public BaseEvent {};
+    struct MatchEvent : public BaseEvent {
+        explicit MatchEvent(int v) : value(v) {}
+        int value;
+    };
+
+    std::atomic<bool> g_waiting{false};
+    std::atomic<bool> g_resumed{false};
+    std::atomic<int> g_other_handled{0};
+    std::atomic<int> g_match_handled{0};
+
+    Task<int> wait_for_match() {
+        g_waiting = true;
+        std::shared_ptr<MatchEvent> event = co_await EventDispatcher::getInstance().next_event<MatchEvent>();
+        g_resumed = true;
+        // Handlers of the event ran before the waiter was resumed
+        assert(g_match_handled.load() == 1);
+        co_return event ? event->value : -1;
+    }
+
+    Task<bool> wait_past_stop() {
+        g_waiting = true;
+        std::shared_ptr<MatchEvent> event = co_await EventDispatcher::getInstance().next_event<MatchEvent>();
+        co_return event == nullptr;
+    }
+
+    void wait_until(const std::atomic<bool>& flag) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!flag.load()) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    Task<int> await_empty() {
+        Task<int> empty;
+        co_return co_await std::move(empty);
+    }
+
+    void check_deep_chain() {
+        assert(spawn_task(nested(CHAIN_DEPTH)).get() == CHAIN_DEPTH);
+        wait_for_frames_released();
+    }
+
+    void check_exceptions() {
+        bool thrown = false;
+        try {
+            spawn_task(fail_at(50)).get();
+        } catch (const std::runtime_error& e) {
+            thrown = std::string(e.what()) == "innermost";
+        }
+        assert(thrown);
+
+        assert(spawn_task(catch_inner()).get() == "caught innermost");
+
+        thrown = false;
+        try {
+            spawn_task(await_empty()).get();
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        wait_for_frames_released();
+    }
+
+    void check_scheduling() {
+        bool moved = false;
+        spawn_task(on_worker(std::this_thread::get_id(), moved)).get();
+        assert(moved);
+        wait_for_frames_released();
+    }
+
+    void check_yield() {
+        // The posted task lands behind the coroutine on the same lane; with a
+        // single worker it can only run while the coroutine is yielded
+        std::atomic<bool> done{false};
+        TaskFuture<int> yields = spawn_task(yield_until(done, 100000));
+        AsyncScheduler::getInstance().post([&] { done = true; });
+        assert(yields.get() < 100000);
+        wait_for_frames_released();
+    }
+
+    void check_next_event() {
+        auto& dispatcher = EventDispatcher::getInstance();
+        dispatcher.register_handler<OtherEvent>([](std::shared_ptr<OtherEvent>) { ++g_other_handled; });
+        dispatcher.register_handler<MatchEvent>([](std::shared_ptr<MatchEvent>) { ++g_match_handled; });
+        dispatcher.start(1);
+
+        TaskFuture<int> value = spawn_task(wait_for_match());
+        wait_until(g_waiting);
+        // The waiter registers right after setting the flag
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        bool queued = dispatcher.dispatch(std::make_shared<OtherEvent>());
+        assert(queued);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (g_other_handled.load() == 0) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(!g_resumed.load());
+
+        queued = dispatcher.dispatch(std::make_shared<MatchEvent>(7));
+        assert(queued);
+        (void)queued;
+        assert(value.get() == 7);
+        assert(g_resumed.load());
+
+        // Still waiting when the dispatcher stops
+        g_waiting = false;
+        TaskFuture<bool> stopped = spawn_task(wait_past_stop());
+        wait_until(g_waiting);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        dispatcher.stop();
+        assert(stopped.get());
+        wait_for_frames_released();
+    }
+
+    void check_unstarted_frames() {
+        {
+            Task<int> never_started = nested(10);
+            assert(live_frames() == 1); // Lazy: only the outer frame exists
+            Task<int> moved = std::move(never_started);
+            assert(!never_started.valid() && moved.valid());
+        }
+        assert(live_frames() == 0);
+
+        Task<int> reassigned = nested(3);
+        reassigned = nested(4);
+        assert(live_frames() == 1);
+        reassigned = Task<int>();
+        assert(live_frames() == 0);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+
+    check_unstarted_frames();
+    check_deep_chain();
+    check_exceptions();
+    check_scheduling();
+    check_yield();
+    check_next_event();
+
+    std::puts("CoroutineTest passed");
+    return 0;
+}
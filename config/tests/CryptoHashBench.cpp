@@ -0,0 +1,51 @@
+// CryptoHashBench.cpp - Single-stream CryptoHash cost in cycles per byte.
+// Hashes messages from one block up to a few megabytes with compute, so
+// short messages show the padding and finalize overhead and long ones the
+// block loop. Cycles are LatencyClock ticks (the TSC on x86); each size is
+// repeated until about the same number of bytes has gone through, and the
+// best of several rounds is reported.
+//
+// Usage: CryptoHashBench [megabytes_per_round]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "CryptoHash.h"
+#include "LatencyHistogram.h"
+
+namespace {
+
+    constexpr int ROUNDS = 5;
+
+    // Keeps the compiler from dropping the digests
+    volatile uint8_t g_sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t round_bytes = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+
+    double ns_per_tick = LatencyClock::ns_per_tick();
+    std::printf("%zu MiB per round, best of %d rounds\n", round_bytes >> 20, ROUNDS);
+
+    for (size_t length : {size_t(64), size_t(256), size_t(1024), size_t(16 * 1024), size_t(1024 * 1024),
+                          size_t(4 * 1024 * 1024)}) {
+        std::string message(length, '\0');
+        for (size_t i = 0; i < length; ++i) message[i] = static_cast<char>((i * 131) >> 3);
+        size_t repeats = std::max<size_t>(1, round_bytes / length);
+
+        uint64_t best = ~uint64_t(0);
+        for (int round = 0; round < ROUNDS; ++round) {
+            uint64_t start = LatencyClock::now();
+            for (size_t i = 0; i < repeats; ++i) g_sink = CryptoHash::compute(message)[0];
+            best = std::min(best, LatencyClock::now() - start);
+        }
+
+        double bytes = static_cast<double>(repeats * length);
+        std::printf("%8zu B  %6.2f cycles/byte  %8.1f MB/s\n", length, best / bytes,
+                    bytes / (best * ns_per_tick) * 1e3);
+    }
+    return 0;
+}
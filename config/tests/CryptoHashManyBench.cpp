@@ -0,0 +1,82 @@
+// CryptoHashManyBench.cpp - compute_many throughput per SIMD backend.
+// Hashes a batch of equal-length messages with each backend in turn, for a
+// few message lengths, and reports GB/s of message data. Backends wider than
+// CryptoHash::best_backend() are skipped, since compute_many would quietly
+// run a narrower one. Each figure is the best of several rounds.
+//
+// Usage: CryptoHashManyBench [megabytes_per_batch]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CryptoHash.h"
+
+namespace {
+
+    constexpr int ROUNDS = 5;
+
+    struct BackendInfo {
+        HashBackend backend;
+        const char* name;
+    };
+
+    // Narrowest first, so a backend is available if it comes no later than the best one
+    const BackendInfo BACKENDS[] = {
+        {HashBackend::Scalar, "Scalar"},
+        {HashBackend::SSE41, "SSE4.1"},
+        {HashBackend::AVX2, "AVX2"},
+        {HashBackend::AVX512, "AVX-512"},
+    };
+
+    double best_seconds(std::span<const std::string_view> messages, HashBackend backend) {
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<Digest> digests = CryptoHash::compute_many(messages, backend);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            if (digests.size() != messages.size()) std::exit(1);
+        }
+        return best;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t batch_bytes = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+
+    HashBackend best = CryptoHash::best_backend();
+    size_t available = 0;
+    while (BACKENDS[available].backend != best) ++available;
+
+    std::printf("%zu MiB per batch, best of %d rounds\n", batch_bytes >> 20, ROUNDS);
+    std::printf("%10s", "length");
+    for (const BackendInfo& info : BACKENDS) std::printf("  %9s", info.name);
+    std::printf("\n");
+
+    for (size_t length : {size_t(64), size_t(256), size_t(1024), size_t(16 * 1024)}) {
+        size_t count = std::max<size_t>(1, batch_bytes / length);
+        std::string data(count * length, '\0');
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>((i * 2654435761u) >> 13);
+        std::vector<std::string_view> messages;
+        messages.reserve(count);
+        for (size_t i = 0; i < count; ++i) messages.push_back(std::string_view(data).substr(i * length, length));
+
+        std::printf("%8zu B", length);
+        for (size_t i = 0; i < std::size(BACKENDS); ++i) {
+            if (i > available) {
+                std::printf("  %9s", "n/a");
+                continue;
+            }
+            double seconds = best_seconds(messages, BACKENDS[i].backend);
+            std::printf("  %4.2f GB/s", data.size() / seconds / 1e9);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
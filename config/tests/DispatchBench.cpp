@@ -0,0 +1,192 @@
+// DispatchBench.cpp - Dispatch throughput and latency by worker count.
+// Four producers dispatch events of eight types to 1, 2, 4 and 8 workers.
+// Every type has two handlers that each do a few hundred nanoseconds of
+// arithmetic, so the bench shows how handling scales once workers no
+// longer share a lock on the handler table. Reports million events per
+// second and, from get_stats, the worst queue-wait and handler-time
+// percentiles among the types. Histograms are never reset, so each worker
+// count gets event types of its own.
+//
+// Then one producer sends QuantumEvents, each holding a shared snapshot,
+// to one worker twice: through dispatch, with both handlers registered for
+// the type, and through a Channel<QuantumEvent> with the same two handlers
+// as template parameters. Reports ns per event for each path.
+//
+// Usage: DispatchBench [events]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <set>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EventChannel.h"
+#include "EventDispatcher.h"
+#include "MemoryManager.h"
+#include "ObjectPool.h"
+#include "QuantumFluctuator.h"
+
+namespace {
+
+    constexpr int TYPES = 8;
+    constexpr size_t PRODUCERS = 4;
+    constexpr int HANDLER_WORK = 64; // Multiply-adds per handler call
+
+    template<int Run, int N>
+    struct BenchEvent : public BaseEvent {
+        uint64_t value = N;
+    };
+
+    std::atomic<size_t> g_handled{0};
+    std::atomic<uint64_t> g_sink{0};
+
+    // The handler work of the bench events, for the QuantumEvent paths
+    void handle_quantum(const QuantumEvent& event, int h) {
+        uint64_t x = static_cast<uint64_t>(event.simulation_tick) + h + event.resulting_state.size();
+        for (int i = 0; i < HANDLER_WORK; ++i) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        g_sink.fetch_add(x & 1, std::memory_order_relaxed);
+        if (h == 1) g_handled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<int Run, int N>
+    void register_handlers(EventDispatcher& dispatcher) {
+        for (int h = 0; h < 2; ++h) {
+            dispatcher.register_handler<BenchEvent<Run, N>>([h](std::shared_ptr<BenchEvent<Run, N>> event) {
+                uint64_t x = event->value + h;
+                for (int i = 0; i < HANDLER_WORK; ++i) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                g_sink.fetch_add(x & 1, std::memory_order_relaxed);
+                if (h == 1) g_handled.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    }
+
+    template<int Run, int... N>
+    void register_all(EventDispatcher& dispatcher, std::integer_sequence<int, N...>) {
+        (register_handlers<Run, N>(dispatcher), ...);
+    }
+
+    template<int Run, int... N>
+    void dispatch_one(EventDispatcher& dispatcher, int type, std::integer_sequence<int, N...>) {
+        ((type == N &&
+          dispatcher.dispatch(std::allocate_shared<BenchEvent<Run, N>>(PoolAllocator<BenchEvent<Run, N>>()))) || ...);
+    }
+
+    // The slowest of this run's types sets each percentile
+    LatencySummary worst(const EventDispatcherStats& stats, const std::set<std::string>& earlier,
+                         LatencySummary EventTypeLatency::*member) {
+        LatencySummary result;
+        for (const EventTypeLatency& type : stats.types) {
+            if (earlier.count(type.type)) continue;
+            const LatencySummary& s = type.*member;
+            result.count += s.count;
+            result.p50_ns = std::max(result.p50_ns, s.p50_ns);
+            result.p99_ns = std::max(result.p99_ns, s.p99_ns);
+            result.p999_ns = std::max(result.p999_ns, s.p999_ns);
+        }
+        return result;
+    }
+
+    template<int Run>
+    void run(EventDispatcher& dispatcher, size_t workers, size_t events) {
+        std::set<std::string> earlier;
+        for (const EventTypeLatency& type : dispatcher.get_stats().types) earlier.insert(type.type);
+        register_all<Run>(dispatcher, std::make_integer_sequence<int, TYPES>());
+        dispatcher.start(workers);
+        g_handled.store(0);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < PRODUCERS; ++p) {
+            size_t share = events / PRODUCERS + (p < events % PRODUCERS ? 1 : 0);
+            producers.emplace_back([&dispatcher, share, p] {
+                for (size_t i = 0; i < share; ++i) {
+                    int type = static_cast<int>((i + p) % TYPES);
+                    dispatch_one<Run>(dispatcher, type, std::make_integer_sequence<int, TYPES>());
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        while (g_handled.load(std::memory_order_relaxed) < events) std::this_thread::yield();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        EventDispatcherStats stats = dispatcher.get_stats();
+        dispatcher.stop();
+
+        LatencySummary wait = worst(stats, earlier, &EventTypeLatency::queue_wait);
+        LatencySummary handler = worst(stats, earlier, &EventTypeLatency::handler_time);
+        std::printf("%zu workers  %7.2f M events/s  queue wait p50/p99/p999 %llu/%llu/%llu ns  "
+                    "handler p50/p99 %llu/%llu ns\n",
+                    workers, events / seconds / 1e6, (unsigned long long)wait.p50_ns, (unsigned long long)wait.p99_ns,
+                    (unsigned long long)wait.p999_ns, (unsigned long long)handler.p50_ns,
+                    (unsigned long long)handler.p99_ns);
+    }
+
+    template<typename Publish>
+    double ns_per_event(size_t events, Publish&& publish) {
+        g_handled.store(0);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < events; ++i) {
+            while (!publish(static_cast<int>(i))) std::this_thread::yield();
+        }
+        while (g_handled.load(std::memory_order_relaxed) < events) std::this_thread::yield();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / events * 1e9;
+    }
+
+    void run_quantum_paths(EventDispatcher& dispatcher, size_t events) {
+        SnapshotPublisher publisher;
+        StateSnapshot snapshot = publisher.publish(64, 0.0, 0, [](std::span<std::complex<double>> amplitudes) {
+            std::fill(amplitudes.begin(), amplitudes.end(), std::complex<double>(0.125, 0.0));
+        });
+
+        for (int h = 0; h < 2; ++h) {
+            dispatcher.register_handler<QuantumEvent>([h](std::shared_ptr<QuantumEvent> event) {
+                handle_quantum(*event, h);
+            });
+        }
+        dispatcher.start(1);
+        double dynamic = ns_per_event(events, [&](int tick) {
+            return dispatcher.dispatch(
+                std::allocate_shared<QuantumEvent>(PoolAllocator<QuantumEvent>(), tick, snapshot));
+        });
+        dispatcher.stop();
+
+        auto channel = make_channel<QuantumEvent>(4096,
+            [](const QuantumEvent& event) { handle_quantum(event, 0); },
+            [](const QuantumEvent& event) { handle_quantum(event, 1); });
+        dispatcher.attach_channel(channel);
+        dispatcher.start(1);
+        double typed = ns_per_event(events, [&](int tick) { return channel->publish(QuantumEvent(tick, snapshot)); });
+        dispatcher.stop();
+        dispatcher.detach_channel(*channel);
+
+        std::printf("QuantumEvent, 1 producer, 1 worker: dispatch %.1f ns/event, Channel::publish %.1f ns/event\n",
+                    dynamic, typed);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    LatencyClock::calibrate();
+    std::printf("hardware concurrency %u, %zu events of %d types\n", std::thread::hardware_concurrency(), events,
+                TYPES);
+
+    auto& dispatcher = EventDispatcher::getInstance();
+    run<0>(dispatcher, 1, events);
+    run<1>(dispatcher, 2, events);
+    run<2>(dispatcher, 4, events);
+    run<3>(dispatcher, 8, events);
+    run_quantum_paths(dispatcher, events);
+    return 0;
+}
@@ -0,0 +1,106 @@
+// EventQueueBench.cpp - Event queue throughput by producer count.
+// With 1, 4 and 16 producers: first the bare MPMCQueue, drained by as
+// many consumer threads as there are cores, then EventDispatcher::dispatch
+// into the same ring under BackpressurePolicy::Block, drained by as many
+// workers, with one handler that only counts. Reports million events per
+// second from the first push to the last pop or handler call.
+//
+// Usage: EventQueueBench [events]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "EventDispatcher.h"
+#include "MPMCQueue.h"
+#include "MemoryManager.h"
+#include "ObjectPool.h"
+
+namespace {
+
+    constexpr size_t CAPACITY = 4096;
+
+    struct BenchEvent : public BaseEvent {};
+
+    std::atomic<size_t> g_handled{0};
+
+    // Runs produce(share) on each producer thread and waits until done() is true
+    template<typename Produce, typename Done>
+    void measure(const char* name, size_t producers, size_t events, Produce&& produce, Done&& done) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            size_t share = events / producers + (p < events % producers ? 1 : 0);
+            threads.emplace_back([&produce, share] { produce(share); });
+        }
+        for (auto& thread : threads) thread.join();
+        while (!done()) std::this_thread::yield();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-10s %2zu producers  %6.2f s  %7.2f M events/s\n", name, producers, seconds,
+                    events / seconds / 1e6);
+    }
+
+    void bench_ring(size_t producers, size_t consumers, size_t events) {
+        MPMCQueue<size_t> queue(CAPACITY);
+        std::atomic<size_t> popped{0};
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> drainers;
+        for (size_t c = 0; c < consumers; ++c) {
+            drainers.emplace_back([&] {
+                size_t item;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (queue.try_pop(item)) {
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        measure("ring", producers, events, [&](size_t share) {
+            for (size_t i = 0; i < share; ++i) {
+                while (!queue.try_push(i)) std::this_thread::yield();
+            }
+        }, [&] { return popped.load(std::memory_order_relaxed) >= events; });
+        stop = true;
+        for (auto& drainer : drainers) drainer.join();
+    }
+
+    void bench_dispatch(EventDispatcher& dispatcher, size_t producers, size_t workers, size_t events) {
+        EventQueueOptions options;
+        options.capacity = CAPACITY;
+        options.policy = BackpressurePolicy::Block;
+        dispatcher.start(workers, options);
+        g_handled.store(0);
+        measure("dispatch", producers, events, [&](size_t share) {
+            for (size_t i = 0; i < share; ++i) {
+                dispatcher.dispatch(std::allocate_shared<BenchEvent>(PoolAllocator<BenchEvent>()));
+            }
+        }, [&] { return g_handled.load(std::memory_order_relaxed) >= events; });
+        dispatcher.stop();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    size_t consumers = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("hardware concurrency %u, %zu events, capacity %zu\n", std::thread::hardware_concurrency(), events,
+                CAPACITY);
+
+    auto& dispatcher = EventDispatcher::getInstance();
+    dispatcher.register_handler<BenchEvent>([](std::shared_ptr<BenchEvent>) {
+        g_handled.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    for (size_t producers : {1, 4, 16}) bench_ring(producers, consumers, events);
+    for (size_t producers : {1, 4, 16}) bench_dispatch(dispatcher, producers, consumers, events);
+    return 0;
+}
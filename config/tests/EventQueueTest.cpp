@@ -0,0 +1,163 @@
+// EventQueueTest.cpp - Nothing queued is lost or delivered twice.
+// First the bare MPMCQueue: several producers and consumers pass numbered
+// items through a small ring, and every item must come out exactly once,
+// each producer's items in the order they went in. Then the dispatcher on a
+// small queue, with producers outrunning slowed-down workers, under each
+// backpressure policy:
+//   Block       every event is handled exactly once; producers park on a
+//               full queue and workers park between bursts (atomic::wait)
+//   DropOldest  every dispatch succeeds, no event is handled twice, and
+//               handled plus dropped adds up to dispatched
+//   Reject      accepted events are handled exactly once, refused ones
+//               never, and the refusals show up in dropped_events
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "EventDispatcher.h"
+#include "MPMCQueue.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr uint32_t PRODUCERS = 4;
+    constexpr uint32_t CONSUMERS = 3;
+    constexpr uint32_t ITEMS_PER_PRODUCER = 100000;
+    constexpr uint32_t EVENTS_PER_PRODUCER = 20000;
+    constexpr uint32_t BURST = 2000; // Producers pause after this many, so workers park
+
+    struct NumberedEvent : public BaseEvent {
+        explicit NumberedEvent(uint32_t i) : id(i) {}
+        uint32_t id;
+    };
+
+    // Indexed by event id; reset between runs while no worker is running
+    std::vector<std::atomic<uint32_t>> g_handled(PRODUCERS * EVENTS_PER_PRODUCER);
+
+    void check_ring() {
+        MPMCQueue<uint64_t> queue(16);
+        std::vector<std::atomic<uint32_t>> popped(PRODUCERS * ITEMS_PER_PRODUCER);
+        std::atomic<uint32_t> remaining{PRODUCERS * ITEMS_PER_PRODUCER};
+        std::atomic<bool> in_order{true};
+
+        std::vector<std::thread> threads;
+        for (uint32_t p = 0; p < PRODUCERS; ++p) {
+            threads.emplace_back([&, p] {
+                for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                    uint64_t item = (uint64_t(p) << 32) | i;
+                    while (!queue.try_push(item)) std::this_thread::yield();
+                }
+            });
+        }
+        for (uint32_t c = 0; c < CONSUMERS; ++c) {
+            threads.emplace_back([&] {
+                std::vector<int64_t> last(PRODUCERS, -1);
+                uint64_t item;
+                while (remaining.load(std::memory_order_relaxed) > 0) {
+                    if (!queue.try_pop(item)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    uint32_t p = static_cast<uint32_t>(item >> 32);
+                    uint32_t i = static_cast<uint32_t>(item);
+                    if (int64_t(i) <= last[p]) in_order = false;
+                    last[p] = i;
+                    popped[p * ITEMS_PER_PRODUCER + i].fetch_add(1, std::memory_order_relaxed);
+                    remaining.fetch_sub(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        assert(in_order.load());
+        for (auto& count : popped) assert(count.load() == 1);
+        assert(queue.empty_approx());
+    }
+
+    struct PolicyRun {
+        size_t dispatched = 0; // Accepted by dispatch
+        size_t handled = 0;
+        uint64_t dropped = 0;
+    };
+
+    PolicyRun run_policy(BackpressurePolicy policy) {
+        EventDispatcher& dispatcher = EventDispatcher::getInstance();
+        for (auto& count : g_handled) count.store(0, std::memory_order_relaxed);
+        uint64_t dropped_before = dispatcher.dropped_events();
+
+        EventQueueOptions options;
+        options.capacity = 64;
+        options.policy = policy;
+        options.batch_size = 8;
+        dispatcher.start(2, options);
+
+        std::vector<std::vector<uint8_t>> accepted(PRODUCERS, std::vector<uint8_t>(EVENTS_PER_PRODUCER));
+        std::vector<std::thread> producers;
+        for (uint32_t p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&, p] {
+                for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                    if (i % BURST == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    accepted[p][i] = dispatcher.dispatch(std::make_shared<NumberedEvent>(p * EVENTS_PER_PRODUCER + i));
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        dispatcher.stop(); // Drains the queue before the workers exit
+
+        PolicyRun run;
+        run.dropped = dispatcher.dropped_events() - dropped_before;
+        for (uint32_t p = 0; p < PRODUCERS; ++p) {
+            for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                uint32_t handled = g_handled[p * EVENTS_PER_PRODUCER + i].load();
+                assert(handled <= 1);
+                // A refused event must never reach a handler
+                assert(accepted[p][i] || handled == 0);
+                run.dispatched += accepted[p][i];
+                run.handled += handled;
+            }
+        }
+        return run;
+    }
+
+    void check_policies() {
+        constexpr size_t TOTAL = size_t(PRODUCERS) * EVENTS_PER_PRODUCER;
+        EventDispatcher& dispatcher = EventDispatcher::getInstance();
+        dispatcher.register_handler<NumberedEvent>([](std::shared_ptr<NumberedEvent> event) {
+            // Slower than the producers, so the queue keeps filling up
+            if (event->id % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            g_handled[event->id].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        PolicyRun block = run_policy(BackpressurePolicy::Block);
+        std::printf("Block: %zu handled, %llu dropped\n", block.handled, (unsigned long long)block.dropped);
+        assert(block.dispatched == TOTAL && block.handled == TOTAL && block.dropped == 0);
+
+        PolicyRun drop_oldest = run_policy(BackpressurePolicy::DropOldest);
+        std::printf("DropOldest: %zu handled, %llu dropped\n", drop_oldest.handled,
+                    (unsigned long long)drop_oldest.dropped);
+        assert(drop_oldest.dispatched == TOTAL);
+        assert(drop_oldest.handled + drop_oldest.dropped == TOTAL);
+
+        PolicyRun reject = run_policy(BackpressurePolicy::Reject);
+        std::printf("Reject: %zu handled, %llu dropped\n", reject.handled, (unsigned long long)reject.dropped);
+        assert(reject.handled == reject.dispatched);
+        assert(reject.dispatched + reject.dropped == TOTAL);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_ring();
+    check_policies();
+
+    std::puts("EventQueueTest passed");
+    return 0;
+}
@@ -0,0 +1,134 @@
+// FileHashBench.cpp - compute_file against reading the file into a string.
+// Writes temporary files from 1 MB up to the given size, ten times larger
+// each step, and hashes each one three ways: CryptoHash::compute_file on
+// the file itself, which maps it; compute_file on a FIFO fed from the file
+// by a writer thread, which takes the streamed path; and std::ifstream into
+// a std::string followed by CryptoHash::compute. The files were just
+// written, so all three mostly read from the page cache. Small files take
+// the best of several rounds, large ones a single round. Sizes that do not
+// fit the free space of the directory are skipped, and the string path is
+// skipped where the file would not fit in half of physical memory.
+//
+// Usage: FileHashBench [max_megabytes] [directory]
+
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CryptoHash.h"
+
+namespace {
+
+    constexpr size_t MEGABYTE = 1000 * 1000;
+    constexpr size_t WRITE_BLOCK = 4 * 1024 * 1024;
+
+    // Keeps the compiler from dropping the digests
+    volatile uint8_t g_sink;
+
+    template<typename Run>
+    double best_seconds(int rounds, Run&& run) {
+        double best = 1e30;
+        for (int round = 0; round < rounds; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    bool write_file(const std::string& path, size_t size) {
+        std::vector<char> block(WRITE_BLOCK);
+        for (size_t i = 0; i < block.size(); ++i) block[i] = static_cast<char>((i * 2654435761u) >> 11);
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        bool ok = true;
+        for (size_t written = 0; ok && written < size; written += block.size()) {
+            size_t take = std::min(block.size(), size - written);
+            ok = std::fwrite(block.data(), 1, take, file) == take;
+        }
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // The file's bytes pushed through a FIFO, so compute_file cannot map them
+    Digest hash_through_fifo(const std::string& path, const std::string& fifo) {
+        std::thread writer([&] {
+            std::ifstream in(path, std::ios::binary);
+            std::ofstream out(fifo, std::ios::binary);
+            std::vector<char> block(1024 * 1024);
+            while (in.read(block.data(), block.size()) || in.gcount() > 0) out.write(block.data(), in.gcount());
+        });
+        Digest digest = CryptoHash::compute_file(fifo);
+        writer.join();
+        return digest;
+    }
+
+    Digest hash_via_string(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return CryptoHash::compute(contents);
+    }
+
+    double throughput(size_t size, double seconds) { return size / seconds / 1e6; }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_size = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000) * MEGABYTE;
+    std::string directory = argc > 2 ? argv[2] : (std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp");
+    std::string path = directory + "/FileHashBench." + std::to_string(getpid());
+    std::string fifo = path + ".fifo";
+    size_t memory = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+
+    if (mkfifo(fifo.c_str(), 0600) != 0) {
+        std::perror("mkfifo");
+        return 1;
+    }
+    std::printf("MB/s in %s\n", directory.c_str());
+    std::printf("%10s %12s %12s %12s\n", "size", "mapped", "fifo", "string");
+
+    for (size_t size = MEGABYTE; size <= max_size; size *= 10) {
+        struct statvfs space;
+        if (statvfs(directory.c_str(), &space) != 0 || size > space.f_bavail * space.f_frsize) {
+            std::printf("%8zu MB  skipped, not enough free space\n", size / MEGABYTE);
+            continue;
+        }
+        if (!write_file(path, size)) {
+            std::printf("%8zu MB  skipped, cannot write %s\n", size / MEGABYTE, path.c_str());
+            std::remove(path.c_str());
+            continue;
+        }
+
+        int rounds = size <= 100 * MEGABYTE ? 3 : 1;
+        Digest expected = CryptoHash::compute_file(path);
+        double mapped = best_seconds(rounds, [&] { g_sink = CryptoHash::compute_file(path)[0]; });
+        double streamed = best_seconds(rounds, [&] {
+            Digest digest = hash_through_fifo(path, fifo);
+            if (digest != expected) std::puts("FIFO digest differs");
+            g_sink = digest[0];
+        });
+        std::printf("%8zu MB %12.1f %12.1f", size / MEGABYTE, throughput(size, mapped), throughput(size, streamed));
+        if (size <= memory / 2) {
+            double via_string = best_seconds(rounds, [&] {
+                Digest digest = hash_via_string(path);
+                if (digest != expected) std::puts("string digest differs");
+                g_sink = digest[0];
+            });
+            std::printf(" %12.1f\n", throughput(size, via_string));
+        } else {
+            std::printf(" %12s\n", "skipped");
+        }
+        std::remove(path.c_str());
+    }
+    std::remove(fifo.c_str());
+    return 0;
+}
@@ -0,0 +1,139 @@
+// HandlerTableTest.cpp - Handler tables stay alive while workers read them.
+// Producers dispatch events of sixteen types while another thread keeps
+// publishing new tables: it registers handlers, which adds types until the
+// table grows and rehashes, and attaches and detaches channels, the one
+// thing a table can lose. Some handlers sleep while they run, so a worker
+// is still inside a table long after a newer one has been published.
+// Every handler carries a canary that its table's destructor poisons; a
+// handler that finds its canary dead ran from a table that had already
+// been freed. Handlers registered before start must see every event once.
+//
+// Also built under AddressSanitizer and ThreadSanitizer by "make sanitize".
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EventChannel.h"
+#include "EventDispatcher.h"
+
+namespace {
+
+    constexpr int TYPES = 16;
+    constexpr int PRODUCERS = 2;
+    constexpr int EVENTS_PER_PRODUCER = 20000;
+    constexpr int SLOW_PERIOD = 256; // One handler call in this many sleeps
+
+    // Copied into every table along with its handler
+    class Canary {
+    public:
+        static constexpr uint32_t ALIVE = 0x5afe5afe;
+        static constexpr uint32_t DEAD = 0xdeadbeef;
+
+        Canary() = default;
+        Canary(const Canary&) {}
+        ~Canary() { m_state.store(DEAD, std::memory_order_relaxed); }
+
+        bool alive() const { return m_state.load(std::memory_order_relaxed) == ALIVE; }
+
+    private:
+        std::atomic<uint32_t> m_state{ALIVE};
+    };
+
+    template<int N>
+    struct TypedEvent : public BaseEvent {};
+
+    std::atomic<int> g_dispatched[TYPES];
+    std::atomic<int> g_first_handler[TYPES];
+    std::atomic<int> g_late_handler[TYPES];
+    std::atomic<int> g_calls{0};
+    std::atomic<int> g_channel_events{0};
+    std::atomic<bool> g_dead_canary{false};
+
+    template<int N>
+    void add_handler(std::atomic<int>* counts) {
+        EventDispatcher::getInstance().register_handler<TypedEvent<N>>(
+            [canary = Canary(), counts](std::shared_ptr<TypedEvent<N>>) {
+                if (g_calls.fetch_add(1, std::memory_order_relaxed) % SLOW_PERIOD == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                if (!canary.alive()) g_dead_canary = true;
+                counts[N].fetch_add(1, std::memory_order_relaxed);
+            });
+    }
+
+    template<int... N>
+    void add_handler_for(std::integer_sequence<int, N...>, int type, std::atomic<int>* counts) {
+        ((type == N && (add_handler<N>(counts), true)) || ...);
+    }
+
+    template<int... N>
+    void dispatch_one(std::integer_sequence<int, N...>, int type) {
+        bool queued = ((type == N && EventDispatcher::getInstance().dispatch(std::make_shared<TypedEvent<N>>())) || ...);
+        assert(queued);
+        (void)queued;
+        g_dispatched[type].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Keeps publishing tables until the producers are done
+    void churn_tables(const std::atomic<bool>& done) {
+        auto& dispatcher = EventDispatcher::getInstance();
+        int rounds = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            // Adds the types one by one, past the table's first growth, then a
+            // second handler to each
+            if (rounds < 2 * TYPES) {
+                add_handler_for(std::make_integer_sequence<int, TYPES>(), rounds % TYPES, g_late_handler);
+            }
+
+            auto channel = make_channel<int>(64, [canary = Canary()](const int&) {
+                if (!canary.alive()) g_dead_canary = true;
+                g_channel_events.fetch_add(1, std::memory_order_relaxed);
+            });
+            dispatcher.attach_channel(channel);
+            for (int i = 0; i < 32; ++i) channel->publish(i);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            dispatcher.detach_channel(*channel);
+            ++rounds;
+        }
+        int late = 0;
+        for (auto& count : g_late_handler) late += count.load();
+        std::printf("%d table rounds, %d late handler calls, %d channel events\n", rounds, late,
+                    g_channel_events.load());
+    }
+
+} // namespace
+
+int main() {
+    auto& dispatcher = EventDispatcher::getInstance();
+    // The first handlers exist before any worker, so they see every event
+    add_handler<0>(g_first_handler);
+    add_handler<1>(g_first_handler);
+    dispatcher.start(2);
+
+    std::atomic<bool> done{false};
+    std::thread churner(churn_tables, std::cref(done));
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([p] {
+            for (int i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                dispatch_one(std::make_integer_sequence<int, TYPES>(), (i * 7 + p) % TYPES);
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    done = true;
+    churner.join();
+    dispatcher.stop();
+
+    assert(!g_dead_canary.load());
+    for (int type = 0; type < 2; ++type) assert(g_first_handler[type].load() == g_dispatched[type].load());
+    std::puts("HandlerTableTest passed");
+    return 0;
+}
@@ -0,0 +1,120 @@
+// KeyedDispatchTest.cpp - Events of one key are handled in dispatch order.
+// Several producers interleave keyed events over many keys, each numbering
+// its own events per key, while four workers drain and steal shards. Some
+// keys are slow to handle, so their shards back up and idle workers take
+// over others. For every key and producer the numbers must arrive strictly
+// increasing, no key may be handled on two workers at once, and every
+// event arrives exactly once. Events queued while the dispatcher is
+// stopped are re-sharded by the next start, which must keep the order too.
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "EventDispatcher.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr int KEYS = 64;
+    constexpr int PRODUCERS = 4;
+    constexpr int SLOW_KEY_PERIOD = 8; // Every eighth key sleeps in its handler
+
+    struct KeyedEvent : public BaseEvent {
+        KeyedEvent(int k, int p, int s) : key(k), producer(p), sequence(s) {}
+        int key;
+        int producer;
+        int sequence;
+    };
+
+    struct KeyState {
+        std::atomic<int> last[PRODUCERS];
+        std::atomic<bool> in_handler{false};
+    };
+
+    KeyState g_keys[KEYS];
+    std::atomic<int> g_handled{0};
+    std::atomic<bool> g_out_of_order{false};
+    std::atomic<bool> g_overlapped{false};
+
+    // Per producer, the next sequence number of each key
+    std::vector<std::vector<int>> g_next(PRODUCERS, std::vector<int>(KEYS, 0));
+
+    void handle(const std::shared_ptr<KeyedEvent>& event) {
+        KeyState& key = g_keys[event->key];
+        if (key.in_handler.exchange(true, std::memory_order_acquire)) g_overlapped = true;
+        if (event->key % SLOW_KEY_PERIOD == 0 && event->sequence % 16 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        if (key.last[event->producer].exchange(event->sequence, std::memory_order_relaxed) >= event->sequence) {
+            g_out_of_order = true;
+        }
+        key.in_handler.store(false, std::memory_order_release);
+        g_handled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Each producer walks the keys in its own random order
+    void produce(int producer, int events, uint64_t seed) {
+        auto& dispatcher = EventDispatcher::getInstance();
+        std::mt19937_64 random(seed);
+        for (int i = 0; i < events; ++i) {
+            int key = static_cast<int>(random() % KEYS);
+            int sequence = g_next[producer][key]++;
+            bool queued = dispatcher.dispatch(std::make_shared<KeyedEvent>(key, producer, sequence), key);
+            assert(queued);
+            (void)queued;
+        }
+    }
+
+    void produce_concurrently(int events_per_producer, uint64_t seed) {
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back(produce, p, events_per_producer, seed + p);
+        }
+        for (auto& producer : producers) producer.join();
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+    for (KeyState& key : g_keys) {
+        for (auto& last : key.last) last.store(-1, std::memory_order_relaxed);
+    }
+
+    auto& dispatcher = EventDispatcher::getInstance();
+    dispatcher.register_handler<KeyedEvent>(handle);
+
+    // Queued on the single-worker shards, re-sharded by start
+    produce_concurrently(500, 1);
+    dispatcher.start(4);
+    produce_concurrently(20000, 100);
+    dispatcher.stop();
+
+    // Queued on four workers' shards, re-sharded onto three
+    produce_concurrently(500, 200);
+    dispatcher.start(3);
+    produce_concurrently(10000, 300);
+    dispatcher.stop();
+
+    int dispatched = 0;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        for (int k = 0; k < KEYS; ++k) {
+            dispatched += g_next[p][k];
+            // The last event handled for the key was the last one dispatched
+            assert(g_keys[k].last[p].load() == g_next[p][k] - 1);
+        }
+    }
+    std::printf("%d keyed events handled\n", g_handled.load());
+    assert(!g_out_of_order.load());
+    assert(!g_overlapped.load());
+    assert(g_handled.load() == dispatched);
+    std::puts("KeyedDispatchTest passed");
+    return 0;
+}
@@ -0,0 +1,74 @@
+// KrylovBench.cpp - Cost of a Lanczos step against the step length.
+// Propagates a normalized state under a banded Hamiltonian (a chain with
+// nearest and next-nearest couplings, as QuantumFluctuator builds them)
+// with steps from 0.1 to 10 time units. Reports the time and mat-vecs per
+// step, the substeps the error control took, and the norm drift after
+// all steps. Best of several rounds.
+//
+// Usage: KrylovBench [max_dimension]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "KrylovIntegrator.h"
+#include "MemoryManager.h"
+#include "QuantumKernels.h"
+
+namespace {
+
+    constexpr int ROUNDS = 3;
+    constexpr int STEPS = 50;
+
+    HamiltonianMatrix chain(size_t n) {
+        std::vector<MatrixEntry> entries;
+        for (size_t r = 0; r < n; ++r) {
+            entries.push_back({r, r, std::cos(0.1 * r)});
+            for (size_t d = 1; d <= 2 && r + d < n; ++d) {
+                std::complex<double> coupling(0.5 / d, 0.1 / d);
+                entries.push_back({r, r + d, coupling});
+                entries.push_back({r + d, r, std::conj(coupling)});
+            }
+        }
+        return HamiltonianMatrix(n, entries, MatrixFormat::Banded);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_dimension = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16384;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    std::printf("%d steps, best of %d rounds\n", STEPS, ROUNDS);
+    std::printf("%8s %6s %12s %10s %9s %10s\n", "n", "dt", "us/step", "matvecs", "substeps", "norm drift");
+
+    for (size_t n = 256; n <= max_dimension; n *= 4) {
+        HamiltonianMatrix hamiltonian = chain(n);
+        for (double dt : {0.1, 1.0, 10.0}) {
+            KrylovIntegrator integrator;
+            KrylovStepStats stats;
+            double drift = 0.0;
+            double best = 1e30;
+            for (int round = 0; round < ROUNDS; ++round) {
+                ComplexVectorSoA psi(n);
+                for (size_t i = 0; i < n; ++i) psi.set(i, std::polar(1.0 / std::sqrt(double(n)), 0.3 * i));
+                stats = {};
+                auto start = std::chrono::steady_clock::now();
+                for (int step = 0; step < STEPS; ++step) {
+                    KrylovStepStats s = integrator.propagate(hamiltonian, psi, dt);
+                    stats.matvecs += s.matvecs;
+                    stats.substeps += s.substeps;
+                }
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                drift = std::abs(QuantumKernels::squared_norm(psi) - 1.0);
+            }
+            std::printf("%8zu %6.1f %12.1f %10.1f %9.1f %10.1e\n", n, dt, best / STEPS * 1e6,
+                        double(stats.matvecs) / STEPS, double(stats.substeps) / STEPS, drift);
+        }
+    }
+    return 0;
+}
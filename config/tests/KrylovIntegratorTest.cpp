@@ -0,0 +1,227 @@
+// KrylovIntegratorTest.cpp - Lanczos steps match the exact exponential.
+// exp(-i H t) psi is computed here densely, by scaling and squaring a
+// Taylor series, for small random Hermitian Hamiltonians in every storage
+// format. propagate must agree with it to well within its tolerance, both
+// when the Krylov space spans the whole state space and when it is small
+// enough that long steps are cut into substeps. The norm must be kept over
+// many steps, the reported energy must be <psi|H|psi>, an eigenvector must
+// come back with only its phase turned, and bad arguments must throw.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "KrylovIntegrator.h"
+#include "MemoryManager.h"
+#include "QuantumKernels.h"
+
+namespace {
+
+    using Complex = std::complex<double>;
+    using DenseMatrix = std::vector<Complex>; // Row-major n x n
+
+    constexpr double AGREEMENT = 1e-8; // Against the dense exponential, per unit of norm
+
+    std::mt19937_64 g_random(23);
+
+    Complex random_complex() {
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+        double re = unit(g_random);
+        return {re, unit(g_random)};
+    }
+
+    // Hermitian, with entries where keep(row, col) holds on or above the diagonal
+    template<typename Keep>
+    std::vector<MatrixEntry> random_hermitian(size_t n, Keep keep) {
+        std::vector<MatrixEntry> entries;
+        for (size_t r = 0; r < n; ++r) {
+            entries.push_back({r, r, random_complex().real() * 2.0});
+            for (size_t c = r + 1; c < n; ++c) {
+                if (!keep(r, c)) continue;
+                Complex value = random_complex();
+                entries.push_back({r, c, value});
+                entries.push_back({c, r, std::conj(value)});
+            }
+        }
+        return entries;
+    }
+
+    DenseMatrix to_dense(size_t n, const std::vector<MatrixEntry>& entries) {
+        DenseMatrix m(n * n, 0.0);
+        for (const MatrixEntry& e : entries) m[e.row * n + e.col] += e.value;
+        return m;
+    }
+
+    DenseMatrix multiply(size_t n, const DenseMatrix& a, const DenseMatrix& b) {
+        DenseMatrix c(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < n; ++k) {
+                for (size_t j = 0; j < n; ++j) c[i * n + j] += a[i * n + k] * b[k * n + j];
+            }
+        }
+        return c;
+    }
+
+    // exp(-i H t) by a Taylor series on H t / 2^s, squared s times
+    DenseMatrix exact_propagator(size_t n, const DenseMatrix& h, double t) {
+        double norm = 0.0;
+        for (const Complex& value : h) norm += std::norm(value);
+        int squarings = std::max(0, static_cast<int>(std::ceil(std::log2(std::sqrt(norm) * std::abs(t) + 1.0))) + 2);
+        Complex factor(0.0, -t / std::ldexp(1.0, squarings));
+
+        DenseMatrix result(n * n, 0.0);
+        DenseMatrix term(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) result[i * n + i] = term[i * n + i] = 1.0;
+        for (int k = 1; k <= 30; ++k) {
+            term = multiply(n, term, h);
+            for (Complex& value : term) value *= factor / static_cast<double>(k);
+            for (size_t i = 0; i < n * n; ++i) result[i] += term[i];
+        }
+        for (int s = 0; s < squarings; ++s) result = multiply(n, result, result);
+        return result;
+    }
+
+    std::vector<Complex> apply(size_t n, const DenseMatrix& m, const std::vector<Complex>& x) {
+        std::vector<Complex> y(n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) y[i] += m[i * n + j] * x[j];
+        }
+        return y;
+    }
+
+    ComplexVectorSoA to_soa(const std::vector<Complex>& x) {
+        ComplexVectorSoA v(x.size());
+        for (size_t i = 0; i < x.size(); ++i) v.set(i, x[i]);
+        return v;
+    }
+
+    double distance(const ComplexVectorSoA& a, const std::vector<Complex>& b) {
+        double sum = 0.0;
+        for (size_t i = 0; i < b.size(); ++i) sum += std::norm(a.get(i) - b[i]);
+        return std::sqrt(sum);
+    }
+
+    std::vector<Complex> random_state(size_t n) {
+        std::vector<Complex> psi(n);
+        double norm = 0.0;
+        for (Complex& value : psi) {
+            value = random_complex();
+            norm += std::norm(value);
+        }
+        for (Complex& value : psi) value /= std::sqrt(norm);
+        return psi;
+    }
+
+    void check_against_exact(size_t n, const std::vector<MatrixEntry>& entries, MatrixFormat format,
+                             size_t krylov_dimension, double dt, bool expect_substeps) {
+        HamiltonianMatrix hamiltonian(n, entries, format);
+        DenseMatrix h = to_dense(n, entries);
+        DenseMatrix propagator = exact_propagator(n, h, dt);
+
+        KrylovIntegrator integrator(krylov_dimension, 1e-10);
+        std::vector<Complex> expected = random_state(n);
+        ComplexVectorSoA psi = to_soa(expected);
+
+        // <psi|H|psi> of the starting state
+        std::vector<Complex> h_psi = apply(n, h, expected);
+        Complex energy = 0.0;
+        for (size_t i = 0; i < n; ++i) energy += std::conj(expected[i]) * h_psi[i];
+
+        for (int step = 0; step < 5; ++step) {
+            KrylovStepStats stats = integrator.propagate(hamiltonian, psi, dt);
+            expected = apply(n, propagator, expected);
+            assert(distance(psi, expected) <= AGREEMENT);
+            assert(std::abs(QuantumKernels::squared_norm(psi) - 1.0) <= AGREEMENT);
+            assert(stats.substeps >= 1 && stats.matvecs >= stats.substeps);
+            assert(stats.error_estimate <= 1e-10);
+            if (expect_substeps) assert(stats.substeps > 1);
+            // Energy is conserved, so every step starts at the same one
+            assert(std::abs(stats.energy - energy.real()) <= 1e-9);
+        }
+    }
+
+    void check_formats() {
+        // Whole space in one Krylov basis, then a basis too small for the step
+        size_t n = 12;
+        auto dense = random_hermitian(n, [](size_t, size_t) { return true; });
+        check_against_exact(n, dense, MatrixFormat::Dense, 24, 0.7, false);
+        check_against_exact(n, dense, MatrixFormat::Dense, 8, 3.0, true);
+
+        n = 40;
+        auto banded = random_hermitian(n, [](size_t r, size_t c) { return c - r <= 2; });
+        check_against_exact(n, banded, MatrixFormat::Banded, 12, 5.0, true);
+        auto scattered = random_hermitian(n, [](size_t r, size_t c) { return (r * 7 + c * 3) % 11 == 0; });
+        check_against_exact(n, scattered, MatrixFormat::CSR, 10, 2.0, true);
+    }
+
+    void check_norm_over_many_steps() {
+        size_t n = 64;
+        auto entries = random_hermitian(n, [](size_t r, size_t c) { return c - r == 1; });
+        HamiltonianMatrix hamiltonian(n, entries);
+        KrylovIntegrator integrator(16, 1e-10);
+        ComplexVectorSoA psi = to_soa(random_state(n));
+        for (int step = 0; step < 200; ++step) integrator.propagate(hamiltonian, psi, 0.5);
+        assert(std::abs(QuantumKernels::squared_norm(psi) - 1.0) <= 1e-8);
+    }
+
+    void check_eigenvector() {
+        // Diagonal H: a basis state spans an invariant subspace at once
+        size_t n = 10;
+        std::vector<MatrixEntry> entries;
+        for (size_t i = 0; i < n; ++i) entries.push_back({i, i, 0.3 * static_cast<double>(i) - 1.0});
+        HamiltonianMatrix hamiltonian(n, entries, MatrixFormat::Dense);
+        KrylovIntegrator integrator;
+        ComplexVectorSoA psi(n);
+        psi.set(4, Complex(0.6, 0.8));
+        KrylovStepStats stats = integrator.propagate(hamiltonian, psi, 2.5);
+        assert(stats.substeps == 1 && stats.matvecs == 1 && stats.error_estimate == 0.0);
+        Complex expected = Complex(0.6, 0.8) * std::polar(1.0, -(0.3 * 4 - 1.0) * 2.5);
+        assert(std::abs(psi.get(4) - expected) <= 1e-12);
+        for (size_t i = 0; i < n; ++i) {
+            if (i != 4) assert(psi.get(i) == Complex(0.0));
+        }
+    }
+
+    template<typename Call>
+    bool throws(Call&& call) {
+        try {
+            call();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    void check_errors() {
+        assert(throws([] { KrylovIntegrator integrator(1); }));
+        assert(throws([] { KrylovIntegrator integrator(8, 0.0); }));
+
+        HamiltonianMatrix hamiltonian(4, random_hermitian(4, [](size_t, size_t) { return true; }));
+        ComplexVectorSoA wrong_size(5);
+        KrylovIntegrator integrator;
+        assert(throws([&] { integrator.propagate(hamiltonian, wrong_size, 1.0); }));
+
+        // A zero state stays zero
+        ComplexVectorSoA zero(4);
+        KrylovStepStats stats = integrator.propagate(hamiltonian, zero, 1.0);
+        assert(stats.substeps == 0 && QuantumKernels::squared_norm(zero) == 0.0);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_formats();
+    check_norm_over_many_steps();
+    check_eigenvector();
+    check_errors();
+
+    std::puts("KrylovIntegratorTest passed");
+    return 0;
+}
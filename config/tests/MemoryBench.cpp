@@ -0,0 +1,146 @@
+// MemoryBench.cpp - Allocation latency and fragmentation under mixed churn.
+// Keeps a fixed number of live blocks and, each cycle, frees a random one and
+// allocates a replacement of a random size: mostly small, some medium, a few
+// large, log-uniform within each band. Reports allocate and deallocate
+// latency percentiles, failed allocations, and external fragmentation
+// (1 - largest allocatable block / free bytes) at the end of the run. Free
+// bytes are the pool size minus the requested live bytes, so block headers
+// and blocks parked in thread caches count as lost to fragmentation.
+//
+// Usage: MemoryBench [cycles] [live_blocks] [pool_mb]
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "MemoryManager.h"
+
+namespace {
+
+    struct LiveBlock {
+        void* ptr = nullptr;
+        size_t size = 0;
+    };
+
+    class SizeMix {
+    public:
+        explicit SizeMix(uint64_t seed) : m_random(seed) {}
+
+        size_t next() {
+            double band = m_unit(m_random);
+            if (band < 0.80) return log_uniform(16, 256);
+            if (band < 0.98) return log_uniform(256, 16 * 1024);
+            return log_uniform(16 * 1024, 256 * 1024);
+        }
+
+        size_t index(size_t count) { return std::uniform_int_distribution<size_t>(0, count - 1)(m_random); }
+
+    private:
+        size_t log_uniform(double low, double high) {
+            return static_cast<size_t>(std::exp(std::log(low) + m_unit(m_random) * (std::log(high) - std::log(low))));
+        }
+
+        std::mt19937_64 m_random;
+        std::uniform_real_distribution<double> m_unit{0.0, 1.0};
+    };
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint64_t percentile(std::vector<uint32_t>& samples, double fraction) {
+        if (samples.empty()) return 0;
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    // Binary search for the largest block the pool can still hand out
+    size_t largest_allocatable(MemoryManager& memory, size_t limit) {
+        std::ostringstream quiet;
+        std::streambuf* saved = std::cerr.rdbuf(quiet.rdbuf());
+        size_t low = 0, high = limit;
+        while (low < high) {
+            size_t mid = low + (high - low + 1) / 2;
+            if (void* ptr = memory.allocate(mid, "BenchProbe")) {
+                memory.deallocate(ptr, "BenchProbe");
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        std::cerr.rdbuf(saved);
+        return low;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t cycles = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    size_t live_count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16384;
+    size_t pool_size = (argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64) * 1024 * 1024;
+
+    MemoryManager& memory = MemoryManager::getInstance();
+    memory.initialize(pool_size);
+
+    SizeMix mix(42);
+    std::vector<LiveBlock> live(live_count);
+    size_t live_bytes = 0;
+    for (LiveBlock& block : live) {
+        block.size = mix.next();
+        block.ptr = memory.allocate(block.size, "Bench");
+        if (block.ptr) live_bytes += block.size;
+    }
+
+    std::vector<uint32_t> allocate_ns, deallocate_ns;
+    allocate_ns.reserve(cycles);
+    deallocate_ns.reserve(cycles);
+    size_t failures = 0;
+
+    std::ostringstream quiet;
+    std::streambuf* saved = std::cerr.rdbuf(quiet.rdbuf());
+    uint64_t run_start = now_ns();
+    for (size_t cycle = 0; cycle < cycles; ++cycle) {
+        LiveBlock& block = live[mix.index(live_count)];
+        if (block.ptr) {
+            uint64_t start = now_ns();
+            memory.deallocate(block.ptr, "Bench");
+            deallocate_ns.push_back(static_cast<uint32_t>(now_ns() - start));
+            live_bytes -= block.size;
+        }
+
+        block.size = mix.next();
+        uint64_t start = now_ns();
+        block.ptr = memory.allocate(block.size, "Bench");
+        allocate_ns.push_back(static_cast<uint32_t>(now_ns() - start));
+        if (block.ptr) live_bytes += block.size;
+        else ++failures;
+    }
+    double seconds = (now_ns() - run_start) / 1e9;
+    std::cerr.rdbuf(saved);
+
+    size_t free_bytes = pool_size - live_bytes;
+    size_t largest = largest_allocatable(memory, free_bytes);
+
+    std::printf("cycles %zu, live blocks %zu, pool %zu MiB, %.2f s\n", cycles, live_count, pool_size >> 20, seconds);
+    std::printf("allocate   p50 %" PRIu64 " ns  p99 %" PRIu64 " ns  p99.9 %" PRIu64 " ns\n",
+                percentile(allocate_ns, 0.50), percentile(allocate_ns, 0.99), percentile(allocate_ns, 0.999));
+    std::printf("deallocate p50 %" PRIu64 " ns  p99 %" PRIu64 " ns  p99.9 %" PRIu64 " ns\n",
+                percentile(deallocate_ns, 0.50), percentile(deallocate_ns, 0.99), percentile(deallocate_ns, 0.999));
+    std::printf("failed allocations %zu, live %.1f MiB, largest allocatable %.1f MiB of %.1f MiB free, "
+                "fragmentation %.1f%%\n",
+                failures, live_bytes / 1048576.0, largest / 1048576.0, free_bytes / 1048576.0,
+                free_bytes ? 100.0 * (1.0 - double(largest) / free_bytes) : 0.0);
+
+    for (LiveBlock& block : live) memory.deallocate(block.ptr, "Bench");
+    memory.shutdown();
+    return 0;
+}
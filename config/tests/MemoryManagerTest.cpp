@@ -0,0 +1,162 @@
+// MemoryManagerTest.cpp - Thread cache handoff leaves nothing behind.
+// Short-lived threads allocate small blocks from their caches and exit
+// while another thread is still freeing those blocks, so remote frees race
+// with the owner's exit. Once every thread is gone, the pool must be back
+// to no bytes in use. Also checks that the scheduler and the slot pools
+// work before the pool is initialized, and that heap blocks taken then can
+// be freed after it, and that a tag's peak is within its documented bound.
+// First initializes and shuts down the pool with every HugePageMode, with
+// and without prefault and numa_aware, allocating from each. Explicit falls
+// back to transparent huge pages where none are reserved, and numa_aware on
+// one node keeps a single arena.
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "AsyncScheduler.h"
+#include "MemoryManager.h"
+#include "ObjectPool.h"
+#include "ParallelFor.h"
+
+namespace {
+
+    constexpr int ROUNDS = 200;
+    constexpr int PRODUCERS = 4;
+    constexpr int BLOCKS_PER_PRODUCER = 256;
+
+    // Producers publish blocks here, the freer takes them as they appear
+    struct Handoff {
+        std::atomic<void*> slots[PRODUCERS * BLOCKS_PER_PRODUCER];
+    };
+
+    using PooledInts = std::vector<int, PoolAllocator<int>>;
+
+    // Submit, parallel_for and pooled arrays all go through the slot pools
+    PooledInts use_pools() {
+        auto& scheduler = AsyncScheduler::getInstance();
+        for (int i = 0; i < 100; ++i) {
+            int result = scheduler.submit([](int v) { return v * 2; }, TaskPriority::NORMAL, i).get();
+            assert(result == i * 2);
+            (void)result;
+        }
+
+        std::vector<std::atomic<int>> hits(10000);
+        parallel_for(hits.size(), 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) hits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+        for (auto& hit : hits) assert(hit.load() == 1);
+
+        PooledInts ints(1000, 7);
+        return ints;
+    }
+
+    void check_remote_frees_after_owner_exit(MemoryManager& memory) {
+        Handoff handoff;
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (auto& slot : handoff.slots) slot.store(nullptr, std::memory_order_relaxed);
+
+            std::vector<std::thread> producers;
+            for (int p = 0; p < PRODUCERS; ++p) {
+                producers.emplace_back([&, p] {
+                    for (int i = 0; i < BLOCKS_PER_PRODUCER; ++i) {
+                        void* ptr = memory.allocate(16 + (i % 15) * 16, "Handoff");
+                        handoff.slots[p * BLOCKS_PER_PRODUCER + i].store(ptr, std::memory_order_release);
+                    }
+                    // Exits with most of its blocks still waiting to be freed
+                });
+            }
+            std::thread freer([&] {
+                for (auto& slot : handoff.slots) {
+                    void* ptr;
+                    while (!(ptr = slot.load(std::memory_order_acquire))) std::this_thread::yield();
+                    memory.deallocate(ptr, "Handoff");
+                }
+            });
+            for (auto& producer : producers) producer.join();
+            freer.join();
+        }
+        size_t used = memory.get_stats().used_bytes;
+        std::printf("used after %d handoff rounds: %zu bytes\n", ROUNDS, used);
+        assert(used == 0);
+    }
+
+    // One thread, so the peak may be short by at most one publish step
+    void check_tag_peak(MemoryManager& memory) {
+        constexpr int64_t PEAK_BYTES = 1024 * 1024;
+        constexpr int64_t PUBLISH_STEP = 64 * 1024;
+        std::vector<void*> blocks;
+        for (int64_t allocated = 0; allocated < PEAK_BYTES; allocated += 512) {
+            blocks.push_back(memory.allocate(512, "PeakTag"));
+        }
+        assert(memory.used_bytes() == memory.get_stats().used_bytes);
+        for (void* ptr : blocks) memory.deallocate(ptr, "PeakTag");
+
+        for (const MemoryTagStats& tag : memory.get_stats().tags) {
+            if (tag.tag != "PeakTag") continue;
+            assert(tag.live_bytes == 0);
+            assert(tag.peak_bytes > PEAK_BYTES - PUBLISH_STEP && tag.peak_bytes <= PEAK_BYTES);
+            return;
+        }
+        assert(!"PeakTag missing from the stats");
+    }
+
+    void check_pool_options(MemoryManager& memory) {
+        constexpr size_t POOL_SIZE = 16 * 1024 * 1024;
+        const HugePageMode modes[] = {HugePageMode::None, HugePageMode::Transparent, HugePageMode::Explicit};
+        for (HugePageMode mode : modes) {
+            for (int flags = 0; flags < 4; ++flags) {
+                MemoryPoolOptions options;
+                options.huge_pages = mode;
+                options.prefault = flags & 1;
+                options.numa_aware = flags & 2;
+                memory.initialize(POOL_SIZE, options);
+                assert(memory.is_initialized());
+                assert(memory.pool_size() > 0 && memory.pool_size() <= POOL_SIZE);
+
+                std::vector<void*> blocks;
+                for (size_t size : {16, 200, 4096, 1024 * 1024}) {
+                    void* ptr = memory.allocate(size, "PoolOptions");
+                    assert(memory.owns(ptr));
+                    std::memset(ptr, 0xab, size);
+                    blocks.push_back(ptr);
+                }
+                void* large = memory.allocate(POOL_SIZE / 2, "PoolOptions");
+                assert(memory.owns(large));
+                std::memset(large, 0xcd, POOL_SIZE / 2);
+                blocks.push_back(large);
+                for (void* ptr : blocks) memory.deallocate(ptr, "PoolOptions");
+                for (const MemoryTagStats& tag : memory.get_stats().tags) {
+                    if (tag.tag == "PoolOptions") assert(tag.live_blocks == 0);
+                }
+
+                memory.shutdown();
+                assert(!memory.is_initialized());
+            }
+        }
+    }
+
+} // namespace
+
+int main() {
+    auto& memory = MemoryManager::getInstance();
+    // Before the scheduler runs, so no task is in flight across a shutdown
+    check_pool_options(memory);
+
+    PooledInts before_initialize = use_pools();
+    memory.initialize(64 * 1024 * 1024);
+    before_initialize = PooledInts(); // Back to the heap, not the pool
+
+    // The main thread never allocates, so every cache involved has exited
+    check_remote_frees_after_owner_exit(memory);
+    check_tag_peak(memory);
+
+    PooledInts in_pool = use_pools();
+    assert(memory.owns(in_pool.data()));
+
+    std::puts("MemoryManagerTest passed");
+    return 0;
+}
@@ -0,0 +1,97 @@
+// MemoryScalingBench.cpp - Small-block allocation throughput by thread count.
+// Every thread churns its own set of live blocks of 16-256 bytes, the range
+// the thread caches serve, and a slice of the frees go to blocks another
+// thread allocated. Runs once per thread count from 1 up to the hardware
+// concurrency (or the given maximum) and reports million operations per
+// second, an allocate and a deallocate counting as one operation each.
+//
+// Usage: MemoryScalingBench [operations_per_thread] [max_threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr size_t LIVE_PER_THREAD = 1024;
+    constexpr size_t REMOTE_FREE_PERIOD = 16; // One free in this many crosses threads
+
+    // Blocks handed between neighbouring threads for the cross-thread frees
+    struct Mailbox {
+        std::atomic<void*> slot{nullptr};
+    };
+
+    void churn(MemoryManager& memory, size_t operations, uint64_t seed, Mailbox& inbox, Mailbox& outbox,
+               std::atomic<bool>& go) {
+        std::mt19937_64 random(seed);
+        std::uniform_int_distribution<size_t> size(16, 256);
+        std::uniform_int_distribution<size_t> index(0, LIVE_PER_THREAD - 1);
+        std::vector<void*> live(LIVE_PER_THREAD);
+        for (void*& ptr : live) ptr = memory.allocate(size(random), "Scaling");
+
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+        for (size_t i = 0; i < operations / 2; ++i) {
+            void*& ptr = live[index(random)];
+            if (i % REMOTE_FREE_PERIOD == 0) {
+                // Post ours to the neighbour and free one it posted to us
+                memory.deallocate(outbox.slot.exchange(ptr, std::memory_order_acq_rel), "Scaling");
+                memory.deallocate(inbox.slot.exchange(nullptr, std::memory_order_acq_rel), "Scaling");
+            } else {
+                memory.deallocate(ptr, "Scaling");
+            }
+            ptr = memory.allocate(size(random), "Scaling");
+        }
+        for (void* ptr : live) memory.deallocate(ptr, "Scaling");
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t operations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                  : std::max(1u, std::thread::hardware_concurrency());
+
+    MemoryManager& memory = MemoryManager::getInstance();
+    memory.initialize(256 * 1024 * 1024);
+    std::printf("hardware concurrency %u, %zu operations per thread\n",
+                std::thread::hardware_concurrency(), operations);
+
+    // Powers of two, then the maximum itself
+    std::vector<size_t> counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    double single = 0.0;
+    for (size_t threads : counts) {
+        std::vector<Mailbox> mailboxes(threads);
+        std::vector<std::thread> workers;
+        std::atomic<bool> go{false};
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(churn, std::ref(memory), operations, 1000 + t, std::ref(mailboxes[t]),
+                                 std::ref(mailboxes[(t + 1) % threads]), std::ref(go));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (std::thread& worker : workers) worker.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Blocks still parked in the mailboxes
+        for (Mailbox& mailbox : mailboxes) memory.deallocate(mailbox.slot.load(), "Scaling");
+
+        double mops = threads * operations / seconds / 1e6;
+        if (threads == 1) single = mops;
+        std::printf("threads %2zu  %8.2f Mops/s  %5.2fx\n", threads, mops, mops / single);
+    }
+
+    memory.shutdown();
+    return 0;
+}
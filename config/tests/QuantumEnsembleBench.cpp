@@ -0,0 +1,93 @@
+// QuantumEnsembleBench.cpp - Batched trajectories against one at a time.
+// Steps an ensemble with QuantumEnsemble::update, then the same number of
+// separate state vectors each through its own mat-vec and explicit step,
+// which reads the whole Hamiltonian once per trajectory. Reports trajectory
+// steps per second for both at a few dimensions, formats and ensemble
+// sizes. Best of several rounds.
+//
+// Usage: QuantumEnsembleBench [max_dimension]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "MemoryManager.h"
+#include "QuantumEnsemble.h"
+#include "QuantumKernels.h"
+
+namespace {
+
+    constexpr int ROUNDS = 3;
+    constexpr double DT = 1e-3;
+
+    template<typename Run>
+    double best_seconds(Run&& run) {
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // The unbatched step: mat-vec, psi += -i dt H psi, renormalize
+    void step_alone(const HamiltonianMatrix& hamiltonian, ComplexVectorSoA& psi, ComplexVectorSoA& h_psi) {
+        hamiltonian.apply(psi, h_psi);
+        for (size_t i = 0; i < psi.size(); ++i) {
+            psi.re[i] += DT * h_psi.im[i];
+            psi.im[i] -= DT * h_psi.re[i];
+        }
+        QuantumKernels::scale(psi, 1.0 / std::sqrt(QuantumKernels::squared_norm(psi)));
+    }
+
+    const char* format_name(MatrixFormat format) {
+        switch (format) {
+        case MatrixFormat::Dense: return "dense";
+        case MatrixFormat::Banded: return "banded";
+        case MatrixFormat::CSR: return "csr";
+        default: return "auto";
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_dimension = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    std::printf("trajectory steps per second, best of %d rounds\n", ROUNDS);
+    std::printf("%6s %7s %6s %12s %12s %8s\n", "n", "format", "trajs", "ensemble", "alone", "speedup");
+
+    for (size_t n = 128; n <= max_dimension; n *= 2) {
+        for (auto [coupling, format] : {std::pair<size_t, MatrixFormat>{0, MatrixFormat::Dense},
+                                        {4, MatrixFormat::Banded}, {4, MatrixFormat::CSR}}) {
+            for (size_t trajectories : {8, 64}) {
+                QuantumEnsemble ensemble(trajectories, n, coupling, format);
+                // Dense steps cost far more, so they take fewer of them
+                int steps = std::max(1, static_cast<int>(2e7 / (ensemble.hamiltonian().nonzeros() * trajectories)));
+                double batched = best_seconds([&] {
+                    for (int s = 0; s < steps; ++s) ensemble.update(DT);
+                });
+
+                std::vector<ComplexVectorSoA> states(trajectories, ComplexVectorSoA(n));
+                for (auto& psi : states) std::fill(psi.re.begin(), psi.re.begin() + n, 1.0 / std::sqrt(double(n)));
+                ComplexVectorSoA h_psi(n);
+                double alone = best_seconds([&] {
+                    for (int s = 0; s < steps; ++s) {
+                        for (auto& psi : states) step_alone(ensemble.hamiltonian(), psi, h_psi);
+                    }
+                });
+
+                double work = double(steps) * trajectories;
+                std::printf("%6zu %7s %6zu %12.3g %12.3g %7.2fx\n", n, format_name(format), trajectories,
+                            work / batched, work / alone, alone / batched);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+// QuantumEnsembleTest.cpp - Each column evolves as that state would alone.
+// The ensemble's Hamiltonian is read back as a dense matrix, and every
+// trajectory is stepped again on its own through QuantumKernels::matvec:
+// the explicit step, <psi|H|psi>, renormalization and the collapse onto the
+// dominant basis state. Over several updates each column's amplitudes and
+// energy must match its lone reference, and collapses() must count the
+// references that collapsed. Trajectory counts below, at and past a SIMD
+// column group, every storage format, and an ensemble large enough to be
+// split over the scheduler workers are covered. One trajectory per ensemble
+// starts close to a basis state so it collapses, and one keeps the
+// uniform initial state.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "MemoryManager.h"
+#include "QuantumEnsemble.h"
+#include "QuantumKernels.h"
+
+namespace {
+
+    using Complex = std::complex<double>;
+
+    constexpr double DT = 0.05;
+    constexpr int STEPS = 6;
+    constexpr double AGREEMENT = 1e-12;
+
+    std::mt19937_64 g_random(24);
+
+    Complex random_complex() {
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+        double re = unit(g_random);
+        return {re, unit(g_random)};
+    }
+
+    // Column c of the dense matrix is H applied to basis vector c
+    ComplexMatrixSoA dense_hamiltonian(const HamiltonianMatrix& hamiltonian) {
+        size_t n = hamiltonian.size();
+        ComplexMatrixSoA dense(n, n);
+        ComplexVectorSoA basis(n);
+        ComplexVectorSoA column(n);
+        for (size_t c = 0; c < n; ++c) {
+            basis.set(c, 1.0);
+            hamiltonian.apply(basis, column);
+            for (size_t r = 0; r < n; ++r) dense.set(r, c, column.get(r));
+            basis.set(c, 0.0);
+        }
+        return dense;
+    }
+
+    // One trajectory stepped alone, as QuantumEnsemble::update describes it
+    struct Reference {
+        ComplexVectorSoA psi;
+        double energy = 0.0;
+
+        // Returns whether the state collapsed
+        bool step(const ComplexMatrixSoA& h, double dt) {
+            size_t n = psi.size();
+            ComplexVectorSoA h_psi(n);
+            QuantumKernels::matvec(h, psi, h_psi);
+
+            energy = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                energy += (std::conj(psi.get(i)) * h_psi.get(i)).real();
+                psi.set(i, psi.get(i) + Complex(0.0, -dt) * h_psi.get(i));
+            }
+
+            double norm = 0.0;
+            double peak = 0.0;
+            size_t peak_row = 0;
+            for (size_t i = 0; i < n; ++i) {
+                double probability = std::norm(psi.get(i));
+                norm += probability;
+                if (probability > peak) {
+                    peak = probability;
+                    peak_row = i;
+                }
+            }
+            for (size_t i = 0; i < n; ++i) psi.set(i, psi.get(i) / std::sqrt(norm));
+            if (peak / norm <= QuantumFluctuator::DEFAULT_DECOHERENCE_THRESHOLD) return false;
+
+            Complex amplitude = psi.get(peak_row);
+            for (size_t i = 0; i < n; ++i) psi.set(i, 0.0);
+            psi.set(peak_row, amplitude / std::abs(amplitude));
+            return true;
+        }
+    };
+
+    std::vector<Complex> random_state(size_t n) {
+        std::vector<Complex> amplitudes(n);
+        for (Complex& value : amplitudes) value = random_complex();
+        return amplitudes;
+    }
+
+    // Almost all of the probability on one basis state
+    std::vector<Complex> near_basis_state(size_t n, size_t row) {
+        std::vector<Complex> amplitudes(n);
+        for (Complex& value : amplitudes) value = random_complex() * (0.02 / std::sqrt(double(n)));
+        amplitudes[row] = std::polar(0.99, 0.7);
+        return amplitudes;
+    }
+
+    void check_ensemble(size_t trajectories, size_t dimension, size_t coupling_range, MatrixFormat format) {
+        QuantumEnsemble ensemble(trajectories, dimension, coupling_range, format);
+        assert(ensemble.trajectories() == trajectories && ensemble.dimension() == dimension);
+        assert(ensemble.hamiltonian().format() == format);
+        ComplexMatrixSoA h = dense_hamiltonian(ensemble.hamiltonian());
+
+        // Trajectory 0 collapses, the last one keeps the uniform superposition
+        std::vector<Reference> references(trajectories);
+        for (size_t t = 0; t < trajectories; ++t) {
+            bool keeps_initial = t > 0 && t + 1 == trajectories;
+            std::vector<Complex> amplitudes = t == 0 ? near_basis_state(dimension, dimension / 3)
+                : keeps_initial ? std::vector<Complex>(dimension, 1.0 / std::sqrt(double(dimension)))
+                : random_state(dimension);
+            if (!keeps_initial) ensemble.set_state(t, amplitudes);
+            references[t].psi = ComplexVectorSoA(dimension);
+            for (size_t i = 0; i < dimension; ++i) references[t].psi.set(i, amplitudes[i]);
+        }
+
+        for (int step = 0; step < STEPS; ++step) {
+            ensemble.update(DT);
+            size_t collapses = 0;
+            for (Reference& reference : references) collapses += reference.step(h, DT);
+            assert(ensemble.collapses() == collapses);
+            assert(collapses >= 1); // Trajectory 0
+
+            for (size_t t = 0; t < trajectories; ++t) {
+                assert(std::abs(ensemble.energy(t) - references[t].energy) <= AGREEMENT);
+                for (size_t i = 0; i < dimension; ++i) {
+                    assert(std::abs(ensemble.amplitude(t, i) - references[t].psi.get(i)) <= AGREEMENT);
+                }
+            }
+        }
+
+        QuantumStateVector state = ensemble.state(trajectories - 1);
+        assert(state.amplitudes.size() == dimension && state.timestamp != 0);
+        assert(state.energy_level == ensemble.energy(trajectories - 1));
+        for (size_t i = 0; i < dimension; ++i) assert(state.amplitudes[i] == ensemble.amplitude(trajectories - 1, i));
+    }
+
+    template<typename Call>
+    bool throws(Call&& call) {
+        try {
+            call();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    void check_errors() {
+        assert(throws([] { QuantumEnsemble ensemble(0); }));
+        QuantumEnsemble ensemble(3, 8);
+        std::vector<Complex> wrong_size(7);
+        assert(throws([&] { ensemble.set_state(0, wrong_size); }));
+        assert(throws([&] { ensemble.set_state(3, std::vector<Complex>(8)); }));
+        assert(throws([&] { ensemble.state(3); }));
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    // A coupling range of 0 couples every pair of states
+    check_ensemble(1, 16, 0, MatrixFormat::Dense);
+    check_ensemble(7, 24, 2, MatrixFormat::Banded);
+    check_ensemble(8, 32, 3, MatrixFormat::CSR);
+    check_ensemble(9, 20, 0, MatrixFormat::Dense);
+    check_ensemble(9, 64, 5, MatrixFormat::CSR);
+    check_ensemble(33, 48, 1, MatrixFormat::Banded);
+    // Enough work per update to be split into slices of column groups
+    check_ensemble(37, 256, 0, MatrixFormat::Dense);
+    check_errors();
+
+    std::puts("QuantumEnsembleTest passed");
+    return 0;
+}
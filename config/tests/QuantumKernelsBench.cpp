@@ -0,0 +1,64 @@
+// QuantumKernelsBench.cpp - Dense complex mat-vec GFLOP/s per KernelBackend.
+// Counts 8 n^2 flops per mat-vec (a complex multiply-add is 8 real flops)
+// for square dimensions from 64 up to the given maximum. Each figure is the
+// best of several timed batches of about 0.1 s. Large sizes are memory
+// bandwidth bound; the matrix takes 16 n^2 bytes.
+//
+// Usage: QuantumKernelsBench [max_dimension]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "MemoryManager.h"
+#include "QuantumKernels.h"
+
+namespace {
+
+    constexpr int ROUNDS = 3;
+
+    double matvec_gflops(const ComplexMatrixSoA& m, const ComplexVectorSoA& x, KernelBackend backend) {
+        ComplexVectorSoA y;
+        QuantumKernels::matvec(m, x, y, backend);
+
+        double flops = 8.0 * m.rows() * m.cols();
+        size_t repeats = std::max<size_t>(1, static_cast<size_t>(2e8 / flops));
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repeats; ++i) QuantumKernels::matvec(m, x, y, backend);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return flops * repeats / best / 1e9;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_dimension = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+    std::printf("GFLOP/s, best of %d rounds\n", ROUNDS);
+    std::printf("%8s %9s %9s %9s\n", "n", "Scalar", "AVX2", "AVX-512");
+
+    for (size_t n = 64; n <= max_dimension; n *= 2) {
+        ComplexMatrixSoA m(n, n);
+        ComplexVectorSoA x(n);
+        for (size_t r = 0; r < n; ++r) {
+            for (size_t c = 0; c < n; ++c) m.set(r, c, {double((r * 31 + c) % 17) - 8.0, double((r + c * 7) % 13) - 6.0});
+        }
+        for (size_t c = 0; c < n; ++c) x.set(c, {1.0 / (c + 1), 0.5});
+
+        std::printf("%8zu", n);
+        for (KernelBackend backend : {KernelBackend::Scalar, KernelBackend::AVX2, KernelBackend::AVX512}) {
+            if (QuantumKernels::resolve(backend) != backend) {
+                std::printf(" %9s", "n/a");
+                continue;
+            }
+            std::printf(" %9.2f", matvec_gflops(m, x, backend));
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// SchedulerBench.cpp - AsyncScheduler throughput on empty tasks.
+// Two shapes: an outside thread submitting every task, and every task
+// submitted from inside the workers (a few seed tasks fanning out), which
+// is where per-worker deques avoid the shared queue. Each task only bumps a
+// completion counter. The outside thread keeps at most MAX_IN_FLIGHT tasks
+// queued so the backlog fits the pool. Reports tasks per second from the
+// first submission to the last completion.
+//
+// Usage: SchedulerBench [tasks]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "AsyncScheduler.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    constexpr size_t MAX_IN_FLIGHT = 65536;
+
+    std::atomic<size_t> g_completed{0};
+
+    void empty_task() {
+        g_completed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void throttle(size_t submitted) {
+        while (submitted - g_completed.load(std::memory_order_relaxed) > MAX_IN_FLIGHT) std::this_thread::yield();
+    }
+
+    template<typename Submit>
+    double measure(const char* name, size_t tasks, Submit&& submit) {
+        g_completed.store(0);
+        auto start = std::chrono::steady_clock::now();
+        submit(tasks);
+        while (g_completed.load(std::memory_order_relaxed) < tasks) std::this_thread::yield();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-22s %6.2f s  %7.2f M tasks/s\n", name, seconds, tasks / seconds / 1e6);
+        return seconds;
+    }
+
+    // Seeds that each submit their share of the tasks from a worker
+    template<typename Spawn>
+    void fan_out(AsyncScheduler& scheduler, size_t tasks, Spawn spawn) {
+        constexpr size_t SEEDS = 16;
+        for (size_t seed = 0; seed < SEEDS; ++seed) {
+            size_t share = tasks / SEEDS + (seed < tasks % SEEDS ? 1 : 0);
+            scheduler.submit([&scheduler, share, spawn]() {
+                for (size_t i = 0; i < share; ++i) spawn(scheduler);
+            }, TaskPriority::NORMAL);
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    MemoryManager::getInstance().initialize(1024 * 1024 * 1024);
+    AsyncScheduler& scheduler = AsyncScheduler::getInstance();
+    std::printf("hardware concurrency %u, %zu empty tasks\n", std::thread::hardware_concurrency(), tasks);
+
+    measure("submit, outside", tasks, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            throttle(i);
+            scheduler.submit(empty_task, TaskPriority::NORMAL);
+        }
+    });
+    measure("submit, from workers", tasks, [&](size_t count) {
+        fan_out(scheduler, count, [](AsyncScheduler& s) { s.submit(empty_task, TaskPriority::NORMAL); });
+    });
+    measure("post, outside", tasks, [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            throttle(i);
+            scheduler.post(empty_task);
+        }
+    });
+    measure("post, from workers", tasks, [&](size_t count) {
+        fan_out(scheduler, count, [](AsyncScheduler& s) { s.post(empty_task); });
+    });
+    return 0;
+}
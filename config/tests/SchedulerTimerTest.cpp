@@ -0,0 +1,206 @@
+// SchedulerTimerTest.cpp - Timed submission through the AsyncScheduler.
+// Runs real timers on the scheduler's timer thread with real delays.
+// One-shot timers, including delays that are not whole milliseconds, must
+// never run before their delay or time point and must run within a
+// generous bound after it. Timers that come due while every worker is busy
+// must wait in their priority lane, so no worker runs a LOW timer and then
+// a HIGH one. A periodic task that overruns its period must never overlap
+// itself. cancel stops a pending one-shot timer and reports a fired one,
+// and a periodic task cancelled from its own callback is not run again.
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncScheduler.h"
+#include "MemoryManager.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::microseconds;
+
+    // Upper bound on timer lateness; loaded CI machines can be slow
+    constexpr milliseconds LATE_BOUND{500};
+
+    template<typename Predicate>
+    void wait_until(Predicate done) {
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (!done()) {
+            assert(Clock::now() < deadline);
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+    }
+
+    void check_never_early() {
+        auto& scheduler = AsyncScheduler::getInstance();
+        const Clock::duration delays[] = {Clock::duration::zero(), microseconds(300), milliseconds(1),
+                                          microseconds(1500), milliseconds(7), milliseconds(25)};
+        constexpr size_t COUNT = std::size(delays);
+        std::vector<Clock::time_point> submitted(COUNT + 1), ran(COUNT + 1);
+        std::atomic<size_t> done{0};
+
+        for (size_t i = 0; i < COUNT; ++i) {
+            submitted[i] = Clock::now();
+            scheduler.submit_after(delays[i], [&, i] {
+                ran[i] = Clock::now();
+                ++done;
+            });
+        }
+        Clock::time_point at = Clock::now() + microseconds(12500);
+        scheduler.submit_at(at, [&] {
+            ran[COUNT] = Clock::now();
+            ++done;
+        });
+
+        wait_until([&] { return done.load() == COUNT + 1; });
+        for (size_t i = 0; i < COUNT; ++i) {
+            assert(ran[i] - submitted[i] >= delays[i]);
+            assert(ran[i] - submitted[i] < delays[i] + LATE_BOUND);
+        }
+        assert(ran[COUNT] >= at && ran[COUNT] < at + LATE_BOUND);
+    }
+
+    // Holds every worker until released
+    struct Gate {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool open = false;
+        std::atomic<size_t> waiting{0};
+
+        void block() {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++waiting;
+            condition.wait(lock, [&] { return open; });
+        }
+
+        void release() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                open = true;
+            }
+            condition.notify_all();
+        }
+    };
+
+    void check_priority_lanes() {
+        auto& scheduler = AsyncScheduler::getInstance();
+        size_t workers = scheduler.worker_count();
+        Gate gate;
+        for (size_t w = 0; w < workers; ++w) scheduler.post([&] { gate.block(); }, TaskPriority::CRITICAL);
+        wait_until([&] { return gate.waiting.load() == workers; });
+
+        // Every timer comes due while the workers are held, LOW ones first
+        constexpr int PER_LANE = 16;
+        std::mutex mutex;
+        std::map<std::thread::id, std::vector<TaskPriority>> order; // Per worker, in run order
+        std::atomic<int> done{0};
+        auto record = [&](TaskPriority p) {
+            return [&, p] {
+                std::lock_guard<std::mutex> lock(mutex);
+                order[std::this_thread::get_id()].push_back(p);
+                ++done;
+            };
+        };
+        for (int i = 0; i < PER_LANE; ++i) {
+            scheduler.submit_after(milliseconds(2), record(TaskPriority::LOW), TaskPriority::LOW);
+        }
+        for (int i = 0; i < PER_LANE; ++i) {
+            scheduler.submit_after(milliseconds(10), record(TaskPriority::HIGH), TaskPriority::HIGH);
+        }
+        std::this_thread::sleep_for(milliseconds(10) + LATE_BOUND);
+        assert(done.load() == 0);
+        gate.release();
+        wait_until([&] { return done.load() == 2 * PER_LANE; });
+
+        // A worker that took a LOW timer found no HIGH one queued
+        for (const auto& [worker, priorities] : order) {
+            bool seen_low = false;
+            for (TaskPriority p : priorities) {
+                if (p == TaskPriority::LOW) seen_low = true;
+                assert(!(seen_low && p == TaskPriority::HIGH));
+            }
+        }
+    }
+
+    void check_periodic_overrun() {
+        auto& scheduler = AsyncScheduler::getInstance();
+        std::atomic<bool> running{false};
+        std::atomic<bool> overlapped{false};
+        std::atomic<int> runs{0};
+
+        // Each run takes about three periods
+        TimerHandle handle = scheduler.submit_every(milliseconds(3), [&] {
+            if (running.exchange(true)) overlapped = true;
+            std::this_thread::sleep_for(milliseconds(9));
+            ++runs;
+            running = false;
+        });
+        std::this_thread::sleep_for(milliseconds(200));
+        assert(scheduler.cancel(handle));
+        wait_until([&] { return !running.load(); });
+
+        assert(!overlapped.load());
+        assert(runs.load() >= 3);
+
+        // Nothing more after the cancel
+        int final_runs = runs.load();
+        std::this_thread::sleep_for(milliseconds(30));
+        assert(runs.load() == final_runs);
+    }
+
+    void check_cancel() {
+        auto& scheduler = AsyncScheduler::getInstance();
+        std::atomic<int> fired{0};
+
+        TimerHandle pending = scheduler.submit_after(milliseconds(50), [&] { ++fired; });
+        assert(scheduler.cancel(pending));
+        assert(!scheduler.cancel(pending));
+
+        TimerHandle once = scheduler.submit_after(milliseconds(1), [&] { ++fired; });
+        wait_until([&] { return fired.load() == 1; });
+        assert(!scheduler.cancel(once));
+        std::this_thread::sleep_for(milliseconds(70));
+        assert(fired.load() == 1);
+
+        // Cancelled from its own third run
+        std::mutex mutex;
+        TimerHandle periodic;
+        std::atomic<int> runs{0};
+        std::atomic<bool> cancelled{false};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            periodic = scheduler.submit_every(milliseconds(2), [&] {
+                if (++runs == 3) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cancelled = scheduler.cancel(periodic);
+                }
+            });
+        }
+        wait_until([&] { return runs.load() >= 3; });
+        std::this_thread::sleep_for(milliseconds(30));
+        assert(cancelled.load());
+        assert(runs.load() == 3);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_never_early();
+    check_priority_lanes();
+    check_periodic_overrun();
+    check_cancel();
+
+    std::puts("SchedulerTimerTest passed");
+    return 0;
+}
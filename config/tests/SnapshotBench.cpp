@@ -0,0 +1,88 @@
+// SnapshotBench.cpp - Cost of publishing a state against copying it.
+// For each state size, times SnapshotPublisher::publish when no reader
+// holds the current snapshot, so it is written in place, and when a reader
+// keeps each snapshot until the next tick, so every publish takes a buffer
+// from the pool. The baseline copies the amplitudes into a fresh
+// std::vector per tick, as handing out a copied state would. Then times
+// handing one snapshot to several readers by copying the handle against
+// copying the vector. Best of several rounds.
+//
+// Usage: SnapshotBench [max_size]
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include "MemoryManager.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+    using Complex = std::complex<double>;
+
+    constexpr int ROUNDS = 3;
+    constexpr int READERS = 4;
+
+    // Keeps the compiler from dropping the copies
+    volatile double g_sink;
+
+    template<typename Run>
+    double best_ns(size_t repeats, Run&& run) {
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repeats; ++i) run(i);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best / repeats * 1e9;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16384;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    std::printf("ns per tick, best of %d rounds; %d readers per hand-out\n", ROUNDS, READERS);
+    std::printf("%8s %10s %10s %10s %12s %12s\n", "size", "in place", "pooled", "vector", "hand handle",
+                "hand vector");
+
+    for (size_t size = 64; size <= max_size; size *= 4) {
+        std::vector<Complex> state(size, Complex(0.5, -0.5));
+        auto fill = [&](std::span<Complex> amplitudes) { std::copy(state.begin(), state.end(), amplitudes.begin()); };
+        size_t repeats = std::max<size_t>(1000, (size_t(1) << 26) / (size * sizeof(Complex)));
+
+        SnapshotPublisher publisher;
+        double in_place = best_ns(repeats, [&](size_t i) { publisher.publish(size, 1.0, i, fill); });
+
+        StateSnapshot reader;
+        double pooled = best_ns(repeats, [&](size_t i) { reader = publisher.publish(size, 1.0, i, fill); });
+        reader = StateSnapshot();
+
+        double copied = best_ns(repeats, [&](size_t) {
+            std::vector<Complex> copy(state);
+            g_sink = copy.back().real();
+        });
+
+        // Several readers of one tick
+        std::vector<StateSnapshot> handles(READERS);
+        double handed = best_ns(repeats, [&](size_t) {
+            for (auto& handle : handles) handle = publisher.current();
+            g_sink = handles.back().energy_level();
+        });
+        handles.assign(READERS, StateSnapshot());
+        std::vector<std::vector<Complex>> copies(READERS);
+        double handed_copies = best_ns(repeats, [&](size_t) {
+            for (auto& copy : copies) copy = std::vector<Complex>(state);
+            g_sink = copies.back().back().real();
+        });
+
+        std::printf("%8zu %10.1f %10.1f %10.1f %12.1f %12.1f\n", size, in_place, pooled, copied, handed,
+                    handed_copies);
+    }
+    return 0;
+}
@@ -0,0 +1,196 @@
+// StateSnapshotTest.cpp - Published snapshots never change under a reader.
+// SnapshotPublisher::publish must write over the current buffer in place
+// while its own handle is the only one, and take another buffer as soon as
+// a reader holds a copy or the size changes. Every held snapshot keeps the
+// amplitudes, energy and timestamp it was published with through any
+// number of later publishes, released buffers are handed out again, and
+// handles count their references through copies and moves. Finally
+// reader threads hold snapshots passed through a queue while the producer
+// keeps publishing, and check each one against the tick it came from.
+
+#include <atomic>
+#include <cassert>
+#include <complex>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MemoryManager.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+    using Complex = std::complex<double>;
+
+    // Every amplitude of a tick is derived from its timestamp
+    Complex tick_amplitude(uint64_t tick, size_t index) {
+        return {static_cast<double>(tick), static_cast<double>(index)};
+    }
+
+    const StateSnapshot& publish_tick(SnapshotPublisher& publisher, size_t size, uint64_t tick) {
+        return publisher.publish(size, 0.5 * static_cast<double>(tick), tick, [&](std::span<Complex> amplitudes) {
+            assert(amplitudes.size() == size);
+            for (size_t i = 0; i < size; ++i) amplitudes[i] = tick_amplitude(tick, i);
+        });
+    }
+
+    bool holds_tick(const StateSnapshot& snapshot, size_t size, uint64_t tick) {
+        if (snapshot.size() != size || snapshot.timestamp() != tick) return false;
+        if (snapshot.energy_level() != 0.5 * static_cast<double>(tick)) return false;
+        for (size_t i = 0; i < size; ++i) {
+            if (snapshot.amplitudes()[i] != tick_amplitude(tick, i)) return false;
+        }
+        return true;
+    }
+
+    const Complex* buffer_of(const StateSnapshot& snapshot) { return snapshot.amplitudes().data(); }
+
+    void check_handles() {
+        StateSnapshot empty;
+        assert(!empty && empty.use_count() == 0 && empty.size() == 0 && empty.amplitudes().empty());
+
+        SnapshotPublisher publisher;
+        assert(!publisher.current());
+        StateSnapshot first = publish_tick(publisher, 8, 1);
+        assert(first.use_count() == 2);
+        StateSnapshot copy = first;
+        assert(first.use_count() == 3 && buffer_of(copy) == buffer_of(first));
+        StateSnapshot moved = std::move(copy);
+        assert(!copy && moved.use_count() == 3);
+        moved = StateSnapshot();
+        assert(first.use_count() == 2);
+    }
+
+    void check_reuse() {
+        SnapshotPublisher publisher;
+        const Complex* buffer = buffer_of(publish_tick(publisher, 16, 1));
+        assert(publisher.current().use_count() == 1);
+
+        // Sole owner: written in place
+        for (uint64_t tick = 2; tick < 10; ++tick) {
+            const StateSnapshot& current = publish_tick(publisher, 16, tick);
+            assert(buffer_of(current) == buffer && current.use_count() == 1);
+            assert(holds_tick(current, 16, tick));
+        }
+
+        // A reader holds it: the next publish goes elsewhere and the reader's
+        // snapshot is untouched
+        StateSnapshot held = publisher.current();
+        assert(held.use_count() == 2);
+        const StateSnapshot& next = publish_tick(publisher, 16, 10);
+        assert(buffer_of(next) != buffer && next.use_count() == 1);
+        assert(held.use_count() == 1 && buffer_of(held) == buffer);
+        assert(holds_tick(held, 16, 9) && holds_tick(next, 16, 10));
+
+        // Once the reader lets go, the new buffer is written in place again
+        const Complex* second = buffer_of(next);
+        held = StateSnapshot();
+        assert(buffer_of(publish_tick(publisher, 16, 11)) == second);
+
+        // A different size never reuses the buffer
+        const Complex* resized = buffer_of(publish_tick(publisher, 24, 12));
+        assert(resized != second && holds_tick(publisher.current(), 24, 12));
+        assert(buffer_of(publish_tick(publisher, 24, 13)) == resized);
+    }
+
+    void check_many_readers() {
+        constexpr size_t SIZE = 64;
+        SnapshotPublisher publisher;
+        std::vector<StateSnapshot> held;
+        std::set<const Complex*> buffers;
+        for (uint64_t tick = 0; tick < 40; ++tick) {
+            const StateSnapshot& current = publish_tick(publisher, SIZE, tick);
+            // Each held snapshot keeps its own buffer
+            assert(buffers.insert(buffer_of(current)).second);
+            held.push_back(current);
+        }
+        for (uint64_t tick = 0; tick < held.size(); ++tick) assert(holds_tick(held[tick], SIZE, tick));
+
+        // Released buffers come back from the pool
+        held.clear();
+        StateSnapshot reader = publisher.current();
+        const StateSnapshot& current = publish_tick(publisher, SIZE, 100);
+        assert(buffers.count(buffer_of(current)) == 1 && buffer_of(current) != buffer_of(reader));
+        assert(holds_tick(reader, SIZE, 39) && holds_tick(current, SIZE, 100));
+    }
+
+    // Readers hold snapshots for a while after the producer has moved on
+    void check_concurrent_readers() {
+        constexpr size_t SIZE = 256;
+        constexpr uint64_t TICKS = 20000;
+        constexpr int READERS = 3;
+
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::pair<uint64_t, StateSnapshot>> queue; // With the tick it was published at
+        bool done = false;
+        std::atomic<bool> changed{false};
+        std::atomic<uint64_t> checked{0};
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < READERS; ++r) {
+            readers.emplace_back([&] {
+                std::vector<std::pair<uint64_t, StateSnapshot>> window; // Kept across several later ticks
+                auto check_window = [&] {
+                    for (const auto& [tick, held] : window) {
+                        if (!holds_tick(held, SIZE, tick)) changed = true;
+                    }
+                    checked.fetch_add(window.size(), std::memory_order_relaxed);
+                    window.clear();
+                };
+                for (;;) {
+                    std::pair<uint64_t, StateSnapshot> entry;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        ready.wait(lock, [&] { return done || !queue.empty(); });
+                        if (queue.empty()) break;
+                        entry = std::move(queue.front());
+                        queue.pop_front();
+                    }
+                    window.push_back(std::move(entry));
+                    if (window.size() == 8) check_window();
+                }
+                check_window();
+            });
+        }
+
+        SnapshotPublisher publisher;
+        for (uint64_t tick = 0; tick < TICKS; ++tick) {
+            const StateSnapshot& current = publish_tick(publisher, SIZE, tick);
+            // Every third tick goes to a reader; the others may be written in place
+            if (tick % 3 != 0) continue;
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back(tick, current);
+            ready.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        ready.notify_all();
+        for (auto& reader : readers) reader.join();
+
+        assert(!changed.load());
+        assert(checked.load() == (TICKS + 2) / 3);
+        assert(publisher.current().use_count() == 1);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_handles();
+    check_reuse();
+    check_many_readers();
+    check_concurrent_readers();
+
+    std::puts("StateSnapshotTest passed");
+    return 0;
+}
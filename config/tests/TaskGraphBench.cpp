@@ -0,0 +1,109 @@
+// TaskGraphBench.cpp - Wide and deep dependency graphs, three ways.
+// wide: one source, N independent middle tasks, one sink after all of them.
+// deep: a chain of N tasks, each after the previous one.
+// Each shape runs as
+//   blocking   - AsyncScheduler::submit with an outside thread waiting on the
+//                std::future of each stage before releasing the next,
+//   futures    - TaskFuture::then chains and when_all,
+//   graph      - a TaskGraph built once and run repeatedly.
+// Tasks only bump a counter. Reports the mean time per run and per task.
+//
+// Usage: TaskGraphBench [tasks] [runs]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <vector>
+
+#include "AsyncScheduler.h"
+#include "MemoryManager.h"
+#include "TaskGraph.h"
+
+namespace {
+
+    std::atomic<size_t> g_executed{0};
+
+    void work() {
+        g_executed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename Run>
+    void measure(const char* name, size_t tasks, size_t runs, Run&& run) {
+        run(); // Warm-up grows the pools
+        g_executed.store(0);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < runs; ++i) run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (g_executed.load() != tasks * runs) {
+            std::printf("%s: executed %zu tasks, expected %zu\n", name, g_executed.load(), tasks * runs);
+            std::exit(1);
+        }
+        std::printf("%-16s %9.2f ms/run  %7.1f ns/task\n", name, seconds * 1e3 / runs, seconds * 1e9 / (tasks * runs));
+    }
+
+    void wide_blocking(AsyncScheduler& scheduler, size_t middle) {
+        scheduler.submit(work, TaskPriority::NORMAL).get();
+        std::vector<std::future<void>> stage;
+        stage.reserve(middle);
+        for (size_t i = 0; i < middle; ++i) stage.push_back(scheduler.submit(work, TaskPriority::NORMAL));
+        for (auto& future : stage) future.get();
+        scheduler.submit(work, TaskPriority::NORMAL).get();
+    }
+
+    void deep_blocking(AsyncScheduler& scheduler, size_t length) {
+        for (size_t i = 0; i < length; ++i) scheduler.submit(work, TaskPriority::NORMAL).get();
+    }
+
+    void wide_futures(size_t middle) {
+        TaskFuture<void> source = spawn_task(work);
+        std::vector<TaskFuture<void>> stage;
+        stage.reserve(middle);
+        for (size_t i = 0; i < middle; ++i) stage.push_back(source.then(work));
+        when_all(std::move(stage)).then(work).get();
+    }
+
+    void deep_futures(size_t length) {
+        TaskFuture<void> tail = spawn_task(work);
+        for (size_t i = 1; i < length; ++i) tail = tail.then(work);
+        tail.get();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t runs = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+
+    MemoryManager::getInstance().initialize(512 * 1024 * 1024);
+    AsyncScheduler& scheduler = AsyncScheduler::getInstance();
+    std::printf("hardware concurrency %u, %zu tasks per graph, %zu runs\n",
+                std::thread::hardware_concurrency(), tasks, runs);
+
+    size_t middle = tasks - 2;
+    TaskGraph wide;
+    TaskGraph::NodeId source = wide.add(work);
+    TaskGraph::NodeId sink = wide.add(work);
+    for (size_t i = 0; i < middle; ++i) {
+        TaskGraph::NodeId node = wide.add(work);
+        wide.precede(source, node);
+        wide.precede(node, sink);
+    }
+
+    TaskGraph deep;
+    TaskGraph::NodeId previous = deep.add(work);
+    for (size_t i = 1; i < tasks; ++i) {
+        TaskGraph::NodeId node = deep.add(work);
+        deep.precede(previous, node);
+        previous = node;
+    }
+
+    measure("wide blocking", tasks, runs, [&] { wide_blocking(scheduler, middle); });
+    measure("wide futures", tasks, runs, [&] { wide_futures(middle); });
+    measure("wide graph", tasks, runs, [&] { wide.run().get(); });
+    measure("deep blocking", tasks, runs, [&] { deep_blocking(scheduler, tasks); });
+    measure("deep futures", tasks, runs, [&] { deep_futures(tasks); });
+    measure("deep graph", tasks, runs, [&] { deep.run().get(); });
+    return 0;
+}
@@ -0,0 +1,192 @@
+// TaskGraphTest.cpp - Continuations, joins and graphs deliver results and errors.
+// then passes values along a chain and an exception skips the rest of it.
+// when_all keeps the input order and reports an input's error; when_any
+// names the input that finished first. A TaskGraph runs every node after
+// its predecessors, skips the successors of a node that throws while its
+// other branches still run, reports the error through run()'s future, can
+// be run again, and rejects an edge that would close a cycle.
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncScheduler.h"
+#include "MemoryManager.h"
+#include "TaskGraph.h"
+
+namespace {
+
+    template<typename T>
+    std::string error_of(const TaskFuture<T>& future) {
+        try {
+            future.get();
+        } catch (const std::exception& e) {
+            return e.what();
+        }
+        return "";
+    }
+
+    void check_then() {
+        TaskFuture<int> value = spawn_task([] { return 20; });
+        TaskFuture<std::string> chained = value.then([](const int& v) { return v + 1; })
+                                               .then([](const int& v) { return std::to_string(v * 2); });
+        assert(chained.get() == "42");
+
+        std::atomic<int> ran{0};
+        TaskFuture<void> done = spawn_task([&] { ran.fetch_add(1); }).then([&] { ran.fetch_add(1); });
+        done.get();
+        assert(ran.load() == 2);
+
+        // The error skips the continuation and reaches the end of the chain
+        std::atomic<bool> skipped_ran{false};
+        TaskFuture<int> failed = spawn_task([]() -> int { throw std::runtime_error("first"); })
+                                     .then([&](const int& v) { skipped_ran = true; return v; })
+                                     .then([](const int& v) { return v; });
+        assert(error_of(failed) == "first");
+        assert(!skipped_ran.load());
+
+        // Continuations added after completion still run
+        TaskFuture<int> ready = make_ready_task(5);
+        assert(ready.then([](const int& v) { return v * 3; }).get() == 15);
+    }
+
+    void check_when_all() {
+        std::vector<TaskFuture<int>> inputs;
+        for (int i = 0; i < 50; ++i) {
+            inputs.push_back(spawn_task([i] {
+                std::this_thread::sleep_for(std::chrono::microseconds((50 - i) * 20));
+                return i;
+            }));
+        }
+        std::vector<int> values = when_all(std::move(inputs)).get();
+        assert(values.size() == 50);
+        for (int i = 0; i < 50; ++i) assert(values[i] == i);
+
+        assert(when_all(std::vector<TaskFuture<int>>()).get().empty());
+
+        std::vector<TaskFuture<void>> with_error;
+        std::atomic<int> finished{0};
+        for (int i = 0; i < 8; ++i) {
+            with_error.push_back(spawn_task([i, &finished] {
+                finished.fetch_add(1);
+                if (i == 5) throw std::runtime_error("input 5");
+            }));
+        }
+        TaskFuture<void> joined = when_all(std::move(with_error));
+        assert(error_of(joined) == "input 5");
+        assert(finished.load() == 8); // Completes only once every input has
+    }
+
+    void check_when_any() {
+        // Sleeping rather than spinning, so the workers are never all held up
+        std::vector<TaskFuture<int>> inputs;
+        for (int i = 0; i < 4; ++i) {
+            if (i == 2) {
+                inputs.push_back(make_ready_task(i));
+                continue;
+            }
+            inputs.push_back(spawn_task([i] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                return i;
+            }));
+        }
+        assert(when_any(inputs).get() == 2);
+        when_all(std::move(inputs)).get();
+    }
+
+    void check_graph_order() {
+        // Diamond on top of a chain: 0 -> {1, 2} -> 3 -> 4
+        TaskGraph graph;
+        std::atomic<int> step{0};
+        std::vector<int> finished_at(5, -1);
+        auto node = [&](int id) { return [&, id] { finished_at[id] = step.fetch_add(1); }; };
+        for (int id = 0; id < 5; ++id) graph.add(node(id));
+        graph.precede(0, 1);
+        graph.precede(0, 2);
+        graph.precede(1, 3);
+        graph.precede(2, 3);
+        graph.precede(3, 4);
+
+        for (int run = 0; run < 3; ++run) {
+            step = 0;
+            graph.run().get();
+            assert(finished_at[0] == 0);
+            assert(finished_at[1] < finished_at[3] && finished_at[2] < finished_at[3]);
+            assert(finished_at[3] == 3 && finished_at[4] == 4);
+        }
+
+        TaskGraph empty;
+        empty.run().get();
+    }
+
+    void check_graph_error() {
+        // 0 -> 1 (throws) -> 2 -> 3, and 0 -> 4 -> 5 on an independent branch
+        TaskGraph graph;
+        std::vector<std::atomic<int>> ran(6);
+        for (int id = 0; id < 6; ++id) {
+            graph.add([&, id] {
+                ran[id].fetch_add(1);
+                if (id == 1) throw std::runtime_error("node 1");
+            });
+        }
+        graph.precede(0, 1);
+        graph.precede(1, 2);
+        graph.precede(2, 3);
+        graph.precede(0, 4);
+        graph.precede(4, 5);
+
+        for (int run = 1; run <= 2; ++run) {
+            TaskFuture<void> done = graph.run();
+            assert(error_of(done) == "node 1");
+            assert(ran[0] == run && ran[1] == run && ran[4] == run && ran[5] == run);
+            assert(ran[2] == 0 && ran[3] == 0);
+        }
+    }
+
+    void check_graph_cycle() {
+        TaskGraph graph;
+        for (int id = 0; id < 4; ++id) graph.add([] {});
+        graph.precede(0, 1);
+        graph.precede(1, 2);
+        graph.precede(2, 3);
+        graph.precede(0, 3); // Redundant, not a cycle
+
+        bool rejected = false;
+        try {
+            graph.precede(3, 0);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected);
+
+        rejected = false;
+        try {
+            graph.precede(2, 2);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected);
+
+        // The rejected edges left the graph runnable
+        graph.run().get();
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_then();
+    check_when_all();
+    check_when_any();
+    check_graph_order();
+    check_graph_error();
+    check_graph_cycle();
+
+    std::puts("TaskGraphTest passed");
+    return 0;
+}
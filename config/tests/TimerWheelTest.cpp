@@ -0,0 +1,157 @@
+// TimerWheelTest.cpp - Every timer fires on exactly its tick.
+// Drives a TimerWheel with explicit ticks. Delays sit on either side of
+// each level boundary (256, 65536 and 2^24 ticks) and beyond the wheel's
+// 2^32-tick range, from a start tick that is not level aligned, so timers
+// cascade inward through every level. The same timers are advanced in
+// single ticks, in uneven jumps and in one jump; each must fire once, on
+// its own tick. Cancelled timers never fire, and periodic timers re-armed
+// from the callback fire on every period.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "TimerWheel.h"
+
+namespace {
+
+    constexpr uint64_t START_TICK = 1000003;
+
+    struct Expected {
+        uint64_t expires;
+        uint64_t period = 0; // Re-armed this far after each firing, 0 for one-shot
+        std::vector<uint64_t> fired;
+    };
+
+    std::vector<uint64_t> boundary_delays() {
+        std::vector<uint64_t> delays = {0, 1, 2};
+        for (uint64_t boundary : {uint64_t(1) << 8, uint64_t(1) << 16, uint64_t(1) << 24, uint64_t(1) << 32}) {
+            for (uint64_t delta : {boundary - 1, boundary, boundary + 1}) delays.push_back(delta);
+        }
+        delays.push_back((uint64_t(1) << 33) + 12345); // Parked, then re-filed
+        return delays;
+    }
+
+    // Advances to end using the given step sizes (cycled) and checks every firing tick
+    void run_wheel(const std::vector<uint64_t>& delays, const std::vector<uint64_t>& steps) {
+        TimerWheel<size_t> wheel(START_TICK);
+        std::vector<Expected> expected;
+        for (uint64_t delay : delays) {
+            expected.push_back(Expected{START_TICK + delay});
+            wheel.add(START_TICK + delay, expected.size() - 1);
+        }
+        uint64_t last = 0;
+        for (const Expected& e : expected) last = std::max(last, e.expires);
+
+        auto on_expired = [&](TimerId id) {
+            size_t index = *wheel.find(id);
+            // The wheel has moved past the tick it is firing
+            expected[index].fired.push_back(wheel.current_tick() - 1);
+            wheel.release(id);
+        };
+        for (size_t i = 0; wheel.current_tick() <= last; ++i) {
+            wheel.advance(std::min(last, wheel.current_tick() - 1 + steps[i % steps.size()]), on_expired);
+        }
+
+        for (const Expected& e : expected) {
+            assert(e.fired.size() == 1);
+            assert(e.fired[0] == e.expires);
+        }
+        assert(wheel.size() == 0);
+        assert(wheel.next_expiry() == TimerWheel<size_t>::NO_EXPIRY);
+    }
+
+    void check_boundaries() {
+        std::vector<uint64_t> delays = boundary_delays();
+        run_wheel(delays, {uint64_t(1) << 40});            // One jump
+        run_wheel(delays, {1, 255, 256, 65535, 70000, 3}); // Uneven jumps
+    }
+
+    void check_single_ticks() {
+        // Stepping one tick at a time is only affordable over a shorter range
+        std::vector<uint64_t> delays;
+        for (uint64_t delay : boundary_delays()) {
+            if (delay <= (uint64_t(1) << 17)) delays.push_back(delay);
+        }
+        run_wheel(delays, {1});
+    }
+
+    void check_random() {
+        std::mt19937_64 random(11);
+        std::vector<uint64_t> delays;
+        for (int i = 0; i < 2000; ++i) {
+            int bits = static_cast<int>(random() % 34);
+            delays.push_back(random() & ((uint64_t(1) << bits) - 1));
+        }
+        run_wheel(delays, {1, 1000, 77777, uint64_t(1) << 20, 5, uint64_t(1) << 28});
+    }
+
+    void check_cancel() {
+        TimerWheel<int> wheel(START_TICK);
+        std::vector<TimerId> ids;
+        for (int i = 0; i < 12; ++i) ids.push_back(wheel.add(START_TICK + (uint64_t(1) << (i * 3)), i));
+        for (int i = 0; i < 12; i += 2) assert(wheel.cancel(ids[i]));
+        assert(wheel.size() == 6);
+        assert(!wheel.cancel(ids[0])); // Already cancelled
+        assert(wheel.find(ids[0]) == nullptr);
+
+        std::vector<int> fired;
+        wheel.advance(START_TICK + (uint64_t(1) << 40), [&](TimerId id) {
+            fired.push_back(*wheel.find(id));
+            wheel.release(id);
+        });
+        assert((fired == std::vector<int>{1, 3, 5, 7, 9, 11}));
+        assert(!wheel.cancel(ids[1])); // Already fired
+
+        // The last node released is reused first, under a new generation
+        TimerId reused = wheel.add(wheel.current_tick() + 10, 99);
+        assert(reused.index == ids[11].index && reused.generation != ids[11].generation);
+        assert(wheel.find(ids[11]) == nullptr);
+        assert(!wheel.cancel(ids[11]));
+        assert(wheel.cancel(reused));
+    }
+
+    void check_periodic() {
+        // Periods on either side of the level-0 and level-1 boundaries
+        TimerWheel<size_t> wheel(START_TICK);
+        std::vector<Expected> expected;
+        for (uint64_t period : {1, 7, 255, 256, 257, 65535, 65536, 65537}) {
+            expected.push_back(Expected{START_TICK + period, period});
+            wheel.add(START_TICK + period, expected.size() - 1);
+        }
+        uint64_t end = START_TICK + 400000;
+        auto on_expired = [&](TimerId id) {
+            Expected& e = expected[*wheel.find(id)];
+            uint64_t tick = wheel.current_tick() - 1;
+            e.fired.push_back(tick);
+            wheel.rearm(id, tick + e.period);
+        };
+        for (uint64_t step : {1, 100, 1000, 300, 50000, 400000}) {
+            while (wheel.current_tick() <= end && wheel.current_tick() < START_TICK + step * 50) {
+                wheel.advance(std::min(end, wheel.current_tick() - 1 + step), on_expired);
+            }
+        }
+        wheel.advance(end, on_expired);
+
+        for (const Expected& e : expected) {
+            assert(e.fired.size() == (end - START_TICK) / e.period);
+            for (size_t k = 0; k < e.fired.size(); ++k) assert(e.fired[k] == START_TICK + (k + 1) * e.period);
+        }
+        assert(wheel.size() == expected.size());
+    }
+
+} // namespace
+
+int main() {
+    check_boundaries();
+    check_single_ticks();
+    check_random();
+    check_cancel();
+    check_periodic();
+
+    std::puts("TimerWheelTest passed");
+    return 0;
+}
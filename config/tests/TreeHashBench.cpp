@@ -0,0 +1,75 @@
+// TreeHashBench.cpp - TreeHash throughput against the single-stream hash.
+// Hashes one large buffer with CryptoHash::compute, then with
+// TreeHash::compute at several chunk sizes, where the leaves are spread over
+// the scheduler workers. Then measures the incremental path: one chunk of a
+// hashed buffer is modified, re-read with rehash_chunks and the digest
+// taken again, which touches one leaf and its path to the root. Best of
+// several rounds.
+//
+// Usage: TreeHashBench [megabytes]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "CryptoHash.h"
+#include "MemoryManager.h"
+#include "TreeHash.h"
+
+namespace {
+
+    constexpr int ROUNDS = 5;
+    constexpr int REHASH_REPEATS = 200;
+
+    // Keeps the compiler from dropping the digests
+    volatile uint8_t g_sink;
+
+    template<typename Run>
+    double best_seconds(Run&& run) {
+        double best = 1e30;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t length = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+
+    MemoryManager::getInstance().initialize(256 * 1024 * 1024);
+    std::string data(length, '\0');
+    for (size_t i = 0; i < length; ++i) data[i] = static_cast<char>((i * 131) >> 3);
+    std::printf("hardware concurrency %u, %zu MiB, best of %d rounds\n", std::thread::hardware_concurrency(),
+                length >> 20, ROUNDS);
+
+    double single = best_seconds([&] { g_sink = CryptoHash::compute(data)[0]; });
+    std::printf("%-24s %8.1f MB/s\n", "CryptoHash::compute", length / single / 1e6);
+
+    for (size_t chunk_size : {size_t(16 * 1024), size_t(64 * 1024), size_t(1024 * 1024)}) {
+        double seconds = best_seconds([&] { g_sink = TreeHash::compute(data, chunk_size)[0]; });
+        std::printf("TreeHash, %4zu KiB chunks %8.1f MB/s  %5.2fx\n", chunk_size >> 10, length / seconds / 1e6,
+                    single / seconds);
+    }
+
+    TreeHash tree;
+    tree.update(data);
+    g_sink = tree.digest()[0];
+    size_t chunks = length / tree.chunk_size();
+    double seconds = best_seconds([&] {
+        for (int i = 0; i < REHASH_REPEATS; ++i) {
+            size_t index = (static_cast<size_t>(i) * 7919) % chunks;
+            data[index * tree.chunk_size()] ^= 1;
+            tree.rehash_chunks(reinterpret_cast<const uint8_t*>(data.data()), data.size(), std::span(&index, 1));
+            g_sink = tree.digest()[0];
+        }
+    });
+    std::printf("%-24s %8.1f us per changed chunk\n", "rehash_chunks + digest", seconds / REHASH_REPEATS * 1e6);
+    return 0;
+}
@@ -0,0 +1,193 @@
+// TreeHashTest.cpp - Incremental tree digests match a fresh computation.
+// TreeHash::compute is checked against a plain single-threaded Merkle tree
+// built here from CryptoHash::compute, for lengths of 0, 1, one chunk,
+// a chunk plus one byte, odd and even leaf counts, and past a streamed
+// batch. Then one tree is fed in uneven pieces with a digest taken after
+// every piece, and modified chunks (the first, a middle one, the last
+// full one and the tail) are re-read with rehash_chunks. After each step
+// digest() must equal TreeHash::compute of the bytes seen so far.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CryptoHash.h"
+#include "MemoryManager.h"
+#include "TreeHash.h"
+
+namespace {
+
+    constexpr size_t CHUNK = 1024;
+
+    std::string test_data(size_t length, uint32_t seed) {
+        std::string data(length, '\0');
+        for (size_t i = 0; i < length; ++i) data[i] = static_cast<char>(((i + seed) * 2654435761u) >> 13);
+        return data;
+    }
+
+    Digest hash_prefixed(uint8_t prefix, std::initializer_list<std::string_view> parts) {
+        CryptoHash hasher;
+        hasher.update(&prefix, 1);
+        for (std::string_view part : parts) hasher.update(part);
+        return hasher.finalize();
+    }
+
+    std::string_view view(const Digest& digest) {
+        return std::string_view(reinterpret_cast<const char*>(digest.data()), digest.size());
+    }
+
+    std::string be64(uint64_t value) {
+        std::string out(8, '\0');
+        for (int i = 0; i < 8; ++i) out[i] = static_cast<char>(value >> (56 - i * 8));
+        return out;
+    }
+
+    // The tree as TreeHash.h describes it, one node at a time
+    Digest reference_tree(std::string_view data, size_t chunk_size) {
+        std::vector<Digest> level;
+        for (size_t offset = 0; offset < data.size() || level.empty(); offset += chunk_size) {
+            Digest chunk = CryptoHash::compute(data.substr(offset, chunk_size));
+            level.push_back(hash_prefixed(0x00, {view(chunk)}));
+        }
+        while (level.size() > 1) {
+            std::vector<Digest> parents;
+            for (size_t i = 0; i + 1 < level.size(); i += 2) {
+                parents.push_back(hash_prefixed(0x01, {view(level[i]), view(level[i + 1])}));
+            }
+            if (level.size() % 2) parents.push_back(level.back());
+            level = std::move(parents);
+        }
+        return hash_prefixed(0x02, {view(level[0]), be64(data.size()), be64(chunk_size)});
+    }
+
+    // Lengths around the edges: empty, sub-chunk, exact chunks, odd leaf
+    // counts with and without a tail, and more than one streamed batch
+    const size_t LENGTHS[] = {0, 1, CHUNK - 1, CHUNK, CHUNK + 1, 2 * CHUNK, 3 * CHUNK, 5 * CHUNK + 7,
+                              7 * CHUNK, 16 * CHUNK, 17 * CHUNK + 3, 40 * CHUNK + 100};
+
+    void check_compute() {
+        for (size_t length : LENGTHS) {
+            std::string data = test_data(length, 1);
+            assert(TreeHash::compute(data, CHUNK) == reference_tree(data, CHUNK));
+        }
+        // Different chunk sizes give different digests of the same bytes
+        std::string data = test_data(4 * CHUNK, 2);
+        assert(TreeHash::compute(data, CHUNK) != TreeHash::compute(data, 2 * CHUNK));
+        assert(TreeHash::compute(data) == reference_tree(data, TreeHash::DEFAULT_CHUNK_SIZE));
+    }
+
+    void check_streamed_digests() {
+        for (size_t length : LENGTHS) {
+            std::string data = test_data(length, 3);
+            TreeHash tree(CHUNK);
+            assert(tree.digest() == TreeHash::compute("", CHUNK));
+
+            // Pieces that end inside chunks, on boundaries and past whole batches
+            const size_t pieces[] = {1, CHUNK - 1, 1, 3 * CHUNK, 700, 20 * CHUNK};
+            size_t offset = 0;
+            for (size_t i = 0; offset < data.size(); ++i) {
+                size_t take = std::min(pieces[i % std::size(pieces)], data.size() - offset);
+                tree.update(std::string_view(data).substr(offset, take));
+                offset += take;
+                assert(tree.digest() == TreeHash::compute(std::string_view(data).substr(0, offset), CHUNK));
+            }
+            assert(tree.length() == length);
+            assert(tree.digest() == reference_tree(data, CHUNK));
+
+            tree.reset();
+            tree.update(data);
+            assert(tree.digest() == reference_tree(data, CHUNK));
+        }
+    }
+
+    void check_rehash() {
+        for (size_t length : LENGTHS) {
+            if (length == 0) continue;
+            std::string data = test_data(length, 4);
+            auto bytes = [&] { return reinterpret_cast<const uint8_t*>(data.data()); };
+            TreeHash tree(CHUNK);
+            tree.update(data);
+            tree.digest();
+
+            size_t chunks = (length + CHUNK - 1) / CHUNK;
+            std::vector<size_t> changed = {0, chunks / 2, chunks - 1};
+            if (length % CHUNK != 0 && chunks > 1) changed.push_back(chunks - 2); // Last full chunk
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+            // One chunk at a time with a digest after each
+            for (size_t index : changed) {
+                data[index * CHUNK] ^= 0x5a;
+                tree.rehash_chunks(bytes(), data.size(), std::span(&index, 1));
+                assert(tree.digest() == TreeHash::compute(data, CHUNK));
+            }
+
+            // All together, then separately without a digest in between
+            for (size_t index : changed) data[index * CHUNK] ^= 0x33;
+            tree.rehash_chunks(bytes(), data.size(), changed);
+            assert(tree.digest() == TreeHash::compute(data, CHUNK));
+            for (size_t index : changed) {
+                data[index * CHUNK] ^= 0x0f;
+                tree.rehash_chunks(bytes(), data.size(), std::span(&index, 1));
+            }
+            assert(tree.digest() == reference_tree(data, CHUNK));
+
+            // Appending after a rehash keeps both in the tree
+            std::string more = test_data(CHUNK + 5, 5);
+            tree.update(more);
+            data += more;
+            assert(tree.digest() == TreeHash::compute(data, CHUNK));
+        }
+    }
+
+    void check_errors() {
+        std::string data = test_data(3 * CHUNK, 6);
+        TreeHash tree(CHUNK);
+        tree.update(data);
+
+        bool thrown = false;
+        try {
+            tree.rehash_chunks(reinterpret_cast<const uint8_t*>(data.data()), data.size() - 1, {});
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        size_t past_end = 3;
+        try {
+            tree.rehash_chunks(reinterpret_cast<const uint8_t*>(data.data()), data.size(), std::span(&past_end, 1));
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(tree.digest() == TreeHash::compute(data, CHUNK));
+
+        thrown = false;
+        try {
+            TreeHash zero(0);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+} // namespace
+
+int main() {
+    MemoryManager::getInstance().initialize(64 * 1024 * 1024);
+
+    check_compute();
+    check_streamed_digests();
+    check_rehash();
+    check_errors();
+
+    std::puts("TreeHashTest passed");
+    return 0;
+}